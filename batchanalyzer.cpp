@@ -0,0 +1,219 @@
+// Batch Analyzer - Parallel analysis of many positions, written out in input order
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "batchanalyzer.h"
+#include "gamerecord.h"
+#include "tictactoeboard.h"
+#include "src/ai/hybrid_evaluator_ai_v2.h"
+#include "src/ai/hybrid_evaluator_ai_v3.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+// One position to analyse: the moves leading to it and where it came from
+struct BatchJob {
+    long long sequence;  // Output order
+    long long line;      // 1-based input line
+    std::size_t ply;     // Moves played before the position
+    std::shared_ptr<const std::vector<Cell>> moves;  // Shared by the positions of one record
+};
+
+// Search the position and format its output row. A position where a side already has a line
+// is not searched: its row has no move and stage "game-over".
+template <typename EngineAI>
+std::string analyzeJob(EngineAI& engine, const BatchJob& job) {
+    TicTacToeBoard board;
+    const auto& moves = *job.moves;
+    for (std::size_t i = 0; i < job.ply; ++i) {
+        board.placeMarkDirect(moves[i].x(), moves[i].y(), GameRecord::moverOf(i));
+    }
+    const char side = GameRecord::moverOf(job.ply);
+    const Cell lastMove = job.ply > 0 ? moves[job.ply - 1] : Cell::none();
+
+    // Input lines need not be real games, so any stone (not only the last) may complete a line
+    for (std::size_t i = 0; i < job.ply; ++i) {
+        if (board.checkWinQuiet(moves[i].x(), moves[i].y(), engine.getWinLength())) {
+            std::ostringstream row;
+            row << job.line << '\t' << job.ply << '\t' << side << "\t-\t0\tgame-over\t0\t0.000\t\n";
+            return row.str();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const Cell move = engine.findBestMove(board, side, lastMove);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const SearchAnalysis& analysis = engine.getLastAnalysis();
+    std::ostringstream row;
+    row << job.line << '\t' << job.ply << '\t' << side << '\t' << move.x() << ',' << move.y() << '\t'
+        << analysis.score << '\t' << analysis.stage << '\t' << engine.getLastSearchStats().nodes << '\t'
+        << std::fixed << std::setprecision(3) << ms << '\t';
+    for (std::size_t i = 0; i < analysis.principalVariation.size(); ++i) {
+        const Cell cell = analysis.principalVariation[i];
+        row << (i ? " " : "") << cell.x() << ',' << cell.y();
+    }
+    row << '\n';
+    return row.str();
+}
+
+} // namespace
+
+bool BatchAnalyzer::parseLine(const std::string& line, std::vector<Cell>& moves, bool& isRecord) {
+    moves.clear();
+    isRecord = false;
+
+    std::istringstream stream(line);
+    std::string token;
+    if (!(stream >> token) || token[0] == '#') return false;
+
+    if (token == "X" || token == "O" || token == "D") {
+        isRecord = true;
+        if (!(stream >> token)) return false;
+    }
+
+    TicTacToeBoard board;  // Only to reject repeated cells
+    do {
+        int x, y;
+        char comma;
+        std::istringstream move(token);
+        if (!(move >> x >> comma >> y) || comma != ',' || board.isPositionOccupied(x, y)) return false;
+        board.placeMarkDirect(x, y, 'X');
+        moves.push_back({x, y});
+    } while (stream >> token);
+    return true;
+}
+
+bool BatchAnalyzer::run(const std::string& inputPath, const std::string& outputPath) {
+    std::ifstream input(inputPath);
+    std::ofstream output(outputPath);
+    if (!input.is_open() || !output.is_open()) return false;
+
+    lastStats = BatchStats();
+    lastStats.numThreads = numThreads;
+    lastStats.threadBusySeconds.assign(numThreads, 0.0);
+
+    std::mutex mutex;
+    std::condition_variable jobReady;    // Reader -> workers
+    std::condition_variable rowReady;    // Workers -> writer
+    std::condition_variable spaceFree;   // Writer -> reader (back-pressure)
+    std::deque<BatchJob> queue;
+    std::map<long long, std::string> reorder;  // Finished rows waiting for their turn
+    long long submitted = 0;
+    long long written = 0;
+    bool inputDone = false;
+    const long long window = static_cast<long long>(numThreads) * WINDOW_PER_THREAD;
+
+    auto work = [&](auto& engine, int threadIdx) {
+        engine.setAnalysisCache(analysisCache);
+        while (true) {
+            BatchJob job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobReady.wait(lock, [&] { return !queue.empty() || inputDone; });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            auto busyStart = std::chrono::steady_clock::now();
+            std::string row = analyzeJob(engine, job);
+            lastStats.threadBusySeconds[threadIdx] += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - busyStart).count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                reorder.emplace(job.sequence, std::move(row));
+            }
+            rowReady.notify_one();
+        }
+    };
+
+    auto worker = [&](int threadIdx) {
+        if (model == AIType::HYBRID_EVALUATOR_V2) {
+            HybridEvaluatorAIv2 engine(nullptr, depth, topN, true, false, false);
+            work(engine, threadIdx);
+        } else {
+            HybridEvaluatorAIv3 engine(nullptr, depth, topN, true, false, false);
+            work(engine, threadIdx);
+        }
+    };
+
+    // Rows leave in sequence order; the file is written outside the lock
+    auto writer = [&]() {
+        while (true) {
+            std::string row;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                rowReady.wait(lock, [&] { return reorder.count(written) || (inputDone && written == submitted); });
+                if (!reorder.count(written)) return;
+                auto it = reorder.find(written);
+                row = std::move(it->second);
+                reorder.erase(it);
+                written++;
+            }
+            spaceFree.notify_one();
+            output << row;
+        }
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    output << "# line\tply\tside\tmove\tscore\tstage\tnodes\tms\tpv\n";
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads + 1);
+    for (int t = 0; t < numThreads; ++t)
+        threads.emplace_back(worker, t);
+    threads.emplace_back(writer);
+
+    auto submit = [&](long long lineNumber, std::size_t ply, const std::shared_ptr<const std::vector<Cell>>& moves) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceFree.wait(lock, [&] { return submitted - written < window; });
+            queue.push_back({submitted++, lineNumber, ply, moves});
+        }
+        jobReady.notify_one();
+    };
+
+    std::string line;
+    std::vector<Cell> moves;
+    long long lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        bool isRecord;
+        if (!parseLine(line, moves, isRecord)) {
+            std::istringstream stream(line);
+            std::string first;
+            if (stream >> first && first[0] != '#') lastStats.skippedLines++;
+            continue;
+        }
+        auto shared = std::make_shared<const std::vector<Cell>>(moves);
+        if (isRecord && allPlies) {
+            for (std::size_t ply = 0; ply < moves.size(); ++ply) submit(lineNumber, ply, shared);
+        } else {
+            submit(lineNumber, moves.size(), shared);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inputDone = true;
+    }
+    jobReady.notify_all();
+    rowReady.notify_all();
+    for (auto& t : threads)
+        t.join();
+
+    lastStats.positions = written;
+    lastStats.wallSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    return output.good();
+}
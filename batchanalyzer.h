@@ -0,0 +1,75 @@
+// Batch Analyzer - Parallel analysis of many positions, written out in input order
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "ai_types.h"
+#include "cell.h"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AnalysisCache;
+
+// Timing collected for the most recent run
+struct BatchStats {
+    int numThreads = 0;
+    long long positions = 0;     // Positions analysed and written
+    long long skippedLines = 0;  // Input lines that were not a valid position
+    double wallSeconds = 0.0;
+    std::vector<double> threadBusySeconds;  // Time each worker spent searching
+
+    double getPositionsPerSecond() const { return wallSeconds > 0.0 ? positions / wallSeconds : 0.0; }
+};
+
+// Reads positions, one per line, and analyses them with a v2/v3 engine per worker thread.
+//
+// Input lines (blank lines and lines starting with '#' are ignored):
+//   x,y x,y ...           the moves of a position, X first
+//   W x,y x,y ...         a game record line (gamerecord.h, W = X, O or D)
+// A line is one position, the one after all its moves; with setAllPlies(true) a game record
+// line instead yields every position in which a move was played (before each of its moves).
+//
+// Output: a '#' header, then one tab-separated row per position, in input order:
+//   line  ply  side  move  score  stage  nodes  ms  pv
+// where stage and score come from SearchAnalysis (ai_utils.h) and pv is the chosen move
+// followed by the expected replies, as space-separated "x,y". A position in which a side
+// already has a line is not searched: its row has move "-", score 0 and stage "game-over".
+//
+// The reader hands positions to the workers through a queue and a writer thread restores the
+// input order from a reordering buffer. At most WINDOW_PER_THREAD positions per worker are in
+// flight, so memory stays bounded however long the input is.
+class BatchAnalyzer {
+public:
+    static constexpr int WINDOW_PER_THREAD = 64;
+
+    BatchAnalyzer(AIType model = AIType::HYBRID_EVALUATOR_V3, int depth = 2, int topN = 10)
+        : model(model), depth(depth), topN(topN),
+          numThreads(std::max(1u, std::thread::hardware_concurrency())) {}
+
+    // Worker thread count (defaults to hardware_concurrency)
+    void setNumThreads(int n) { numThreads = std::max(1, n); }
+    int getNumThreads() const { return numThreads; }
+    void setAllPlies(bool all) { allPlies = all; }
+    // Shared by all workers (nullptr: every position is searched)
+    void setAnalysisCache(AnalysisCache* cache) { analysisCache = cache; }
+
+    // Parse one input line; false for a line that holds no position (comment, blank, malformed)
+    static bool parseLine(const std::string& line, std::vector<Cell>& moves, bool& isRecord);
+
+    // Analyse every position of inputPath into outputPath; false if either cannot be opened
+    bool run(const std::string& inputPath, const std::string& outputPath);
+
+    const BatchStats& getLastStats() const { return lastStats; }
+
+private:
+    AIType model;  // HYBRID_EVALUATOR_V2 or _V3
+    int depth;
+    int topN;
+    int numThreads;
+    bool allPlies = false;
+    AnalysisCache* analysisCache = nullptr;
+    BatchStats lastStats;
+};
@@ -0,0 +1,85 @@
+// Cell - Packed 64-bit board coordinate
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+
+// A board coordinate packed into one 64-bit key: biased x in the high half, biased y in the
+// low half. The bias (flipping the sign bit) makes unsigned key order equal to the
+// lexicographic (x, y) order of std::pair<int, int>, so ordered containers iterate exactly
+// as before while comparisons, copies and hashing work on a single register.
+//
+// Supports structured bindings: auto [x, y] = cell;
+class Cell {
+public:
+    constexpr Cell() : key(pack(0, 0)) {}
+    constexpr Cell(int x, int y) : key(pack(x, y)) {}
+
+    // Sentinel for "no move" (the same value the API used to spell {INT_MIN, INT_MIN})
+    static constexpr Cell none() { return Cell(INT_MIN, INT_MIN); }
+    constexpr bool isNone() const { return key == 0; }
+
+    // Moves taken from outside (the game server, the C API) are limited to +-MAX_COORDINATE,
+    // which keeps every cell the AIs look at (a few steps past a stone) inside the int range
+    // and never packs to the none() key
+    static constexpr int MAX_COORDINATE = 1000000000;
+    static constexpr bool isPlayable(int x, int y) {
+        return x >= -MAX_COORDINATE && x <= MAX_COORDINATE && y >= -MAX_COORDINATE && y <= MAX_COORDINATE;
+    }
+
+    constexpr int x() const { return static_cast<int>(static_cast<std::uint32_t>(key >> 32) ^ SIGN); }
+    constexpr int y() const { return static_cast<int>(static_cast<std::uint32_t>(key) ^ SIGN); }
+
+    // Neighbour arithmetic: a single add on the packed key.
+    // Valid while neither coordinate overflows, which holds for any playable position.
+    constexpr Cell offset(int dx, int dy) const {
+        return fromKey(key + (static_cast<std::uint64_t>(static_cast<std::int64_t>(dx)) << 32)
+                           + static_cast<std::uint64_t>(static_cast<std::int64_t>(dy)));
+    }
+
+    constexpr std::uint64_t packed() const { return key; }
+    static constexpr Cell fromKey(std::uint64_t k) { Cell c; c.key = k; return c; }
+
+    friend constexpr bool operator==(Cell a, Cell b) { return a.key == b.key; }
+    friend constexpr bool operator!=(Cell a, Cell b) { return a.key != b.key; }
+    friend constexpr bool operator<(Cell a, Cell b) { return a.key < b.key; }
+    friend constexpr bool operator>(Cell a, Cell b) { return a.key > b.key; }
+    friend constexpr bool operator<=(Cell a, Cell b) { return a.key <= b.key; }
+    friend constexpr bool operator>=(Cell a, Cell b) { return a.key >= b.key; }
+
+    template <std::size_t I>
+    constexpr int get() const {
+        static_assert(I < 2, "Cell has two coordinates");
+        if constexpr (I == 0) return x(); else return y();
+    }
+
+private:
+    static constexpr std::uint32_t SIGN = 0x80000000u;
+    std::uint64_t key;
+
+    static constexpr std::uint64_t pack(int x, int y) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x) ^ SIGN) << 32) |
+               (static_cast<std::uint32_t>(y) ^ SIGN);
+    }
+};
+
+template <>
+struct std::tuple_size<Cell> : std::integral_constant<std::size_t, 2> {};
+
+template <std::size_t I>
+struct std::tuple_element<I, Cell> { using type = int; };
+
+// Multiplicative mix so that neighbouring cells spread across buckets
+template <>
+struct std::hash<Cell> {
+    std::size_t operator()(Cell c) const noexcept {
+        std::uint64_t h = c.packed() * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+};
@@ -0,0 +1,637 @@
+// Engine Fuzzer - Differential tests of the optimised board, evaluator and search structures
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "enginefuzzer.h"
+#include "evaluationweights.h"
+#include "tictactoeboard.h"
+#include "winrule.h"
+#include "src/ai/ai_utils.h"
+#include "src/ai/hash_board.h"
+#include "src/ai/hybrid_evaluator_ai.h"
+#include "src/ai/hybrid_evaluator_ai_v2.h"
+#include "src/ai/hybrid_evaluator_ai_v3.h"
+#include "src/ai/line_classifier.h"
+#include "src/ai/move_frontier.h"
+#include "src/ai/scratch_board.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+
+namespace {
+
+constexpr int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+constexpr CandidateShape SHAPES[] = {CandidateShape::RADIUS_1, CandidateShape::LINES_2, CandidateShape::RADIUS_2};
+
+char otherMark(char mark) { return mark == 'X' ? 'O' : 'X'; }
+
+std::string cellText(Cell cell) {
+    return std::to_string(cell.x()) + "," + std::to_string(cell.y());
+}
+
+// ---- Reference scans: the std::map board read one cell at a time ----
+
+// Length of the longest run through the stone at (x, y) reaches `length`
+bool referenceWin(const TicTacToeBoard& board, int x, int y, int length) {
+    const char mark = board.getMark(x, y);
+    if (mark == '\0') return false;
+    for (const auto& d : DIRECTIONS) {
+        int run = 1;
+        for (int k = 1; board.getMark(x + k * d[0], y + k * d[1]) == mark; ++k) ++run;
+        for (int k = 1; board.getMark(x - k * d[0], y - k * d[1]) == mark; ++k) ++run;
+        if (run >= length) return true;
+    }
+    return false;
+}
+
+struct Window {
+    int friendly = 0;
+    int opponent = 0;
+    bool openBefore = true;  // The cells just outside each end hold no opponent stone
+    bool openAfter = true;
+};
+
+Window readWindow(const TicTacToeBoard& board, int startX, int startY, int dx, int dy, int length, char mark) {
+    const char opponent = otherMark(mark);
+    Window window;
+    for (int k = 0; k < length; ++k) {
+        const char c = board.getMark(startX + k * dx, startY + k * dy);
+        if (c == mark) ++window.friendly;
+        else if (c == opponent) ++window.opponent;
+    }
+    window.openBefore = board.getMark(startX - dx, startY - dy) != opponent;
+    window.openAfter = board.getMark(startX + length * dx, startY + length * dy) != opponent;
+    return window;
+}
+
+// The v1 window tiers (see scoreLineWindows in hybrid_engine.cpp)
+int referenceWindowScore(const Window& window, int length, const EvaluationWeights& w) {
+    if (window.opponent > 0 || window.friendly < std::max(2, length - 3)) return 0;
+    const bool open = window.openBefore && window.openAfter;
+    const int empty = length - window.friendly;
+    if (window.friendly == length - 1) return open ? w.four_open : w.four_blocked;
+    if (window.friendly == length - 2 && empty == 2) return open ? w.three_open : w.three_blocked;
+    if (window.friendly == length - 3 && empty == 3 && open) return w.two_open;
+    return 0;
+}
+
+// Every window scored once, plus double_threat for two or more cells completing a line
+int referenceFullEvaluation(const TicTacToeBoard& board, char mark, int length, const EvaluationWeights& w) {
+    int score = 0;
+    std::set<Cell> winningCells;
+    for (const auto& [cell, m] : board.getOccupiedPositions()) {
+        if (m != mark) continue;
+        for (const auto& d : DIRECTIONS) {
+            for (int offset = 0; offset < length; ++offset) {
+                const int startX = cell.x() - offset * d[0], startY = cell.y() - offset * d[1];
+                // Scored from the window's first friendly stone only
+                bool earlier = false;
+                for (int k = 0; k < offset && !earlier; ++k) {
+                    earlier = board.getMark(startX + k * d[0], startY + k * d[1]) == mark;
+                }
+                if (earlier) continue;
+
+                const Window window = readWindow(board, startX, startY, d[0], d[1], length, mark);
+                score += referenceWindowScore(window, length, w);
+                if (window.opponent == 0 && window.friendly == length - 1) {
+                    for (int k = 0; k < length; ++k) {
+                        const Cell c(startX + k * d[0], startY + k * d[1]);
+                        if (!board.isPositionOccupied(c)) winningCells.insert(c);
+                    }
+                }
+            }
+        }
+    }
+    if (winningCells.size() >= 2) score += w.double_threat;
+    return score;
+}
+
+// Window scores of `mark` summed over the windows through (x, y)
+int referenceWindowsThrough(const TicTacToeBoard& board, int x, int y, char mark, int length,
+                            const EvaluationWeights& w) {
+    int score = 0;
+    for (const auto& d : DIRECTIONS) {
+        for (int offset = 0; offset < length; ++offset) {
+            score += referenceWindowScore(
+                readWindow(board, x - offset * d[0], y - offset * d[1], d[0], d[1], length, mark), length, w);
+        }
+    }
+    return score;
+}
+
+int referenceScoreDelta(TicTacToeBoard& board, Cell move, char moveMark, char evalMark, int length,
+                        const EvaluationWeights& w) {
+    const int before = referenceWindowsThrough(board, move.x(), move.y(), evalMark, length, w);
+    board.placeMarkDirect(move.x(), move.y(), moveMark);
+    const int after = referenceWindowsThrough(board, move.x(), move.y(), evalMark, length, w);
+    board.removeMarkDirect(move.x(), move.y());
+    return after - before;
+}
+
+// Open windows through (x, y) with `friendlyTarget` stones of `mark` once it is placed there
+int referenceOpenWindows(TicTacToeBoard& board, int x, int y, char mark, int length, int friendlyTarget) {
+    board.placeMarkDirect(x, y, mark);
+    int count = 0;
+    for (const auto& d : DIRECTIONS) {
+        for (int offset = 0; offset < length; ++offset) {
+            const Window window = readWindow(board, x - offset * d[0], y - offset * d[1], d[0], d[1], length, mark);
+            if (window.opponent == 0 && window.friendly == friendlyTarget && window.openBefore && window.openAfter) {
+                ++count;
+            }
+        }
+    }
+    board.removeMarkDirect(x, y);
+    return count;
+}
+
+// Every window through the cell holds stones of both players
+bool referenceDead(const TicTacToeBoard& board, Cell cell, int length) {
+    for (const auto& d : DIRECTIONS) {
+        for (int offset = 0; offset < length; ++offset) {
+            const Window window = readWindow(board, cell.x() - offset * d[0], cell.y() - offset * d[1],
+                                             d[0], d[1], length, 'X');
+            if (window.friendly == 0 || window.opponent == 0) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+EngineFuzzer::Check& EngineFuzzer::check(const char* name) {
+    for (auto& c : checks) {
+        if (std::string(c.name) == name) return c;
+    }
+    checks.push_back({name});
+    return checks.back();
+}
+
+void EngineFuzzer::expect(const char* name, bool agreed, const std::string& detail) {
+    Check& c = check(name);
+    ++c.runs;
+    if (agreed) return;
+    ++c.failures;
+    if (reported++ < MAX_REPORTED) {
+        std::cout << "FAIL " << name << ": " << detail << "\n"
+                  << "  win length " << winLength << ", moves (X first): " << describePosition() << "\n";
+    }
+}
+
+std::string EngineFuzzer::describePosition() const {
+    std::string text;
+    for (const auto& [cell, mark] : moves) {
+        if (!text.empty()) text += ' ';
+        text += cellText(cell);
+    }
+    return text;
+}
+
+// Alternate X and O, each stone within two cells of an earlier one (now and then six, so
+// separate groups form as well). In one position of six, one stone jumps thousands of cells
+// away and starts a second group, which the scratch board packs next to the first.
+void EngineFuzzer::generatePosition(TicTacToeBoard& board) {
+    moves.clear();
+    board.placeMarkDirect(0, 0, 'X');
+    moves.push_back({Cell(0, 0), 'X'});
+
+    const int count = randomInt(1, 40);
+    const int jump = randomInt(0, 5) == 0 ? randomInt(0, count - 1) : -1;
+    char mark = 'O';
+    for (int i = 0; i < count; ++i) {
+        const int reach = i == jump ? 100000 : randomInt(0, 9) == 0 ? 6 : 2;
+        for (int attempt = 0; attempt < 10; ++attempt) {
+            const Cell anchor = moves[randomInt(0, static_cast<int>(moves.size()) - 1)].first;
+            const Cell cell(anchor.x() + randomInt(-reach, reach), anchor.y() + randomInt(-reach, reach));
+            if (board.isPositionOccupied(cell)) continue;
+            board.placeMarkDirect(cell.x(), cell.y(), mark);
+            moves.push_back({cell, mark});
+            mark = otherMark(mark);
+            break;
+        }
+    }
+}
+
+std::vector<Cell> EngineFuzzer::probeCells(const TicTacToeBoard& board) const {
+    std::set<Cell> cells;
+    for (const auto& [cell, mark] : board.getOccupiedPositions()) {
+        for (int dy = -2; dy <= 2; ++dy) {
+            for (int dx = -2; dx <= 2; ++dx) {
+                const Cell c(cell.x() + dx, cell.y() + dy);
+                if (!board.isPositionOccupied(c)) cells.insert(c);
+            }
+        }
+    }
+    return {cells.begin(), cells.end()};
+}
+
+bool EngineFuzzer::run(int positions) {
+    for (int i = 0; i < positions; ++i) {
+        winLength = randomInt(WinRule<4>::LENGTH, WinRule<7>::LENGTH);
+        TicTacToeBoard board;
+        generatePosition(board);
+        withWinRule(winLength, [&](auto rule) { testPosition<decltype(rule)>(board); });
+    }
+
+    for (const auto& c : checks) {
+        if (c.failures > 0) return false;
+    }
+    return true;
+}
+
+template <typename Rule>
+void EngineFuzzer::testPosition(TicTacToeBoard& board) {
+    const std::vector<Cell> cells = probeCells(board);
+    testWinChecks<Rule>(board);
+    testClassify<Rule>(board, cells);
+    testBackends(board);
+    testGuardWalk<Rule>(board);
+    testFarClusters<Rule>();
+    testEvaluator<Rule>(board, cells);
+    testThreatScanners<Rule>(board, cells);
+    testFrontier();
+    if (board.getOccupiedPositions().size() < 24 && randomInt(0, 3) == 0) testEngineDebug(board);
+}
+
+// Friendly/opponent/empty masks of the four strips through `cell`, read cell by cell
+template <typename Rule>
+void referenceMasks(const TicTacToeBoard& board, Cell cell, char mark, LineMasks expected[4]) {
+    constexpr int N = Rule::LENGTH;
+    const char opponent = otherMark(mark);
+    for (int d = 0; d < 4; ++d) {
+        expected[d] = {};
+        for (int bit = 0; bit < LineStrips::MAX_LENGTH; ++bit) {
+            char c = '\0';  // Padding bytes read as empty (bit 15 is never set)
+            if (bit <= 2 * N) {
+                c = board.getMark(cell.x() + (bit - N) * DIRECTIONS[d][0], cell.y() + (bit - N) * DIRECTIONS[d][1]);
+            }
+            const auto flag = static_cast<std::uint16_t>(1u << bit);
+            if (c == mark) expected[d].friendly |= flag;
+            else if (c == opponent) expected[d].opponent |= flag;
+            else expected[d].empty |= flag;
+        }
+    }
+}
+
+bool sameMasks(const LineMasks a[4], const LineMasks b[4]) {
+    for (int d = 0; d < 4; ++d) {
+        if (a[d].friendly != b[d].friendly || a[d].opponent != b[d].opponent || a[d].empty != b[d].empty) return false;
+    }
+    return true;
+}
+
+// Every stone, at the position's win length (compile-time and runtime paths) and at lengths
+// outside WinRule's range (the generic runtime path)
+template <typename Rule>
+void EngineFuzzer::testWinChecks(TicTacToeBoard& board) {
+    ScratchBoard scratch;
+    scratch.loadFrom(board);
+    HashBoard hash;
+    hash.loadFrom(board);
+    for (const auto& [cell, mark] : board.getOccupiedPositions()) {
+        const int x = cell.x(), y = cell.y();
+        const bool expected = referenceWin(board, x, y, Rule::LENGTH);
+        const bool agreed = board.checkWinQuiet(x, y, Rule::LENGTH) == expected &&
+                            board.template checkWinQuiet<Rule>(x, y) == expected &&
+                            scratch.checkWinQuiet(x, y, Rule::LENGTH) == expected &&
+                            scratch.template checkWinQuiet<Rule>(x, y) == expected &&
+                            hash.checkWinQuiet(x, y, Rule::LENGTH) == expected &&
+                            hash.template checkWinQuiet<Rule>(x, y) == expected;
+        expect("checkWin", agreed, "stone " + cellText(cell) + ", expected " + (expected ? "win" : "no win"));
+
+        for (int length : {3, 8}) {
+            const bool expectedOther = referenceWin(board, x, y, length);
+            expect("checkWin", board.checkWinQuiet(x, y, length) == expectedOther &&
+                                   scratch.checkWinQuiet(x, y, length) == expectedOther &&
+                                   hash.checkWinQuiet(x, y, length) == expectedOther,
+                   "stone " + cellText(cell) + " at length " + std::to_string(length));
+        }
+    }
+}
+
+template <typename Rule>
+void EngineFuzzer::testClassify(const TicTacToeBoard& board, const std::vector<Cell>& cells) {
+    const std::string original = LineClassifier::implementationName();
+    ScratchBoard scratch;
+    scratch.loadFrom(board);
+
+    for (std::size_t i = 0; i < cells.size(); i += 3) {
+        const Cell cell = cells[i];
+        for (char mark : {'X', 'O'}) {
+            const char opponent = otherMark(mark);
+            LineMasks expected[4];
+            referenceMasks<Rule>(board, cell, mark, expected);
+
+            LineStrips strips;
+            scratch.gatherStrips<Rule>(scratch.index(cell.x(), cell.y()), strips);
+            for (const char* implementation : {"scalar", "sse2", "avx2"}) {
+                if (!LineClassifier::forceImplementation(implementation)) continue;
+                LineMasks masks[4];
+                LineClassifier::classify(strips, mark, opponent, masks);
+                expect("classify", sameMasks(masks, expected), std::string(implementation) + " at " + cellText(cell) + " for " + mark);
+            }
+        }
+    }
+    LineClassifier::forceImplementation(original);
+}
+
+// Load, then place and remove stones on the game board and both backends, some far enough
+// out to regrow the scratch board (and enough to grow the hash table)
+void EngineFuzzer::testBackends(const TicTacToeBoard& board) {
+    TicTacToeBoard reference = board;
+    ScratchBoard scratch;
+    scratch.loadFrom(reference);
+    HashBoard hash;
+    hash.loadFrom(reference);
+
+    auto compareBackend = [&](const char* name, const auto& backend, const std::string& step) {
+        bool agreed = true;
+        for (const auto& [cell, mark] : reference.getOccupiedPositions()) {
+            agreed = agreed && backend.getMark(cell.x(), cell.y()) == mark;
+        }
+        std::size_t stones = 0;
+        backend.forEachStone([&](int x, int y, char mark) {
+            ++stones;
+            agreed = agreed && reference.getMark(x, y) == mark;
+        });
+        agreed = agreed && stones == reference.getOccupiedPositions().size();
+        expect(name, agreed, step + " (" + std::to_string(stones) + " stones, game board " +
+                                 std::to_string(reference.getOccupiedPositions().size()) + ")");
+    };
+    auto compare = [&](const std::string& step) {
+        compareBackend("scratch", scratch, step);
+        compareBackend("hashBoard", hash, step);
+    };
+    compare("after loading");
+
+    std::vector<Cell> placed;
+    for (int op = 0; op < 60; ++op) {
+        if (!placed.empty() && randomInt(0, 2) == 0) {
+            const int i = randomInt(0, static_cast<int>(placed.size()) - 1);
+            const Cell cell = placed[i];
+            placed.erase(placed.begin() + i);
+            reference.removeMarkDirect(cell.x(), cell.y());
+            scratch.removeMarkDirect(cell.x(), cell.y());
+            hash.removeMarkDirect(cell.x(), cell.y());
+            compare("after removing " + cellText(cell));
+        } else {
+            const Cell cell(randomInt(-40, 40), randomInt(-40, 40));
+            if (reference.isPositionOccupied(cell)) continue;
+            const char mark = randomInt(0, 1) ? 'X' : 'O';
+            reference.placeMarkDirect(cell.x(), cell.y(), mark);
+            scratch.placeMarkDirect(cell.x(), cell.y(), mark);
+            hash.placeMarkDirect(cell.x(), cell.y(), mark);
+            placed.push_back(cell);
+            compare("after placing " + cellText(cell));
+        }
+    }
+}
+
+// From a stone on the position's edge, place stones 1 or 2 cells apart in one direction on the
+// game board and a scratch board, as a search with a wide candidate shape extends a line. The
+// scratch board regrows only when a stone comes within GUARD of its edge, so the walk passes
+// stones at every distance from the edge down to GUARD; the strips of each cell of the widest
+// shape around them must lie inside the array and read what the game board holds.
+template <typename Rule>
+void EngineFuzzer::testGuardWalk(const TicTacToeBoard& board) {
+    TicTacToeBoard reference = board;
+    ScratchBoard scratch;
+    scratch.loadFrom(reference);
+
+    const auto& direction = DIRECTIONS[randomInt(0, 3)];
+    const int sign = randomInt(0, 1) ? 1 : -1;
+    const int dx = sign * direction[0], dy = sign * direction[1];
+    // The stone furthest along the direction starts the walk
+    Cell stone = reference.getOccupiedPositions().begin()->first;
+    for (const auto& [cell, mark] : reference.getOccupiedPositions()) {
+        if (cell.x() * dx + cell.y() * dy > stone.x() * dx + stone.y() * dy) stone = cell;
+    }
+
+    char mark = moves.size() % 2 == 0 ? 'X' : 'O';
+    for (int step = 0; step < 3 * ScratchBoard::GUARD; ++step) {
+        const int length = randomInt(1, 2);
+        stone = stone.offset(length * dx, length * dy);
+        if (!scratch.reaches(stone.x(), stone.y())) break;  // Walked into the gap between packed groups
+        if (reference.isPositionOccupied(stone)) continue;
+        reference.placeMarkDirect(stone.x(), stone.y(), mark);
+        scratch.placeMarkDirect(stone.x(), stone.y(), mark);
+
+        for (const auto [ox, oy] : candidateOffsets(CandidateShape::RADIUS_2)) {
+            const Cell cell = stone.offset(ox, oy);
+            if (!scratch.reaches(cell.x(), cell.y())) continue;
+            const int center = scratch.index(cell.x(), cell.y());
+            if (!scratch.template stripsInside<Rule>(center)) {
+                expect("guardWalk", false, "strips of " + cellText(cell) + " leave the array after walking to " +
+                                               cellText(stone));
+                return;
+            }
+            LineStrips strips;
+            LineMasks masks[4], expected[4];
+            scratch.template gatherStrips<Rule>(center, strips);
+            LineClassifier::classify(strips, mark, otherMark(mark), masks);
+            referenceMasks<Rule>(reference, cell, mark, expected);
+            expect("guardWalk", sameMasks(masks, expected), cellText(cell) + " after walking to " + cellText(stone));
+        }
+        mark = otherMark(mark);
+    }
+}
+
+// Two groups of stones far apart, the last move in the near one. The far one holds N - 1 in
+// a row, blocked at one end, of the side to move (who must win there) or of the other side
+// (who must be blocked there); nothing else makes a line. Most far groups are packed next to
+// the near one; now and then the near group is strung out wider than the scratch board, which
+// then holds a window around the last move without the far group. v2, v3 and, at five in a row,
+// v1 on the dense board must play the one winning cell either way.
+template <typename Rule>
+void EngineFuzzer::testFarClusters() {
+    constexpr int N = Rule::LENGTH;
+    const char mover = randomInt(0, 1) ? 'X' : 'O';
+    const char opponent = otherMark(mover);
+    const bool moverWins = randomInt(0, 1) == 0;
+    const char owner = moverWins ? mover : opponent;
+    TicTacToeBoard board;
+
+    // Near group: stones three cells apart in alternating colours, ending with the opponent's
+    const bool strungOut = randomInt(0, 2) == 0;
+    const int count = strungOut ? 12 : randomInt(2, 6);
+    const int spacing = strungOut ? ScratchBoard::PACKED_DISTANCE - 8 : 3;
+    Cell lastMove = Cell::none();
+    for (int i = count - 1; i >= 0; --i) {
+        lastMove = Cell(-i * spacing, strungOut ? -i * spacing : randomInt(-1, 1));
+        board.placeMarkDirect(lastMove.x(), lastMove.y(), i % 2 == 0 ? opponent : mover);
+    }
+
+    // Far group: the line and the stone blocking its start
+    static constexpr int AROUND[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    const auto& away = AROUND[randomInt(0, 7)];
+    const int distance = randomInt(2000, 1000000);
+    const Cell start(away[0] * distance, away[1] * distance);
+    const auto& line = DIRECTIONS[randomInt(0, 3)];
+    board.placeMarkDirect(start.x() - line[0], start.y() - line[1], otherMark(owner));
+    for (int k = 0; k < N - 1; ++k) board.placeMarkDirect(start.x() + k * line[0], start.y() + k * line[1], owner);
+    const Cell winningCell = start.offset((N - 1) * line[0], (N - 1) * line[1]);
+
+    ScratchBoard scratch;
+    scratch.loadFrom(board, lastMove);
+    const std::string detail = std::string(moverWins ? "win" : "block") + " for " + mover + " at " +
+                               cellText(winningCell) + ", last move " + cellText(lastMove) +
+                               (scratch.isWindowed() ? " (windowed)" : " (packed)") + ", played ";
+
+    auto play = [&](AIPlayer& ai, const char* version, Cell last) {
+        const Cell move = ai.findBestMove(board, mover, last);
+        expect("farClusters", move == winningCell, detail + cellText(move) + " (" + version + ")");
+    };
+    HybridEvaluatorAIv2 v2(nullptr, 2, 6);
+    v2.setWinLength(N);
+    play(v2, "v2", lastMove);
+    HybridEvaluatorAIv3 v3(nullptr, 2, 6);
+    v3.setWinLength(N);
+    play(v3, "v3", lastMove);
+    if constexpr (N == StandardWinRule::LENGTH) {
+        // v1 follows a game move by move; a fresh one takes its moves from the whole board only
+        // when it is given no last move
+        BasicHybridEvaluatorAI<ScratchBoard> v1;
+        play(v1, "v1", Cell::none());
+    }
+}
+
+// v2 and v3 share HybridEngine; both are run in case a policy ever changes the scorers
+template <typename Rule>
+void EngineFuzzer::testEvaluator(const TicTacToeBoard& board, const std::vector<Cell>& cells) {
+    std::srand(static_cast<unsigned>(rng()));
+    const EvaluationWeights weights = EvaluationWeights().mutate(0.3);
+    TicTacToeBoard reference = board;
+
+    auto testEngine = [&](auto& engine) {
+        engine.setWinLength(Rule::LENGTH);
+        for (char mark : {'X', 'O'}) {
+            const int expected = referenceFullEvaluation(reference, mark, Rule::LENGTH, weights);
+            const int actual = engine.probeFullEvaluation(board, mark);
+            expect("fullEval", actual == expected, std::string("for ") + mark + ": " + std::to_string(actual) +
+                                                       ", expected " + std::to_string(expected));
+        }
+        for (std::size_t i = 0; i < cells.size(); i += 2) {
+            for (char moveMark : {'X', 'O'}) {
+                for (char evalMark : {'X', 'O'}) {
+                    const int expected = referenceScoreDelta(reference, cells[i], moveMark, evalMark, Rule::LENGTH, weights);
+                    const int actual = engine.probeScoreDelta(board, cells[i], moveMark, evalMark);
+                    expect("scoreDelta", actual == expected,
+                           std::string(1, moveMark) + " at " + cellText(cells[i]) + " for " + evalMark + ": " +
+                               std::to_string(actual) + ", expected " + std::to_string(expected));
+                }
+            }
+        }
+    };
+
+    HybridEvaluatorAIv2 v2(&weights);
+    HybridEvaluatorAIv3 v3(&weights);
+    testEngine(v2);
+    testEngine(v3);
+}
+
+template <typename Rule>
+void EngineFuzzer::testThreatScanners(TicTacToeBoard& board, const std::vector<Cell>& cells) {
+    constexpr int N = Rule::LENGTH;
+    ScratchBoard scratch;
+    scratch.loadFrom(board);
+    HashBoard hash;
+    hash.loadFrom(board);
+    for (const Cell cell : cells) {
+        const int x = cell.x(), y = cell.y();
+        for (char mark : {'X', 'O'}) {
+            const bool four = referenceOpenWindows(board, x, y, mark, N, N - 1) > 0;
+            expect("openFour",
+                   AIUtils::createsOpenFour<Rule>(board, x, y, mark) == four &&
+                       AIUtils::createsOpenFour<Rule>(scratch, x, y, mark) == four &&
+                       AIUtils::createsOpenFour<Rule>(hash, x, y, mark) == four,
+                   std::string(1, mark) + " at " + cellText(cell) + ", expected " + (four ? "an open four" : "none"));
+
+            const int threes = referenceOpenWindows(board, x, y, mark, N, N - 2);
+            const int onBoard = AIUtils::countOpenThreesAtPosition<Rule>(board, x, y, mark);
+            const int onScratch = AIUtils::countOpenThreesAtPosition<Rule>(scratch, x, y, mark);
+            const int onHash = AIUtils::countOpenThreesAtPosition<Rule>(hash, x, y, mark);
+            expect("openThrees", onBoard == threes && onScratch == threes && onHash == threes,
+                   std::string(1, mark) + " at " + cellText(cell) + ": " + std::to_string(onBoard) + " and " +
+                       std::to_string(onScratch) + ", expected " + std::to_string(threes));
+        }
+    }
+}
+
+// A frontier per shape follows its own random game, moves and undos, at the position's win
+// length; after every change its cells and live cells must match a scan of the board
+void EngineFuzzer::testFrontier() {
+    TicTacToeBoard board;
+    MoveFrontier frontiers[std::size(SHAPES)];
+    for (std::size_t s = 0; s < std::size(SHAPES); ++s) {
+        frontiers[s].setWindowLength(winLength);
+        frontiers[s].setShape(SHAPES[s]);
+        frontiers[s].attach(board);
+    }
+
+    auto compare = [&](const std::string& step) {
+        for (std::size_t s = 0; s < std::size(SHAPES); ++s) {
+            std::set<Cell> cells, live;
+            for (const auto& [stone, mark] : board.getOccupiedPositions()) {
+                for (const auto& offset : candidateOffsets(SHAPES[s])) {
+                    const Cell c(stone.x() + offset.dx, stone.y() + offset.dy);
+                    if (!board.isPositionOccupied(c)) cells.insert(c);
+                }
+            }
+            for (const Cell c : cells) {
+                if (!referenceDead(board, c, winLength)) live.insert(c);
+            }
+            const bool agreed = std::ranges::equal(cells, frontiers[s].cells()) &&
+                                std::ranges::equal(live, frontiers[s].liveCells());
+            expect("frontier", agreed,
+                   std::string(candidateShapeName(SHAPES[s])) + " " + step + ": " +
+                       std::to_string(frontiers[s].cells().size()) + "/" + std::to_string(frontiers[s].liveCells().size()) +
+                       " cells/live, expected " + std::to_string(cells.size()) + "/" + std::to_string(live.size()));
+        }
+    };
+
+    std::vector<Cell> stones;
+    char mark = 'X';
+    for (int op = 0; op < 30; ++op) {
+        if (!stones.empty() && randomInt(0, 3) == 0) {
+            const Cell cell = stones.back();
+            stones.pop_back();
+            board.removeMarkDirect(cell.x(), cell.y());
+            mark = otherMark(mark);
+            compare("after undoing " + cellText(cell));
+        } else {
+            Cell cell(0, 0);
+            if (!stones.empty()) {
+                const Cell anchor = stones[randomInt(0, static_cast<int>(stones.size()) - 1)];
+                cell = Cell(anchor.x() + randomInt(-2, 2), anchor.y() + randomInt(-2, 2));
+            }
+            if (board.isPositionOccupied(cell)) continue;
+            board.placeMarkDirect(cell.x(), cell.y(), mark);
+            stones.push_back(cell);
+            mark = otherMark(mark);
+            compare("after " + cellText(cell));
+        }
+    }
+}
+
+// A few v3 moves in debugMode, with a random candidate shape; the engine checks its own
+// incremental structures and counts the mismatches
+void EngineFuzzer::testEngineDebug(const TicTacToeBoard& board) {
+    TicTacToeBoard game = board;
+    HybridEvaluatorAIv3 engine(nullptr, 2, 6, true, true, false);
+    engine.setWinLength(winLength);
+    engine.setCandidateShape(SHAPES[randomInt(0, static_cast<int>(std::size(SHAPES)) - 1)]);
+
+    char mark = moves.size() % 2 == 0 ? 'X' : 'O';
+    Cell lastMove = moves.back().first;
+    for (int ply = 0; ply < 3; ++ply) {
+        const Cell move = engine.findBestMove(game, mark, lastMove);
+        const long long mismatches = engine.getLastSearchStats().debugMismatches;
+        expect("engineDebug", mismatches == 0,
+               std::to_string(mismatches) + " mismatches searching for " + mark + " at ply " + std::to_string(ply));
+        if (move == Cell::none() || game.isPositionOccupied(move)) break;
+        game.placeMarkDirect(move.x(), move.y(), mark);
+        if (game.checkWinQuiet(move.x(), move.y(), winLength)) break;
+        lastMove = move;
+        mark = otherMark(mark);
+    }
+}
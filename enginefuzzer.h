@@ -0,0 +1,80 @@
+// Engine Fuzzer - Differential tests of the optimised board, evaluator and search structures
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class TicTacToeBoard;
+
+// Generates random positions and compares every optimised path with a plain reference that
+// scans the std::map game board cell by cell (the way the AIs worked before the dense boards,
+// SIMD strips and incremental structures):
+//   checkWin       win checks of every board backend (runtime and compile-time length)
+//   classify       line strip masks, with each SIMD implementation the CPU supports
+//   scratch        ScratchBoard contents after loads, far placements (regrowth) and removals
+//   guardWalk      ScratchBoard strips around the widest candidate shape of stones walked 1-2
+//                  cells at a time toward the array's edge, as a wide-shape search steps
+//   hashBoard      HashBoard contents through the same placements and removals
+//   farClusters    v1/v2/v3 take or block the one winning cell in a group thousands of cells
+//                  from the last move, packed into the scratch board or windowed out of it
+//   fullEval       v2/v3 evaluatePositionFull
+//   scoreDelta     v2/v3 calculateScoreDelta (masks edited in place, pattern cache)
+//   openFour       AIUtils::createsOpenFour on every board backend
+//   openThrees     AIUtils::countOpenThreesAtPosition on every board backend
+//   frontier       MoveFrontier cells and live cells, for every CandidateShape, through moves
+//                  and undos
+//   engineDebug    v3 moves searched in debugMode, which checks the incremental structures of a
+//                  real search (SearchStats::debugMismatches)
+// Win lengths 4 to 7 and the evaluation weights are drawn per position. The run is
+// reproducible from its seed; failures print the position as a move list.
+class EngineFuzzer {
+public:
+    struct Check {
+        const char* name;
+        long long runs = 0;
+        long long failures = 0;
+    };
+
+    explicit EngineFuzzer(std::uint64_t seed = 1) : rng(seed) {}
+
+    // Test `positions` random positions; true when every comparison agreed
+    bool run(int positions);
+
+    const std::vector<Check>& getChecks() const { return checks; }
+    static constexpr int MAX_REPORTED = 10;  // Failures printed in full
+
+private:
+    std::mt19937_64 rng;
+    std::vector<Check> checks;
+    int reported = 0;
+
+    // Position under test, for failure reports
+    int winLength = 5;
+    std::vector<std::pair<Cell, char>> moves;
+
+    Check& check(const char* name);
+    void expect(const char* name, bool agreed, const std::string& detail);
+    std::string describePosition() const;
+
+    int randomInt(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+    void generatePosition(TicTacToeBoard& board);
+    // Empty cells within two steps of a stone (every check probes these)
+    std::vector<Cell> probeCells(const TicTacToeBoard& board) const;
+
+    template <typename Rule> void testPosition(TicTacToeBoard& board);
+    template <typename Rule> void testWinChecks(TicTacToeBoard& board);
+    template <typename Rule> void testClassify(const TicTacToeBoard& board, const std::vector<Cell>& cells);
+    void testBackends(const TicTacToeBoard& board);
+    template <typename Rule> void testGuardWalk(const TicTacToeBoard& board);
+    template <typename Rule> void testFarClusters();
+    template <typename Rule> void testEvaluator(const TicTacToeBoard& board, const std::vector<Cell>& cells);
+    template <typename Rule> void testThreatScanners(TicTacToeBoard& board, const std::vector<Cell>& cells);
+    void testFrontier();
+    void testEngineDebug(const TicTacToeBoard& board);
+};
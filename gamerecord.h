@@ -0,0 +1,61 @@
+// Game Record - Move list of a finished game, saved for offline training
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// X moves first and the players alternate, so the mover of moves[i] follows from i.
+// File format: one game per line, the winner ('X', 'O' or 'D') followed by the moves
+// as "x,y" separated by spaces.
+struct GameRecord {
+    std::vector<Cell> moves;
+    char winner = 'D';
+
+    static char moverOf(std::size_t moveIndex) { return moveIndex % 2 == 0 ? 'X' : 'O'; }
+
+    // Save a set of games, one per line
+    static bool saveToFile(const std::string& filename, const std::vector<GameRecord>& games) {
+        std::ofstream file(filename);
+        if (!file.is_open()) return false;
+
+        for (const auto& game : games) {
+            file << game.winner;
+            for (const auto& move : game.moves) {
+                file << ' ' << move.x() << ',' << move.y();
+            }
+            file << "\n";
+        }
+        return file.good();
+    }
+
+    // Load games saved by saveToFile (appends to `games`; malformed lines are skipped)
+    static bool loadFromFile(const std::string& filename, std::vector<GameRecord>& games) {
+        std::ifstream file(filename);
+        if (!file.is_open()) return false;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            GameRecord game;
+            std::string token;
+            if (!(stream >> game.winner)) continue;
+
+            bool valid = true;
+            while (stream >> token) {
+                int x, y;
+                char comma;
+                std::istringstream move(token);
+                if (!(move >> x >> comma >> y) || comma != ',') { valid = false; break; }
+                game.moves.push_back({x, y});
+            }
+            if (valid && !game.moves.empty()) games.push_back(std::move(game));
+        }
+        return true;
+    }
+};
@@ -0,0 +1,574 @@
+// Game Server - Many concurrent human-vs-AI games over a local socket
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "gameserver.h"
+#include "tictactoeboard.h"
+#include "winrule.h"
+#include "src/ai/aiplayer.h"
+#include "src/ai/smart_random_ai.h"
+#include "src/ai/hybrid_evaluator_ai.h"
+#include "src/ai/hybrid_evaluator_ai_v2.h"
+#include "src/ai/hybrid_evaluator_ai_v3.h"
+#include "src/ai/time_manager.h"
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INFINITTT_POSIX_SOCKETS 1
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#else
+#define INFINITTT_POSIX_SOCKETS 0
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int MAX_MOVES = 1000;  // A game this long is a draw
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+struct GameServer::Session {
+    int id = 0;
+    int connectionFd = -1;  // -1 once the owning connection is gone
+    TicTacToeBoard board;
+    std::unique_ptr<AIPlayer> ai;
+    // Deepening within time limits (v2/v3; empty for AIs without a search depth)
+    std::function<Cell(const TimeManager::Limits&)> timedSearch;
+    TimeManager timeManager;
+    GameClock clock;        // The AI's clock, once CLOCK has set it
+    bool clocked = false;
+    char aiMark = 'O';
+    Cell lastMove = Cell::none();
+    int moves = 0;
+    bool busy = false;     // An AI move is queued or running: the board belongs to a worker
+    bool closing = false;  // Closed while busy: dropped when the move comes back
+    bool over = false;
+};
+
+struct GameServer::Connection {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    std::vector<int> sessionIds;
+    bool broken = false;  // Closed by the peer, an error or QUIT: dropped after this poll round
+};
+
+struct GameServer::Job {
+    Session* session;  // Stays alive while busy
+    int budgetMs;      // 0: timed from the session's clock
+    Clock::time_point queuedAt;
+};
+
+struct GameServer::Completion {
+    int sessionId;
+    Cell move;
+    double ms;  // Since the move was queued
+    int depth;  // Deepest completed iteration (0 for AIs without a depth)
+};
+
+GameServer::GameServer(const Config& config) : config(config) {
+    if (this->config.maxQueued <= 0) this->config.maxQueued = 16 * std::max(1, this->config.workers);
+}
+
+#if INFINITTT_POSIX_SOCKETS
+
+namespace {
+
+bool setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;  // A vanished client must not kill the server
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+} // namespace
+
+GameServer::~GameServer() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        if (!config.unixPath.empty()) ::unlink(config.unixPath.c_str());
+    }
+    for (int fd : wakeFds) if (fd >= 0) ::close(fd);
+}
+
+bool GameServer::start() {
+    if (pipe(wakeFds) != 0 || !setNonBlocking(wakeFds[0]) || !setNonBlocking(wakeFds[1])) {
+        error = std::string("pipe: ") + std::strerror(errno);
+        return false;
+    }
+
+    if (!config.unixPath.empty()) {
+        sockaddr_un address{};
+        if (config.unixPath.size() >= sizeof(address.sun_path)) {
+            error = "Unix socket path too long";
+            return false;
+        }
+        // A socket left behind by an earlier server is replaced; any other file is not
+        struct stat st;
+        if (::stat(config.unixPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(config.unixPath.c_str());
+
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, config.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            error = config.unixPath + ": " + std::strerror(errno);
+            return false;
+        }
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Local front ends only
+        address.sin_port = htons(static_cast<std::uint16_t>(config.port));
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        const int reuse = 1;
+        if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            error = "127.0.0.1:" + std::to_string(config.port) + ": " + std::strerror(errno);
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+    }
+
+    if (listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd)) {
+        error = std::string("listen: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void GameServer::stop() {
+    stopping = true;
+    wake();
+}
+
+void GameServer::wake() {
+    const char byte = 0;
+    [[maybe_unused]] ssize_t written = ::write(wakeFds[1], &byte, 1);  // A full pipe is awake already
+}
+
+void GameServer::run() {
+    workers.reserve(config.workers);
+    for (int t = 0; t < config.workers; ++t)
+        workers.emplace_back(&GameServer::workerLoop, this);
+
+    std::vector<pollfd> fds;
+    while (!stopping) {
+        fds.clear();
+        fds.push_back({wakeFds[0], POLLIN, 0});
+        fds.push_back({listenFd, POLLIN, 0});
+        for (const auto& [fd, connection] : connections) {
+            short events = 0;
+            if (connection->output.size() < MAX_PENDING_OUTPUT) events |= POLLIN;
+            if (!connection->output.empty()) events |= POLLOUT;
+            fds.push_back({fd, events, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buffer[256];
+            while (::read(wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+            handleCompletions();
+        }
+        if (fds[1].revents & POLLIN) acceptClients();
+
+        for (std::size_t i = 2; i < fds.size(); ++i) {
+            auto it = connections.find(fds[i].fd);
+            if (it == connections.end()) continue;
+            Connection& connection = *it->second;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!readClient(connection)) connection.broken = true;
+            }
+        }
+
+        // Replies of this round leave together, so a MOVE and the END after it share a write
+        std::vector<int> broken;
+        for (const auto& [fd, connection] : connections) {
+            if (!connection->broken) flushClient(*connection);
+            if (connection->broken) broken.push_back(fd);
+        }
+        for (int fd : broken) closeConnection(fd);
+    }
+
+    // Queued moves are dropped; moves already running finish before the workers are joined
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.clear();
+        workersDone = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+
+    std::vector<int> open;
+    for (const auto& [fd, connection] : connections) open.push_back(fd);
+    for (int fd : open) closeConnection(fd);
+    sessions.clear();
+}
+
+void GameServer::acceptClients() {
+    while (true) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;  // EAGAIN: no more pending connections
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connections[fd] = std::move(connection);
+    }
+}
+
+bool GameServer::readClient(Connection& connection) {
+    char buffer[4096];
+    const ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+    if (count == 0) return false;
+    if (count < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    connection.input.append(buffer, static_cast<std::size_t>(count));
+    std::size_t start = 0, end;
+    while (!connection.broken && (end = connection.input.find('\n', start)) != std::string::npos) {
+        if (end - start > MAX_LINE) return false;
+        std::string line = connection.input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = end + 1;
+        handleLine(connection, line);
+    }
+    connection.input.erase(0, start);
+    return connection.input.size() <= MAX_LINE;
+}
+
+void GameServer::flushClient(Connection& connection) {
+    while (!connection.output.empty()) {
+        const ssize_t count = ::send(connection.fd, connection.output.data(), connection.output.size(), SEND_FLAGS);
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) connection.broken = true;
+            return;
+        }
+        connection.output.erase(0, static_cast<std::size_t>(count));
+    }
+}
+
+void GameServer::closeConnection(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    for (int id : it->second->sessionIds) closeSession(id);
+    ::close(fd);
+    connections.erase(it);
+}
+
+#else
+
+GameServer::~GameServer() = default;
+
+bool GameServer::start() {
+    error = "the game server needs POSIX sockets";
+    return false;
+}
+
+void GameServer::stop() { stopping = true; }
+void GameServer::wake() {}
+void GameServer::run() {}
+void GameServer::acceptClients() {}
+bool GameServer::readClient(Connection&) { return false; }
+void GameServer::flushClient(Connection&) {}
+void GameServer::closeConnection(int) {}
+
+#endif
+
+void GameServer::send(Connection& connection, const std::string& line) {
+    connection.output += line;
+    connection.output += '\n';
+}
+
+void GameServer::closeSession(int id) {
+    auto it = sessions.find(id);
+    if (it == sessions.end()) return;
+    it->second->connectionFd = -1;
+    if (it->second->busy) it->second->closing = true;  // The worker still holds it
+    else sessions.erase(it);
+}
+
+bool GameServer::queueAIMove(Session& session, int budgetMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (static_cast<int>(jobs.size()) + running >= config.maxQueued) {
+            rejected++;
+            return false;
+        }
+        jobs.push_back({&session, budgetMs, Clock::now()});
+    }
+    session.busy = true;
+    jobReady.notify_one();
+    return true;
+}
+
+void GameServer::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&] { return !jobs.empty() || workersDone; });
+            if (jobs.empty()) return;
+            job = jobs.front();
+            jobs.pop_front();
+            running++;
+        }
+
+        // The I/O thread leaves a busy session alone, so the board and AI are ours until the
+        // completion is handed back
+        Session& session = *job.session;
+        Cell move;
+        int depth = 0;
+        if (!session.timedSearch) {
+            move = session.ai->findBestMove(session.board, session.aiMark, session.lastMove);
+        } else {
+            TimeManager::Limits limits = job.budgetMs > 0 ? TimeManager::forBudget(job.budgetMs)
+                                                          : TimeManager::forClock(session.clock);
+            // Time spent in the queue counts against the move
+            const double waited = millisecondsSince(job.queuedAt);
+            limits.targetMs -= waited;
+            limits.maxMs -= waited;
+            move = session.timedSearch(limits);
+            depth = session.timeManager.getDepthReached();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+            completions.push_back({session.id, move, millisecondsSince(job.queuedAt), depth});
+        }
+        wake();
+    }
+}
+
+void GameServer::handleCompletions() {
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(completions);
+    }
+
+    for (const auto& completion : done) {
+        auto it = sessions.find(completion.sessionId);
+        if (it == sessions.end()) continue;
+        Session& session = *it->second;
+        session.busy = false;
+        served++;
+        if (session.closing) {
+            sessions.erase(it);
+            continue;
+        }
+
+        auto owner = connections.find(session.connectionFd);
+        if (session.clocked) {
+            session.clock.consume(completion.ms);
+            if (session.clock.flagged()) {
+                session.over = true;  // Lost on time: the move is not played
+                const char humanMark = session.aiMark == 'X' ? 'O' : 'X';
+                if (owner != connections.end()) send(*owner->second, "END " + std::to_string(session.id) + ' ' + humanMark);
+                continue;
+            }
+        }
+        if (session.board.isPositionOccupied(completion.move)) {
+            session.over = true;  // Cannot happen with the bundled AIs
+            if (owner != connections.end()) send(*owner->second, "ERR " + std::to_string(session.id) + " ai-failed");
+            continue;
+        }
+        if (owner != connections.end()) {
+            std::ostringstream reply;
+            reply << "MOVE " << session.id << ' ' << completion.move.x() << ' ' << completion.move.y() << ' '
+                  << static_cast<long long>(completion.ms) << ' ' << completion.depth;
+            send(*owner->second, reply.str());
+        }
+        finishMove(session, completion.move.x(), completion.move.y(), session.aiMark);
+    }
+}
+
+void GameServer::finishMove(Session& session, int x, int y, char mark) {
+    session.board.placeMarkDirect(x, y, mark);
+    session.lastMove = {x, y};
+    session.moves++;
+
+    char winner = 0;
+    if (session.board.checkWinQuiet(x, y, StandardWinRule::LENGTH)) winner = mark;
+    else if (session.moves >= MAX_MOVES) winner = 'D';
+    if (!winner) return;
+
+    session.over = true;
+    auto owner = connections.find(session.connectionFd);
+    if (owner != connections.end()) send(*owner->second, "END " + std::to_string(session.id) + ' ' + winner);
+}
+
+void GameServer::handleLine(Connection& connection, const std::string& line) {
+    std::istringstream stream(line);
+    std::string command;
+    if (!(stream >> command)) return;
+
+    // The caller's session with the given id, or nullptr after replying with an error
+    auto ownSession = [&](int id) -> Session* {
+        auto it = sessions.find(id);
+        if (it == sessions.end() || it->second->connectionFd != connection.fd) {
+            send(connection, "ERR unknown-session");
+            return nullptr;
+        }
+        return it->second.get();
+    };
+
+    if (command == "NEW") {
+        std::string name;
+        stream >> name;
+        std::string humanMark = "X";
+        int depth = 2, topN = 10;
+        if (stream >> humanMark) stream >> depth >> topN;
+        if ((humanMark != "X" && humanMark != "O") || depth < 1 || depth > 6 || topN < 1) {
+            send(connection, "ERR bad-arguments");
+            return;
+        }
+        if (static_cast<int>(sessions.size()) >= config.maxSessions) {
+            send(connection, "ERR too-many-sessions");
+            return;
+        }
+
+        auto session = std::make_unique<Session>();
+        session->id = nextSessionId;
+        session->connectionFd = connection.fd;
+        session->aiMark = humanMark == "X" ? 'O' : 'X';
+        if (name == "random") {
+            session->ai = std::make_unique<SmartRandomAI>(2, false);
+        } else if (name == "v1") {
+            session->ai = std::make_unique<HybridEvaluatorAI>(nullptr, false);
+        } else if (name == "v2" || name == "v3") {
+            // The time manager deepens up to the session's depth
+            Session& s = *session;
+            auto timed = [&s, depth](auto& engine) {
+                return [&s, &engine, depth](const TimeManager::Limits& limits) {
+                    return s.timeManager.search(engine, s.board, s.aiMark, s.lastMove, depth, limits);
+                };
+            };
+            if (name == "v2") {
+                auto engine = std::make_unique<HybridEvaluatorAIv2>(nullptr, depth, topN, true, false, false);
+                session->timedSearch = timed(*engine);
+                session->ai = std::move(engine);
+            } else {
+                auto engine = std::make_unique<HybridEvaluatorAIv3>(nullptr, depth, topN, true, false, false);
+                session->timedSearch = timed(*engine);
+                session->ai = std::move(engine);
+            }
+        } else {
+            send(connection, "ERR unknown-ai");
+            return;
+        }
+
+        // An AI playing X moves first, so it needs room in the queue before the session exists
+        Session& created = *session;
+        sessions[created.id] = std::move(session);
+        if (created.aiMark == 'X' && !queueAIMove(created, config.budgetMs)) {
+            sessions.erase(created.id);
+            send(connection, "BUSY");
+            return;
+        }
+        nextSessionId++;
+        connection.sessionIds.push_back(created.id);
+        send(connection, "SESSION " + std::to_string(created.id));
+    } else if (command == "PLAY") {
+        int id, x, y;
+        if (!(stream >> id >> x >> y)) {
+            send(connection, "ERR bad-arguments");
+            return;
+        }
+        int budgetMs = 0;
+        if (stream >> budgetMs && budgetMs < 1) budgetMs = 1;
+
+        Session* session = ownSession(id);
+        if (!session) return;
+        if (budgetMs == 0 && !session->clocked) budgetMs = config.budgetMs;
+        if (session->over) { send(connection, "ERR game-over"); return; }
+        if (session->busy) { send(connection, "ERR not-your-turn"); return; }
+        if (!Cell::isPlayable(x, y)) { send(connection, "ERR out-of-range"); return; }
+        if (session->board.isPositionOccupied(x, y)) { send(connection, "ERR occupied"); return; }
+
+        // Back-pressure before the move is applied, so that a retry finds the board unchanged
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (static_cast<int>(jobs.size()) + running >= config.maxQueued) {
+                rejected++;
+                send(connection, "BUSY " + std::to_string(id));
+                return;
+            }
+        }
+        finishMove(*session, x, y, session->aiMark == 'X' ? 'O' : 'X');
+        if (!session->over) queueAIMove(*session, budgetMs);
+    } else if (command == "CLOCK") {
+        int id;
+        Session* session = (stream >> id) ? ownSession(id) : nullptr;
+        if (!session) return;
+        double remainingMs, incrementMs = 0.0;
+        if (stream >> remainingMs) {
+            stream >> incrementMs;
+            if (remainingMs <= 0.0 || incrementMs < 0.0) { send(connection, "ERR bad-arguments"); return; }
+            if (session->busy) { send(connection, "ERR not-your-turn"); return; }  // A worker reads the clock
+            session->clock = {remainingMs, incrementMs};
+            session->clocked = true;
+        }
+        std::ostringstream reply;
+        reply << "CLOCK " << id << ' ' << static_cast<long long>(session->clock.remainingMs) << ' '
+              << static_cast<long long>(session->clock.incrementMs);
+        send(connection, reply.str());
+    } else if (command == "BOARD") {
+        int id;
+        Session* session = (stream >> id) ? ownSession(id) : nullptr;
+        if (!session) return;
+        std::ostringstream reply;
+        reply << "BOARD " << id << ' ' << session->board.getOccupiedPositions().size();
+        for (const auto& [cell, mark] : session->board.getOccupiedPositions()) {
+            reply << ' ' << cell.x() << ',' << cell.y() << ',' << mark;
+        }
+        send(connection, reply.str());
+    } else if (command == "CLOSE") {
+        int id;
+        Session* session = (stream >> id) ? ownSession(id) : nullptr;
+        if (!session) return;
+        auto& ids = connection.sessionIds;
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        closeSession(id);
+        send(connection, "CLOSED " + std::to_string(id));
+    } else if (command == "STATS") {
+        std::ostringstream reply;
+        std::lock_guard<std::mutex> lock(mutex);
+        reply << "STATS sessions=" << sessions.size() << " queued=" << jobs.size() << " running=" << running
+              << " served=" << served << " rejected=" << rejected;
+        send(connection, reply.str());
+    } else if (command == "QUIT") {
+        connection.broken = true;
+    } else {
+        send(connection, "ERR unknown-command");
+    }
+}
@@ -0,0 +1,117 @@
+// Game Server - Many concurrent human-vs-AI games over a local socket
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hosts games for a front end on one box: each session keeps its own TicTacToeBoard and
+// AIPlayer (whose incremental state follows the board between moves), one I/O thread
+// multiplexes every client connection with poll(), and AI moves run on a shared worker pool.
+//
+// Protocol: one command per line, replies are lines too. A connection may run any number of
+// sessions; replies to AI moves arrive asynchronously, tagged with the session id.
+//   NEW <random|v1|v2|v3> [X|O] [depth] [topn]
+//                               -> SESSION <id>   (the human plays X unless O is given;
+//                                                  an AI playing X moves at once)
+//   PLAY <id> <x> <y> [budget-ms]
+//                               -> MOVE <id> <x> <y> <ms> <depth>   (the AI's reply)
+//   CLOCK <id> [<ms> [<increment-ms>]]
+//                               -> CLOCK <id> <remaining-ms> <increment-ms>   (sets or reads
+//                                  the AI's game clock)
+//   BOARD <id>                  -> BOARD <id> <moves> <x,y,mark> ...
+//   CLOSE <id>                  -> CLOSED <id>
+//   STATS                       -> STATS sessions=.. queued=.. running=.. served=.. rejected=..
+//   QUIT                        closes the connection and its sessions
+// A finished game is announced with END <id> <X|O|D> after the deciding move.
+// Errors reply ERR <reason>. BUSY <id> (plain BUSY for NEW) means the AI move queue is full:
+// the command was not applied and can be retried (back-pressure instead of unbounded queueing).
+//
+// Time: v2/v3 moves deepen iteratively up to the session's depth under a TimeManager
+// (src/ai/time_manager.h), which spends less on forced and stable moves and more when the best
+// move changes. A move is timed from the AI's clock once CLOCK has set one, otherwise from
+// the PLAY budget or the server default; the time spent queued counts against it. A clocked
+// AI whose flag falls loses (END with the human's mark). The first iteration always runs.
+//
+// Coordinates are limited to +-Cell::MAX_COORDINATE. Only POSIX targets are supported.
+class GameServer {
+public:
+    static constexpr std::size_t MAX_LINE = 256;                 // Longer input lines drop the connection
+    static constexpr std::size_t MAX_PENDING_OUTPUT = 64 * 1024; // Stop reading from a client that does not read
+
+    struct Config {
+        std::string unixPath;  // Listen on this Unix socket if set...
+        int port = 7878;       // ...otherwise on 127.0.0.1:port (0 picks a free port)
+        int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        int maxSessions = 1024;
+        int maxQueued = 0;     // AI moves queued or running before BUSY (0: 16 per worker)
+        int budgetMs = 1000;   // Default time budget of an AI move
+    };
+
+    explicit GameServer(const Config& config);
+    ~GameServer();
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Bind and listen; false (with the reason in getError()) if the socket cannot be opened
+    bool start();
+    // Serve until stop(); starts and joins the worker pool
+    void run();
+    // Ask run() to return (safe from another thread or a signal handler)
+    void stop();
+
+    int getPort() const { return boundPort; }  // Bound TCP port (0 for a Unix socket)
+    const std::string& getError() const { return error; }
+
+private:
+    struct Session;
+    struct Connection;
+    struct Job;
+    struct Completion;
+
+    Config config;
+    std::string error;
+    int listenFd = -1;
+    int wakeFds[2] = {-1, -1};  // Self-pipe: workers and stop() wake the I/O thread
+    int boundPort = 0;
+    std::atomic<bool> stopping{false};
+
+    // I/O thread state
+    std::map<int, std::unique_ptr<Connection>> connections;  // By socket
+    std::map<int, std::unique_ptr<Session>> sessions;        // By id
+    int nextSessionId = 1;
+    long long served = 0;
+    long long rejected = 0;
+
+    // Shared with the workers
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    std::vector<Completion> completions;
+    int running = 0;
+    bool workersDone = false;
+    std::vector<std::thread> workers;
+
+    void workerLoop();
+    void wake();
+    void handleCompletions();
+    void acceptClients();
+    bool readClient(Connection& connection);
+    void flushClient(Connection& connection);
+    void handleLine(Connection& connection, const std::string& line);
+    void send(Connection& connection, const std::string& line);
+    bool queueAIMove(Session& session, int budgetMs);
+    void finishMove(Session& session, int x, int y, char mark);
+    void closeConnection(int fd);
+    void closeSession(int id);
+};
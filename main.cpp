@@ -9,15 +9,35 @@
 #include <limits>
 #include <memory>
 #include <map>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <csignal>
+#include <random>
 #include "tictactoeboard.h" // Include the TicTacToeBoard class
 #include "ai_types.h"              // Include AIType enum
 #include "src/ai/aiplayer.h"       // Include the AIPlayer class
 #include "src/ai/smart_random_ai.h" // Include SmartRandomAI
+#include "src/ai/ai_utils.h"
 #include "src/ai/hybrid_evaluator_ai.h" // Include HybridEvaluatorAI
 #include "src/ai/hybrid_evaluator_ai_v2.h"
 #include "src/ai/hybrid_evaluator_ai_v3.h"
+#include "src/ai/move_policy.h"
+#include "src/ai/nnue_evaluator.h"
+#include "src/ai/analysis_cache.h"
+#include "src/ai/time_manager.h"
+#include "src/ai/playout_kernel.h"
+#include "src/ai/line_classifier.h"
 #include "weighttrainer.h"  // Include the weight training system
+#include "batchanalyzer.h"
+#include "enginefuzzer.h"
+#include "gameserver.h"
+#include "metricsexporter.h"
 #include "evaluationweights.h"  // Include evaluation weights
+#include "gamerecord.h"
 
 enum class PlayerType {
     HUMAN,
@@ -65,7 +85,7 @@ bool readCoordinates(int& x, int& y, const std::string& prompt) {
 // Function to create AI instance based on type
 // Pass weights pointer to enable trained weights (nullptr for default weights)
 // For HYBRID_EVALUATOR_V2: depth and topN parameters can be customized
-// debugMode enables incremental evaluation verification for v2 AI
+// debugMode enables incremental structure verification for the v2/v3 AIs
 std::unique_ptr<AIPlayer> createAI(AIType type, const EvaluationWeights* weights = nullptr, bool verbose = false,
                                     int depth = 2, int topN = 10, bool debugMode = false,
                                     int smartRandomLevel = 2) {
@@ -144,7 +164,7 @@ char runSingleGame(AIType ai1Type, AIType ai2Type, bool quiet = false, bool verb
     const char player1Mark = 'X';
     const char player2Mark = 'O';
     bool isPlayer1Turn = true;
-    std::pair<int, int> lastMove = {INT_MIN, INT_MIN};  // Track opponent's last move
+    Cell lastMove = Cell::none();  // Track opponent's last move
 
     while (moveCount < maxMoves) {
         if (!quiet) {
@@ -263,7 +283,7 @@ std::pair<char, int> runSingleGameWithStats(AIType ai1Type, AIType ai2Type, bool
     const char player1Mark = 'X';
     const char player2Mark = 'O';
     bool isPlayer1Turn = true;
-    std::pair<int, int> lastMove = {INT_MIN, INT_MIN};  // Track opponent's last move
+    Cell lastMove = Cell::none();  // Track opponent's last move
 
     while (moveCount < maxMoves) {
         char currentMark = isPlayer1Turn ? player1Mark : player2Mark;
@@ -288,10 +308,53 @@ std::pair<char, int> runSingleGameWithStats(AIType ai1Type, AIType ai2Type, bool
     return {'D', moveCount};
 }
 
+// --metrics-port, --metrics-file and --metrics-interval, shared by the long-running job modes
+struct MetricsOptions {
+    MetricsExporter::Config config;
+
+    bool enabled() const { return config.port >= 0 || !config.filePath.empty(); }
+
+    // Consume argv[i] (and its value) if it is one of the flags; `error` is set for a bad value
+    bool parse(int argc, char* argv[], int& i, bool& error) {
+        std::string arg(argv[i]);
+        if (arg == "--metrics-port" && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+            if (config.port < 0 || config.port > 65535) error = true;
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            config.filePath = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            config.intervalMs = std::atoi(argv[++i]);
+            if (config.intervalMs < 100) error = true;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Start exporting `metrics` if asked to; false (after saying why) if the exporter cannot start
+    bool start(std::unique_ptr<MetricsExporter>& exporter, const JobMetrics& metrics) const {
+        if (!enabled()) return true;
+        exporter = std::make_unique<MetricsExporter>(metrics, config);
+        if (!exporter->start()) {
+            std::cerr << "Error: Could not start the metrics exporter: " << exporter->getError() << "\n";
+            return false;
+        }
+        if (config.port >= 0) std::cout << "Metrics: http://127.0.0.1:" << exporter->getPort() << "/metrics\n";
+        if (!config.filePath.empty()) std::cout << "Metrics file: " << config.filePath << "\n";
+        return true;
+    }
+};
+
 // Run benchmark comparing AI types
-void runBenchmark(int numGames, bool interactive, bool verbose = false, bool useTrainedWeights = false) {
+bool runBenchmark(int numGames, bool interactive, bool verbose = false, bool useTrainedWeights = false,
+                  const MetricsOptions& metricsOptions = MetricsOptions()) {
     std::cout << "\n=== AI Benchmark Mode ===\n";
 
+    // Games run one at a time, so the job has a single worker
+    JobMetrics metrics("benchmark", 1);
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!metricsOptions.start(exporter, metrics)) return false;
+
     // Load weights for all weight-aware AIs if requested
     std::map<AIType, std::unique_ptr<EvaluationWeights>> aiWeights;
     if (useTrainedWeights) {
@@ -337,9 +400,12 @@ void runBenchmark(int numGames, bool interactive, bool verbose = false, bool use
                 std::cout.flush();
 
                 for (int game = 0; game < numGames; game++) {
+                    metrics.beginBusy(0);
                     auto [result, moves] = runSingleGameWithStats(aiTypes[i], aiTypes[j], verbose,
                                                                    aiWeights[aiTypes[i]].get(),
                                                                    aiWeights[aiTypes[j]].get());
+                    metrics.endBusy(0);
+                    metrics.addGame(moves);
 
                     if (result == 'X') stats.xWins++;
                     else if (result == 'O') stats.oWins++;
@@ -365,7 +431,7 @@ void runBenchmark(int numGames, bool interactive, bool verbose = false, bool use
                 std::cout << "  Shortest: " << stats.shortestGame << " moves, Longest: " << stats.longestGame << " moves\n\n";
             }
         }
-        return;
+        return true;
     }
 
     // Interactive mode - single matchup
@@ -377,10 +443,13 @@ void runBenchmark(int numGames, bool interactive, bool verbose = false, bool use
     BenchmarkStats stats;
 
     for (int game = 0; game < numGames; game++) {
+        metrics.beginBusy(0);
         auto [result, moves] = runSingleGameWithStats(ai1Type, ai2Type, verbose,
                                                        aiWeights[ai1Type].get(),
                                                        aiWeights[ai2Type].get(),
                                                        ai1SmartRandomLevel, ai2SmartRandomLevel);
+        metrics.endBusy(0);
+        metrics.addGame(moves);
 
         if (result == 'X') stats.xWins++;
         else if (result == 'O') stats.oWins++;
@@ -443,6 +512,7 @@ void runBenchmark(int numGames, bool interactive, bool verbose = false, bool use
     }
 
     std::cout << std::string(50, '=') << "\n";
+    return true;
 }
 
 // Interactive game mode
@@ -553,7 +623,7 @@ void runInteractiveGame(bool verbose = false, bool useTrainedWeights = false, bo
     const char player1Mark = 'X';
     const char player2Mark = 'O';
     bool isPlayer1Turn = true;
-    std::pair<int, int> lastMove = {INT_MIN, INT_MIN};  // Track opponent's last move
+    Cell lastMove = Cell::none();  // Track opponent's last move
 
     std::cout << "\nGame Configuration:\n";
     std::cout << "Player 1 (X): ";
@@ -624,8 +694,8 @@ void runInteractiveGame(bool verbose = false, bool useTrainedWeights = false, bo
 }
 
 // Run weight training mode
-void runTraining(int generations, int populationSize, int gamesPerMatchup,
-                 AIType aiType, const std::string& outputPath) {
+bool runTraining(int generations, int populationSize, int gamesPerMatchup,
+                 AIType aiType, const std::string& outputPath, const MetricsOptions& metricsOptions) {
     std::cout << "=== AI Weight Training Mode ===\n";
     std::cout << "Training: " << getAITypeName(aiType) << "\n\n";
     std::cout << "Configuration:\n";
@@ -653,6 +723,10 @@ void runTraining(int generations, int populationSize, int gamesPerMatchup,
 
     // Create trainer and run evolution
     WeightTrainer trainer(aiType, populationSize, gamesPerMatchup, 100, 0.15);
+    JobMetrics metrics("train", trainer.getNumThreads());
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!metricsOptions.start(exporter, metrics)) return false;
+    trainer.setMetrics(&metrics);
     EvaluationWeights bestWeights = trainer.train(generations, startingWeights);
 
     // Save best weights
@@ -663,6 +737,659 @@ void runTraining(int generations, int populationSize, int gamesPerMatchup,
     }
 
     std::cout << "\nUse with: InfiniTTT_CLI --use-trained-weights\n";
+    return true;
+}
+
+// Play a self-play game between two v3 engines at the given search settings and record it
+GameRecord playRecordedGame(int depth, int topN, int maxMoves) {
+    const int winningLength = 5;
+    TicTacToeBoard board;
+    HybridEvaluatorAIv3 x(nullptr, depth, topN, true, false, false);
+    HybridEvaluatorAIv3 o(nullptr, depth, topN, true, false, false);
+    GameRecord record;
+    Cell lastMove = Cell::none();
+
+    for (int moveCount = 0; moveCount < maxMoves; ++moveCount) {
+        char currentMark = GameRecord::moverOf(moveCount);
+        AIPlayer& ai = (currentMark == 'X') ? static_cast<AIPlayer&>(x) : static_cast<AIPlayer&>(o);
+        Cell move = ai.findBestMove(board, currentMark, lastMove);
+
+        if (board.isPositionOccupied(move.x(), move.y())) break;
+        board.placeMarkDirect(move.x(), move.y(), currentMark);
+        record.moves.push_back(move);
+        lastMove = move;
+
+        if (board.checkWinQuiet(move.x(), move.y(), winningLength)) {
+            record.winner = currentMark;
+            break;
+        }
+    }
+    return record;
+}
+
+// Self-play records of the v3 search: read from recordsPath when it exists, otherwise
+// played (numGames at the given settings) and saved there if a path is given
+std::vector<GameRecord> loadOrPlaySelfPlay(int numGames, int depth, int topN, const std::string& recordsPath) {
+    std::vector<GameRecord> games;
+    if (!recordsPath.empty() && GameRecord::loadFromFile(recordsPath, games) && !games.empty()) {
+        std::cout << "Loaded " << games.size() << " games from " << recordsPath << "\n";
+        return games;
+    }
+
+    std::cout << "Self-play: " << numGames << " games of Hybrid Evaluator v3 (depth=" << depth
+              << ", topN=" << topN << ")\n";
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < numGames; ++game) {
+        games.push_back(playRecordedGame(depth, topN, 200));
+        if ((game + 1) % 10 == 0) std::cout << "." << std::flush;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nPlayed in " << std::fixed << std::setprecision(1) << seconds << "s\n";
+
+    if (!recordsPath.empty()) {
+        if (GameRecord::saveToFile(recordsPath, games)) std::cout << "Records saved to " << recordsPath << "\n";
+        else std::cout << "Error: Could not save records to " << recordsPath << "\n";
+    }
+    return games;
+}
+
+// Train the move-ordering policy on self-play records of the v3 search's choices
+void runPolicyTraining(int numGames, int depth, int topN, int epochs,
+                       const std::string& recordsPath, const std::string& outputPath) {
+    std::cout << "=== Move Policy Training ===\n";
+    std::vector<GameRecord> games = loadOrPlaySelfPlay(numGames, depth, topN, recordsPath);
+
+    MovePolicy policy;
+    MovePolicy::TrainingReport report = policy.train(games, epochs);
+
+    std::cout << "\nPositions: " << report.trainPositions << " training, "
+              << report.testPositions << " held out (last 20% of games)\n";
+    std::cout << "Held-out candidates per position: " << std::fixed << std::setprecision(1)
+              << report.averageCandidates << "\n";
+    std::cout << "Chosen move within the policy's top 1/3/5/10: " << std::setprecision(1)
+              << (100.0 * report.topK[0]) << "% / " << (100.0 * report.topK[1]) << "% / "
+              << (100.0 * report.topK[2]) << "% / " << (100.0 * report.topK[3]) << "%\n";
+    std::cout << "Shortlist keeping the chosen move 95% of the time: " << report.widthFor95 << "\n";
+
+    if (policy.saveToFile(outputPath)) {
+        std::cout << "\nPolicy saved to " << outputPath << "\n";
+    } else {
+        std::cout << "\nError: Could not save policy to " << outputPath << "\n";
+    }
+
+    std::cout << "\nUse with: InfiniTTT_CLI --sweep --policy " << outputPath
+              << " --policy-width " << std::max(1, report.widthFor95) << "\n";
+}
+
+// Export NNUE training positions from self-play records (see nnue_evaluator.h for the format)
+void runNnueExport(int numGames, int depth, int topN, const std::string& recordsPath,
+                   const std::string& outputPath) {
+    std::cout << "=== NNUE Training Data Export ===\n";
+    std::vector<GameRecord> games = loadOrPlaySelfPlay(numGames, depth, topN, recordsPath);
+
+    long long positions = NnueNetwork::exportTrainingData(games, 5, outputPath);
+    if (positions < 0) {
+        std::cout << "Error: Could not write " << outputPath << "\n";
+        return;
+    }
+    std::cout << "Wrote " << positions << " positions to " << outputPath << "\n";
+    std::cout << "\nTrain with: InfiniTTT_CLI --train-nnue " << outputPath << "\n";
+}
+
+// Fit an NNUE network to exported training data and save its quantised weights
+void runNnueTraining(const std::string& dataPath, int epochs, const std::string& outputPath) {
+    std::cout << "=== NNUE Training ===\n";
+    NnueNetwork network;
+    NnueNetwork::TrainingReport report;
+    auto start = std::chrono::steady_clock::now();
+    if (!NnueNetwork::train(dataPath, epochs, network, report)) {
+        std::cout << "Error: Could not read training data from " << dataPath << "\n";
+        return;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Positions: " << report.positions << ", epochs: " << epochs
+              << " (" << std::fixed << std::setprecision(1) << seconds << "s)\n";
+    std::cout << "Result MSE: " << std::setprecision(4) << report.initialLoss
+              << " -> " << report.finalLoss << "\n";
+
+    if (network.saveToFile(outputPath)) {
+        std::cout << "\nNetwork saved to " << outputPath << "\n";
+    } else {
+        std::cout << "\nError: Could not save network to " << outputPath << "\n";
+    }
+    std::cout << "\nUse with: InfiniTTT_CLI --sweep --nnue " << outputPath << "\n";
+}
+
+// --analysis-cache, --cache-mb and --cache-replace, shared by the modes that search positions
+struct AnalysisCacheOptions {
+    std::string path;
+    long long megabytes = 64;
+    AnalysisCache::Replacement replacement = AnalysisCache::Replacement::DEPTH_PREFERRED;
+
+    // Consume argv[i] (and its value) if it is one of the flags; `error` is set for a bad value
+    bool parse(int argc, char* argv[], int& i, bool& error) {
+        std::string arg(argv[i]);
+        if (arg == "--analysis-cache" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            megabytes = std::atoll(argv[++i]);
+            if (megabytes < 1) error = true;
+        } else if (arg == "--cache-replace" && i + 1 < argc) {
+            std::string name(argv[++i]);
+            if (name == "depth")    replacement = AnalysisCache::Replacement::DEPTH_PREFERRED;
+            else if (name == "lru") replacement = AnalysisCache::Replacement::LEAST_RECENT;
+            else { std::cerr << "Error: Unknown replacement policy '" << name << "'. Use depth or lru.\n"; error = true; }
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Open the cache if a path was given; false (after saying why) if it cannot be opened
+    bool open(AnalysisCache& cache) const {
+        if (path.empty()) return true;
+        if (cache.open(path, static_cast<std::size_t>(megabytes) << 20, replacement)) return true;
+        std::cerr << "Error: Could not open analysis cache " << path << "\n";
+        return false;
+    }
+};
+
+// Analyse a file of positions on all workers and report the throughput
+bool runBatchAnalysis(const std::string& inputPath, const std::string& outputPath, AIType model,
+                      int depth, int topN, int threads, bool allPlies, AnalysisCache* cache) {
+    BatchAnalyzer analyzer(model, depth, topN);
+    if (threads > 0) analyzer.setNumThreads(threads);
+    analyzer.setAllPlies(allPlies);
+    analyzer.setAnalysisCache(cache);
+
+    std::cout << "=== Batch Analysis ===\n";
+    std::cout << "Engine: " << getAITypeName(model) << " depth=" << depth << " topN=" << topN
+              << ", " << analyzer.getNumThreads() << " threads\n";
+
+    if (!analyzer.run(inputPath, outputPath)) {
+        std::cerr << "Error: Could not read " << inputPath << " or write " << outputPath << "\n";
+        return false;
+    }
+
+    const BatchStats& stats = analyzer.getLastStats();
+    double busy = 0.0;
+    for (double seconds : stats.threadBusySeconds) busy += seconds;
+    std::cout << "Positions: " << stats.positions << " (" << stats.skippedLines << " lines skipped)\n"
+              << std::fixed << std::setprecision(2)
+              << "Wall time: " << stats.wallSeconds << " s, " << std::setprecision(1)
+              << stats.getPositionsPerSecond() << " positions/s\n"
+              << "Worker utilisation: " << std::setprecision(1)
+              << (stats.wallSeconds > 0.0 ? 100.0 * busy / (stats.wallSeconds * stats.numThreads) : 0.0) << "%\n";
+    if (cache) {
+        const auto counters = cache->getCounters();
+        std::cout << "Analysis cache: " << counters.hits << " hits, " << counters.misses << " misses\n";
+    }
+    std::cout << "Results written to " << outputPath << "\n";
+    return true;
+}
+
+// The server being run, for the signal handler
+GameServer* activeServer = nullptr;
+
+void stopActiveServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+// Serve games until interrupted (Ctrl+C or SIGTERM)
+bool runGameServer(const GameServer::Config& config) {
+    GameServer server(config);
+    if (!server.start()) {
+        std::cerr << "Error: Could not start the game server: " << server.getError() << "\n";
+        return false;
+    }
+
+    std::cout << "=== Game Server ===\n";
+    if (config.unixPath.empty()) std::cout << "Listening on 127.0.0.1:" << server.getPort() << "\n";
+    else std::cout << "Listening on " << config.unixPath << "\n";
+    std::cout << config.workers << " workers, up to " << config.maxSessions << " sessions, "
+              << config.budgetMs << " ms per move by default. Ctrl+C to stop.\n";
+
+    activeServer = &server;
+    std::signal(SIGINT, stopActiveServer);
+    std::signal(SIGTERM, stopActiveServer);
+    server.run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    activeServer = nullptr;
+
+    std::cout << "Server stopped\n";
+    return true;
+}
+
+// Run thread-scaling benchmark: the same fixed tournament at 1, 2, 4 ... maxThreads workers
+// Speedup and efficiency are measured on move throughput, since random tie-breaking makes
+// individual game lengths vary slightly between runs
+void runThreadScalingBenchmark(int populationSize, int gamesPerMatchup, AIType aiType, int maxThreads) {
+    std::cout << "=== Thread Scaling Benchmark ===\n";
+    std::cout << "Workload: " << getAITypeName(aiType) << " tournament, "
+              << populationSize << " candidates, " << gamesPerMatchup << " games per matchup\n";
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+
+    WeightTrainer trainer(aiType, populationSize, gamesPerMatchup, 100, 0.15);
+    trainer.setShowProgress(false);
+
+    // Fixed population so every thread count plays the same matchups
+    srand(12345);
+    EvaluationWeights baseWeights;
+    std::vector<WeightCandidate> population;
+    population.push_back({baseWeights});
+    for (int i = 1; i < populationSize; ++i) {
+        population.push_back({baseWeights.mutate(0.3)});
+    }
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    std::cout << std::setw(8) << "Threads" << std::setw(10) << "Wall(s)"
+              << std::setw(12) << "Games/s" << std::setw(12) << "Moves/s"
+              << std::setw(10) << "Speedup" << std::setw(12) << "Efficiency"
+              << std::setw(14) << "AvgIdle(s)" << std::setw(14) << "MaxIdle(s)" << "\n";
+
+    double baseMovesPerSec = 0.0;
+    for (int threads : threadCounts) {
+        trainer.setNumThreads(threads);
+        trainer.runTournament(population);
+        const TournamentStats& stats = trainer.getLastTournamentStats();
+
+        double gamesPerSec = stats.gamesPlayed / stats.wallSeconds;
+        double movesPerSec = stats.movesPlayed / stats.wallSeconds;
+        if (threads == 1) baseMovesPerSec = movesPerSec;
+        double speedup = movesPerSec / baseMovesPerSec;
+        double efficiency = speedup / threads;
+
+        double totalIdle = 0.0, maxIdle = 0.0;
+        for (int t = 0; t < stats.numThreads; ++t) {
+            double idle = stats.getThreadIdleSeconds(t);
+            totalIdle += idle;
+            maxIdle = std::max(maxIdle, idle);
+        }
+
+        std::cout << std::fixed
+                  << std::setw(8) << threads
+                  << std::setw(10) << std::setprecision(2) << stats.wallSeconds
+                  << std::setw(12) << std::setprecision(1) << gamesPerSec
+                  << std::setw(12) << std::setprecision(0) << movesPerSec
+                  << std::setw(9) << std::setprecision(2) << speedup << "x"
+                  << std::setw(11) << std::setprecision(1) << (100.0 * efficiency) << "%"
+                  << std::setw(14) << std::setprecision(3) << (totalIdle / stats.numThreads)
+                  << std::setw(14) << std::setprecision(3) << maxIdle << "\n";
+    }
+
+    std::cout << "\nNo parallel search exists yet, so only the tournament workload is measured.\n";
+}
+
+// Whether either side could win with its next stone
+bool hasWinningCell(TicTacToeBoard& board, int winningLength) {
+    for (const auto& cell : AIUtils::computeAdjacentMoves(board)) {
+        for (char mark : {'X', 'O'}) {
+            board.placeMarkDirect(cell.x(), cell.y(), mark);
+            const bool wins = board.checkWinQuiet(cell.x(), cell.y(), winningLength);
+            board.removeMarkDirect(cell.x(), cell.y());
+            if (wins) return true;
+        }
+    }
+    return false;
+}
+
+// A position `plies` moves into a SmartRandomAI level 2 self-play game, with no winning cell yet
+TicTacToeBoard makeSelfPlayPosition(int plies, int winningLength) {
+    while (true) {
+        TicTacToeBoard board;
+        SmartRandomAI players[2] = {SmartRandomAI(2), SmartRandomAI(2)};
+        Cell lastMove = Cell::none();
+        bool ended = false;
+        for (int ply = 0; ply < plies && !ended; ++ply) {
+            const char mark = ply % 2 == 0 ? 'X' : 'O';
+            lastMove = players[ply % 2].findBestMove(board, mark, lastMove);
+            board.placeMarkDirect(lastMove.x(), lastMove.y(), mark);
+            ended = board.checkWinQuiet(lastMove.x(), lastMove.y(), winningLength);
+        }
+        if (!ended && !hasWinningCell(board, winningLength)) return board;
+    }
+}
+
+// Run board backend benchmark: the v1 AI instantiated on each BoardBackend
+// (src/ai/board_backend.h), timed on the same self-play positions
+void runBoardBenchmark(int numPositions) {
+    const int winningLength = 5;
+
+    std::cout << "=== Board Backend Benchmark ===\n";
+    std::cout << "HybridEvaluatorAI (v1) moves on " << numPositions << " positions per row"
+              << " (this build's AIBoard: " << boardBackendName<AIBoard>() << ")\n\n";
+    std::cout << std::setw(10) << "Position" << std::setw(10) << "Backend"
+              << std::setw(12) << "ms/move" << std::setw(10) << "Speedup" << "\n";
+
+    // Time one move per position on a fresh AI, so every call loads the position
+    auto timeBackend = [](auto tag, const std::vector<TicTacToeBoard>& positions, char toMove) {
+        using AI = BasicHybridEvaluatorAI<typename decltype(tag)::type>;
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& position : positions) {
+            AI ai;
+            ai.findBestMove(position, toMove);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+               positions.size();
+    };
+
+    for (int plies : {10, 20, 40}) {
+        std::vector<TicTacToeBoard> positions;
+        for (int i = 0; i < numPositions; ++i) positions.push_back(makeSelfPlayPosition(plies, winningLength));
+        const char toMove = plies % 2 == 0 ? 'X' : 'O';
+        const std::string label = std::to_string(plies) + " moves";
+
+        const double mapMs = timeBackend(std::type_identity<TicTacToeBoard>{}, positions, toMove);
+        const double times[] = {mapMs,
+                                timeBackend(std::type_identity<HashBoard>{}, positions, toMove),
+                                timeBackend(std::type_identity<ScratchBoard>{}, positions, toMove)};
+        const char* names[] = {boardBackendName<TicTacToeBoard>(), boardBackendName<HashBoard>(),
+                               boardBackendName<ScratchBoard>()};
+        for (int b = 0; b < 3; ++b) {
+            std::cout << std::fixed << std::setw(10) << label << std::setw(10) << names[b]
+                      << std::setw(12) << std::setprecision(3) << times[b]
+                      << std::setw(9) << std::setprecision(2) << mapMs / times[b] << "x\n";
+        }
+    }
+}
+
+// Run the differential fuzzer (enginefuzzer.h) and print a table of its checks
+bool runFuzzer(int numPositions, std::uint64_t seed) {
+    std::cout << "Fuzzing " << numPositions << " positions (seed " << seed << ", classifier "
+              << LineClassifier::implementationName() << ")...\n";
+    EngineFuzzer fuzzer(seed);
+    auto start = std::chrono::steady_clock::now();
+    const bool passed = fuzzer.run(numPositions);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n" << std::left << std::setw(14) << "Check" << std::right
+              << std::setw(12) << "Runs" << std::setw(10) << "Failures" << "\n";
+    for (const auto& check : fuzzer.getChecks()) {
+        std::cout << std::left << std::setw(14) << check.name << std::right
+                  << std::setw(12) << check.runs << std::setw(10) << check.failures << "\n";
+    }
+    std::cout << "\n" << (passed ? "All checks agreed" : "MISMATCHES FOUND") << " ("
+              << std::fixed << std::setprecision(1) << seconds << "s)\n";
+    return passed;
+}
+
+// Run playout benchmark: PlayoutKernel games against the same games played through
+// SmartRandomAI level 2 (win, block, random adjacent), from the empty board and from
+// positions 10 and 20 moves into a game. Single-threaded, so moves/s is per core.
+void runPlayoutBenchmark(int numPlayouts) {
+    const int winningLength = 5;
+    const int maxMoves = PlayoutKernel::DEFAULT_MAX_MOVES;
+    const int referenceGames = std::max(20, numPlayouts / 200);
+
+    std::cout << "=== Playout Benchmark ===\n";
+    std::cout << "Rollout policy: win, else block, else random adjacent (SmartRandomAI level 2)\n";
+    std::cout << "Kernel playouts per position: " << numPlayouts
+              << ", SmartRandomAI games per position: " << referenceGames << "\n\n";
+    std::cout << std::setw(10) << "Position" << std::setw(12) << "Engine" << std::setw(10) << "Games"
+              << std::setw(14) << "Moves/s" << std::setw(9) << "X%" << std::setw(9) << "O%"
+              << std::setw(9) << "Draw%" << std::setw(10) << "AvgLen" << "\n";
+
+    auto printRow = [](const std::string& position, const char* engine, const PlayoutKernel::Tally& tally, double seconds) {
+        std::cout << std::fixed << std::setw(10) << position << std::setw(12) << engine
+                  << std::setw(10) << tally.games
+                  << std::setw(14) << std::setprecision(0) << tally.moves / seconds
+                  << std::setw(9) << std::setprecision(1) << 100.0 * tally.wins[0] / tally.games
+                  << std::setw(9) << 100.0 * tally.wins[1] / tally.games
+                  << std::setw(9) << 100.0 * tally.draws / tally.games
+                  << std::setw(10) << static_cast<double>(tally.moves) / tally.games << "\n";
+    };
+
+    double totalSpeedup = 0.0;
+    const int plies[] = {0, 10, 20};
+    for (int ply : plies) {
+        const TicTacToeBoard position = makeSelfPlayPosition(ply, winningLength);
+        const char toMove = ply % 2 == 0 ? 'X' : 'O';
+        const std::string label = std::to_string(ply) + " moves";
+
+        PlayoutKernel kernel(std::random_device{}());
+        kernel.load<StandardWinRule>(position);
+        auto start = std::chrono::steady_clock::now();
+        const PlayoutKernel::Tally fast = kernel.run<StandardWinRule>(toMove, numPlayouts, maxMoves);
+        const double fastSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printRow(label, "kernel", fast, fastSeconds);
+
+        PlayoutKernel::Tally reference;
+        start = std::chrono::steady_clock::now();
+        for (int game = 0; game < referenceGames; ++game) {
+            TicTacToeBoard board = position;
+            SmartRandomAI players[2] = {SmartRandomAI(2), SmartRandomAI(2)};
+            Cell lastMove = Cell::none();  // Each player reads the position on its first move
+            int side = toMove == 'X' ? 0 : 1;
+            char winner = '\0';
+            int moves = 0;
+            for (; moves < maxMoves && winner == '\0'; ++moves, side = 1 - side) {
+                const char mark = side == 0 ? 'X' : 'O';
+                lastMove = players[side].findBestMove(board, mark, moves < 2 ? Cell::none() : lastMove);
+                board.placeMarkDirect(lastMove.x(), lastMove.y(), mark);
+                if (board.checkWinQuiet(lastMove.x(), lastMove.y(), winningLength)) winner = mark;
+            }
+            ++reference.games;
+            reference.moves += moves;
+            if (winner == '\0') ++reference.draws;
+            else ++reference.wins[winner == 'X' ? 0 : 1];
+        }
+        const double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printRow(label, "SmartRandom", reference, referenceSeconds);
+
+        totalSpeedup += (fast.moves / fastSeconds) / (reference.moves / referenceSeconds);
+    }
+
+    std::cout << "\nAverage kernel speedup: " << std::fixed << std::setprecision(1)
+              << totalSpeedup / std::size(plies) << "x\n";
+}
+
+// One (model, depth, topN) cell of the search-parameter sweep
+struct SweepCell {
+    AIType model;
+    int depth;
+    int topN;
+    CandidateShape shape;
+    double winRate = 0.0;     // (wins + 0.5 * draws) / games against the reference opponent
+    double avgMoveMs = 0.0;   // Average findBestMove time of the swept AI
+    double avgNodes = 0.0;    // Average minimax nodes per move of the swept AI
+    double branching = 0.0;   // Effective branching factor of its searches
+    double rootMoves = 0.0;   // Average root candidates after dead-cell pruning
+    int flagFalls = 0;        // Games the swept AI lost on time (timed sweeps only)
+    bool pareto = false;      // Not dominated in (win rate, move time)
+};
+
+// Play numGames of the swept engine against the reference opponent, alternating colours
+// policy (optional) shortlists the swept engine's candidates to policyWidth at each node;
+// network (optional) scores its leaves; cache (optional) reuses and keeps its root results;
+// beam varies its width per node; shape picks its candidate cells; with a clock (optional) the
+// swept AI plays a timed game, deepening up to `depth` under a TimeManager
+template <typename EngineAI>
+SweepCell runSweepCell(AIType model, int depth, int topN, CandidateShape shape, AIType refType, int numGames,
+                       const MovePolicy* policy, int policyWidth, const NnueNetwork* network,
+                       AnalysisCache* cache, const AdaptiveBeam& beam, const GameClock* clock) {
+    SweepCell cell{model, depth, topN, shape};
+    const int winningLength = 5;
+    const int maxMoves = 1000;
+    double points = 0.0;
+    double totalMs = 0.0;
+    long long totalNodes = 0;
+    long long totalExpanded = 0;
+    long long totalRootMoves = 0;
+    long long sweptMoves = 0;
+
+    for (int game = 0; game < numGames; ++game) {
+        TicTacToeBoard board;
+        EngineAI swept(nullptr, depth, topN, true, false, false);
+        swept.setMovePolicy(policy, policyWidth);
+        swept.setNnueNetwork(network);
+        swept.setAnalysisCache(cache);
+        swept.setAdaptiveBeam(beam);
+        swept.setCandidateShape(shape);
+        auto ref = createAI(refType);
+        TimeManager timeManager;
+        GameClock sweptClock = clock ? *clock : GameClock();
+
+        bool sweptIsX = (game % 2 == 0);
+        bool isXTurn = true;
+        Cell lastMove = Cell::none();
+        char winner = 'D';
+
+        for (int moveCount = 0; moveCount < maxMoves; ++moveCount) {
+            char currentMark = isXTurn ? 'X' : 'O';
+            bool sweptTurn = (isXTurn == sweptIsX);
+
+            Cell move;
+            if (sweptTurn) {
+                auto start = std::chrono::steady_clock::now();
+                move = clock ? timeManager.search(swept, board, currentMark, lastMove, depth,
+                                                  TimeManager::forClock(sweptClock))
+                             : swept.findBestMove(board, currentMark, lastMove);
+                const double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+                totalMs += ms;
+                totalNodes += swept.getLastSearchStats().nodes;
+                totalExpanded += swept.getLastSearchStats().expanded;
+                totalRootMoves += swept.getLastSearchStats().rootMoves;
+                sweptMoves++;
+                if (clock) {
+                    sweptClock.consume(ms);
+                    if (sweptClock.flagged()) {
+                        winner = sweptIsX ? 'O' : 'X';
+                        cell.flagFalls++;
+                        break;
+                    }
+                }
+            } else {
+                move = ref->findBestMove(board, currentMark, lastMove);
+            }
+
+            if (board.isPositionOccupied(move.x(), move.y())) break;
+            board.placeMarkDirect(move.x(), move.y(), currentMark);
+            lastMove = move;
+
+            if (board.checkWinQuiet(move.x(), move.y(), winningLength)) {
+                winner = currentMark;
+                break;
+            }
+            isXTurn = !isXTurn;
+        }
+
+        char sweptMark = sweptIsX ? 'X' : 'O';
+        if (winner == sweptMark) points += 1.0;
+        else if (winner == 'D') points += 0.5;
+    }
+
+    cell.winRate = points / numGames;
+    cell.avgMoveMs = sweptMoves ? totalMs / sweptMoves : 0.0;
+    cell.avgNodes = sweptMoves ? static_cast<double>(totalNodes) / sweptMoves : 0.0;
+    cell.branching = totalExpanded ? static_cast<double>(totalNodes) / totalExpanded : 0.0;
+    cell.rootMoves = sweptMoves ? static_cast<double>(totalRootMoves) / sweptMoves : 0.0;
+    return cell;
+}
+
+// Parse a comma-separated list of positive integers ("1,2,3")
+std::vector<int> parseIntList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int value = std::atoi(item.c_str());
+        if (value > 0) values.push_back(value);
+    }
+    return values;
+}
+
+// Sweep v2 and v3 over a searchDepth x topN x candidate shape grid against a fixed reference
+// opponent and report the Pareto frontier of strength (win rate) versus CPU cost (average move time)
+void runSearchSweep(int numGames, const std::vector<int>& depths, const std::vector<int>& topNs,
+                    const std::vector<CandidateShape>& shapes, AIType refType, const MovePolicy* policy, int policyWidth,
+                    const NnueNetwork* network, AnalysisCache* cache, const AdaptiveBeam& beam,
+                    const GameClock* clock) {
+    std::cout << "=== Search Depth/TopN Sweep ===\n";
+    std::cout << "Reference opponent: " << getAITypeName(refType) << "\n";
+    if (policy) std::cout << "Move policy: shortlist of " << policyWidth << " candidates per node\n";
+    if (network) std::cout << "Leaf evaluation: NNUE\n";
+    if (cache) std::cout << "Analysis cache: " << cache->capacity() << " entries\n";
+    if (beam.enabled()) {
+        std::cout << "Adaptive beam: margin " << beam.margin << ", at least " << beam.minWidth
+                  << " moves, limit shrinking by " << beam.shrinkPerPly << " per ply\n";
+    }
+    if (clock) {
+        std::cout << "Clock: " << clock->remainingMs << " ms + " << clock->incrementMs
+                  << " ms per move for the swept AI (depth = deepest iteration)\n";
+    }
+    std::cout << "Games per cell: " << numGames << " (colours alternate)\n\n";
+
+    std::vector<SweepCell> cells;
+    for (AIType model : {AIType::HYBRID_EVALUATOR_V2, AIType::HYBRID_EVALUATOR_V3}) {
+        for (int depth : depths) {
+            for (int topN : topNs) {
+                for (CandidateShape shape : shapes) {
+                    std::cout << getAITypeName(model) << " depth=" << depth << " topN=" << topN
+                              << " candidates=" << candidateShapeName(shape) << "..." << std::flush;
+                    SweepCell cell = (model == AIType::HYBRID_EVALUATOR_V2)
+                        ? runSweepCell<HybridEvaluatorAIv2>(model, depth, topN, shape, refType, numGames, policy, policyWidth, network, cache, beam, clock)
+                        : runSweepCell<HybridEvaluatorAIv3>(model, depth, topN, shape, refType, numGames, policy, policyWidth, network, cache, beam, clock);
+                    cells.push_back(cell);
+                    std::cout << " done\n";
+                }
+            }
+        }
+    }
+
+    // A cell is on the frontier if no other cell is at least as strong and at least as cheap
+    // while being strictly better in one of the two
+    for (auto& cell : cells) {
+        cell.pareto = std::none_of(cells.begin(), cells.end(), [&](const SweepCell& other) {
+            return other.winRate >= cell.winRate && other.avgMoveMs <= cell.avgMoveMs &&
+                   (other.winRate > cell.winRate || other.avgMoveMs < cell.avgMoveMs);
+        });
+    }
+
+    auto printRow = [](const SweepCell& cell) {
+        std::cout << std::fixed
+                  << std::setw(6) << (cell.model == AIType::HYBRID_EVALUATOR_V2 ? "v2" : "v3")
+                  << std::setw(7) << cell.depth
+                  << std::setw(6) << cell.topN
+                  << std::setw(7) << candidateShapeName(cell.shape)
+                  << std::setw(10) << std::setprecision(1) << (100.0 * cell.winRate) << "%"
+                  << std::setw(12) << std::setprecision(2) << cell.avgMoveMs
+                  << std::setw(12) << std::setprecision(0) << cell.avgNodes
+                  << std::setw(8) << std::setprecision(2) << cell.branching
+                  << std::setw(7) << std::setprecision(1) << cell.rootMoves
+                  << (cell.pareto ? "   *" : "")
+                  << (cell.flagFalls ? "   (" + std::to_string(cell.flagFalls) + " lost on time)" : "") << "\n";
+    };
+    auto printHeader = []() {
+        std::cout << std::setw(6) << "Model" << std::setw(7) << "Depth" << std::setw(6) << "TopN"
+                  << std::setw(7) << "Cands" << std::setw(11) << "WinRate" << std::setw(12) << "Move(ms)"
+                  << std::setw(12) << "Nodes/move" << std::setw(8) << "Branch" << std::setw(7) << "Root" << "\n";
+    };
+
+    std::cout << "\nAll cells (* = Pareto frontier):\n";
+    printHeader();
+    for (const auto& cell : cells) printRow(cell);
+
+    std::vector<SweepCell> frontier;
+    std::copy_if(cells.begin(), cells.end(), std::back_inserter(frontier),
+                 [](const SweepCell& cell) { return cell.pareto; });
+    std::sort(frontier.begin(), frontier.end(),
+              [](const SweepCell& a, const SweepCell& b) { return a.avgMoveMs < b.avgMoveMs; });
+
+    std::cout << "\nPareto frontier (cheapest first):\n";
+    printHeader();
+    for (const auto& cell : frontier) printRow(cell);
+
+    if (cache) {
+        const auto counters = cache->getCounters();
+        std::cout << "\nAnalysis cache: " << counters.hits << " hits, " << counters.misses
+                  << " misses, " << counters.stores << " stores\n";
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -684,7 +1411,7 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // Scan for --debug flag (enables v2 AI incremental evaluation verification)
+    // Scan for --debug flag (enables v2/v3 incremental structure verification)
     bool debugMode = false;
     for (int i = 1; i < argc; ++i) {
         if (std::string(argv[i]) == "--debug") {
@@ -710,6 +1437,76 @@ int main(int argc, char* argv[]) {
             "                             N  games per matchup  (default: 6)\n"
             "  --benchmark [N]          Interactive benchmark — pick two AIs, run N games\n"
             "  --benchmark --all [N]    Full benchmark — every AI combination, N games each\n"
+            "  --bench-threads [P] [N]  Tournament thread scaling at 1, 2, 4 ... T threads\n"
+            "                             P  population size    (default: 8)\n"
+            "                             N  games per matchup  (default: 2)\n"
+            "  --bench-playout [N]      Playout kernel vs SmartRandomAI speed, N playouts per position\n"
+            "  --bench-boards [N]       v1 AI move time on each board backend (map, hash, dense),\n"
+            "                           N positions per row (default: 50)\n"
+            "  --fuzz [N] [--seed S]    Check the optimised engine paths against reference scans on N\n"
+            "                           random positions (default: 200); exit status 1 on a mismatch\n"
+            "  --sweep [N]              Sweep v2/v3 over depth x topN, N games per cell (default: 10)\n"
+            "                           and print the win-rate vs move-time Pareto frontier\n"
+            "  --train-policy [G]       Train the move-ordering policy on G self-play games (default: 100)\n"
+            "  --export-nnue-data <file> [G]\n"
+            "                           Write NNUE training positions from G self-play games (default: 100)\n"
+            "  --train-nnue <file>      Train an NNUE network on exported positions\n"
+            "  --analyze-batch <in> <out>\n"
+            "                           Analyse every position of <in> in parallel, rows in input order\n"
+            "  --server                 Serve concurrent games to local clients (protocol: gameserver.h)\n"
+            "\n"
+            "BENCH-THREADS OPTIONS\n"
+            "  --model v1|v2            Model playing the tournament (default: v2)\n"
+            "  --max-threads <T>        Largest thread count (default: hardware threads)\n"
+            "\n"
+            "SWEEP OPTIONS\n"
+            "  --depths <list>          Search depths to try (default: 1,2,3)\n"
+            "  --topn <list>            TopN values to try (default: 3,5,10,15,20)\n"
+            "  --candidates <list>      Candidate shapes to try: r1 (8 neighbours), lines (2 steps\n"
+            "                           along the 4 lines), r2 (5x5 square) (default: r1)\n"
+            "  --opponent v1|random     Fixed reference opponent (default: v1)\n"
+            "  --policy <file>          Shortlist candidates with a trained move policy\n"
+            "  --policy-width <W>       Candidates the policy keeps per node (default: 8)\n"
+            "  --nnue <file>            Score search leaves with a trained NNUE network\n"
+            "  --analysis-cache <file>  Reuse and keep search results in an on-disk cache\n"
+            "  --cache-mb <MB>          Largest cache file size (default: 64)\n"
+            "  --cache-replace depth|lru  Entry kept when a bucket is full (default: depth)\n"
+            "  --beam-margin <M>        Adaptive width: search the moves scoring within M of a\n"
+            "                           node's best (default: off, topN everywhere)\n"
+            "  --beam-min <W>           Fewest moves an adaptive node keeps (default: 2)\n"
+            "  --beam-shrink <S>        Width limit lost per ply below the root (default: 2)\n"
+            "  --clock <ms>             Play the swept AI on a game clock, deepening up to each depth\n"
+            "  --increment <ms>         Time added to the clock after each move (default: 0)\n"
+            "\n"
+            "TRAIN-POLICY OPTIONS\n"
+            "  --depth <D>              Search depth of the self-play engine (default: 3)\n"
+            "  --topn <N>               TopN of the self-play engine (default: 10)\n"
+            "  --epochs <E>             Passes over the training positions (default: 10)\n"
+            "  --records <file>         Read game records from file, or save the self-play there\n"
+            "  --output <file>          Save the policy here (default: move_policy.txt)\n"
+            "\n"
+            "EXPORT-NNUE-DATA OPTIONS\n"
+            "  --depth, --topn, --records  As for --train-policy\n"
+            "\n"
+            "TRAIN-NNUE OPTIONS\n"
+            "  --epochs <E>             Passes over the positions (default: 20)\n"
+            "  --output <file>          Save the network here (default: nnue.bin)\n"
+            "\n"
+            "ANALYZE-BATCH OPTIONS\n"
+            "  --model v2|v3            Analysing engine (default: v3)\n"
+            "  --depth <D>              Search depth (default: 2)\n"
+            "  --topn <N>               TopN (default: 10)\n"
+            "  --threads <T>            Worker threads (default: hardware threads)\n"
+            "  --all-plies              Analyse every position of each game record line\n"
+            "  --analysis-cache <file>  As for --sweep (also --cache-mb, --cache-replace)\n"
+            "\n"
+            "SERVER OPTIONS\n"
+            "  --port <P>               Listen on 127.0.0.1:P (default: 7878)\n"
+            "  --unix <path>            Listen on a Unix socket instead\n"
+            "  --workers <T>            AI worker threads (default: hardware threads)\n"
+            "  --max-sessions <N>       Open games allowed at once (default: 1024)\n"
+            "  --max-queued <Q>         AI moves waiting or running before BUSY (default: 16 per worker)\n"
+            "  --budget-ms <B>          Default time budget of an AI move (default: 1000)\n"
             "\n"
             "TRAIN OPTIONS\n"
             "  --model v1|v2|v3         Model to train (default: v1)\n"
@@ -718,12 +1515,17 @@ int main(int argc, char* argv[]) {
             "                             v3  Hybrid Evaluator v3 → hybrid_evaluator_v3_weights.txt\n"
             "  --output <file>          Save weights to a custom path instead of the default\n"
             "\n"
+            "TRAIN AND BENCHMARK OPTIONS\n"
+            "  --metrics-port <P>       Serve live metrics (Prometheus text) on http://127.0.0.1:P/metrics\n"
+            "  --metrics-file <file>    Rewrite live metrics to a file\n"
+            "  --metrics-interval <ms>  Refresh period of the metrics and their rates (default: 5000)\n"
+            "\n"
             "OPTIONS\n"
             "  --use-trained-weights    Load weights from hybrid_evaluator_weights.txt,\n"
             "                           hybrid_evaluator_v2_weights.txt, and\n"
             "                           hybrid_evaluator_v3_weights.txt\n"
             "  --verbose                Print AI move evaluations during play\n"
-            "  --debug                  Verify v2 incremental eval matches full eval (slow)\n"
+            "  --debug                  Verify v2/v3 incremental structures against recomputation (slow)\n"
             "  -h, --help               Show this help\n"
             "\n"
             "AI TYPES\n"
@@ -738,6 +1540,22 @@ int main(int argc, char* argv[]) {
             "  InfiniTTT_CLI --train 20 30 10\n"
             "  InfiniTTT_CLI --train 20 30 10 --model v2\n"
             "  InfiniTTT_CLI --train 10 20 6 --output /tmp/my_weights.txt\n"
+            "  InfiniTTT_CLI --train 50 30 10 --metrics-port 9100\n"
+            "  InfiniTTT_CLI --bench-threads 8 2 --max-threads 16\n"
+            "  InfiniTTT_CLI --bench-playout 200000\n"
+            "  InfiniTTT_CLI --bench-boards 100\n"
+            "  InfiniTTT_CLI --fuzz 1000 --seed 7\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 1,2 --topn 5,10\n"
+            "  InfiniTTT_CLI --train-policy 200 --records selfplay.txt\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 3 --topn 5 --policy move_policy.txt\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 3 --analysis-cache analysis.bin\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 3,4 --topn 10 --beam-margin 100\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 2,3 --topn 10 --candidates r1,lines,r2\n"
+            "  InfiniTTT_CLI --sweep 20 --depths 6 --topn 10 --clock 2000 --increment 50\n"
+            "  InfiniTTT_CLI --export-nnue-data selfplay.bin 500 --records selfplay.txt\n"
+            "  InfiniTTT_CLI --train-nnue selfplay.bin --output nnue.bin\n"
+            "  InfiniTTT_CLI --analyze-batch selfplay.txt labels.tsv --all-plies --depth 3\n"
+            "  InfiniTTT_CLI --server --port 7878 --workers 4 --budget-ms 500\n"
             "  InfiniTTT_CLI --verbose --use-trained-weights\n";
         return 0;
     }
@@ -749,12 +1567,16 @@ int main(int argc, char* argv[]) {
         int gamesPerMatchup = 6;
         AIType trainAIType = AIType::HYBRID_EVALUATOR;
         std::string outputPath;
+        MetricsOptions metricsOptions;
+        bool badMetrics = false;
 
         // Parse positional args (G P N) and named flags mixed together
         int positional = 0;
         for (int i = 2; i < argc; ++i) {
             std::string arg(argv[i]);
-            if (arg == "--model" && i + 1 < argc) {
+            if (metricsOptions.parse(argc, argv, i, badMetrics)) {
+                continue;
+            } else if (arg == "--model" && i + 1 < argc) {
                 std::string model(argv[++i]);
                 if (model == "v2")      trainAIType = AIType::HYBRID_EVALUATOR_V2;
                 else if (model == "v3") trainAIType = AIType::HYBRID_EVALUATOR_V3;
@@ -771,12 +1593,359 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        if (generations < 1 || populationSize < 2 || gamesPerMatchup < 1) {
+        if (generations < 1 || populationSize < 2 || gamesPerMatchup < 1 || badMetrics) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        return runTraining(generations, populationSize, gamesPerMatchup, trainAIType, outputPath,
+                           metricsOptions) ? 0 : 1;
+    }
+
+    // Check for thread-scaling benchmark mode
+    if (argc > 1 && std::string(argv[1]) == "--bench-threads") {
+        int populationSize = 8;
+        int gamesPerMatchup = 2;
+        int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        AIType benchAIType = AIType::HYBRID_EVALUATOR_V2;
+
+        int positional = 0;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--model" && i + 1 < argc) {
+                std::string model(argv[++i]);
+                if (model == "v2")      benchAIType = AIType::HYBRID_EVALUATOR_V2;
+                else if (model == "v1") benchAIType = AIType::HYBRID_EVALUATOR;
+                else { std::cerr << "Error: Unknown model '" << model << "'. Use v1 or v2.\n"; return 1; }
+            } else if (arg == "--max-threads" && i + 1 < argc) {
+                maxThreads = std::atoi(argv[++i]);
+            } else if (!arg.empty() && arg[0] != '-') {
+                switch (positional++) {
+                    case 0: populationSize  = std::atoi(argv[i]); break;
+                    case 1: gamesPerMatchup = std::atoi(argv[i]); break;
+                }
+            }
+        }
+
+        if (populationSize < 2 || gamesPerMatchup < 1 || maxThreads < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runThreadScalingBenchmark(populationSize, gamesPerMatchup, benchAIType, maxThreads);
+        return 0;
+    }
+
+    // Check for playout benchmark mode
+    if (argc > 1 && std::string(argv[1]) == "--bench-playout") {
+        int numPlayouts = 100000;
+        if (argc > 2) numPlayouts = std::atoi(argv[2]);
+
+        if (numPlayouts < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runPlayoutBenchmark(numPlayouts);
+        return 0;
+    }
+
+    // Check for board backend benchmark mode
+    if (argc > 1 && std::string(argv[1]) == "--bench-boards") {
+        int numPositions = 50;
+        if (argc > 2) numPositions = std::atoi(argv[2]);
+
+        if (numPositions < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runBoardBenchmark(numPositions);
+        return 0;
+    }
+
+    // Check for differential fuzzing mode
+    if (argc > 1 && std::string(argv[1]) == "--fuzz") {
+        int numPositions = 200;
+        std::uint64_t seed = 1;
+        bool badValue = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--seed" && i + 1 < argc) {
+                seed = std::strtoull(argv[++i], nullptr, 10);
+            } else if (arg[0] != '-') {
+                numPositions = std::atoi(argv[i]);
+            } else {
+                badValue = true;
+            }
+        }
+
+        if (numPositions < 1 || badValue) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        return runFuzzer(numPositions, seed) ? 0 : 1;
+    }
+
+    // Check for search-parameter sweep mode
+    if (argc > 1 && std::string(argv[1]) == "--sweep") {
+        int numGames = 10;
+        std::vector<int> depths = {1, 2, 3};
+        std::vector<int> topNs = {3, 5, 10, 15, 20};
+        std::vector<CandidateShape> shapes = {CandidateShape::RADIUS_1};
+        AIType refType = AIType::HYBRID_EVALUATOR;
+        std::string policyPath;
+        int policyWidth = 8;
+        std::string nnuePath;
+        AnalysisCacheOptions cacheOptions;
+        AdaptiveBeam beam;
+        GameClock clock;
+        bool badValue = false;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--depths" && i + 1 < argc) {
+                depths = parseIntList(argv[++i]);
+            } else if (arg == "--topn" && i + 1 < argc) {
+                topNs = parseIntList(argv[++i]);
+            } else if (arg == "--candidates" && i + 1 < argc) {
+                shapes.clear();
+                std::stringstream stream(argv[++i]);
+                std::string name;
+                while (std::getline(stream, name, ',')) {
+                    CandidateShape shape;
+                    if (!parseCandidateShape(name, shape)) {
+                        std::cerr << "Error: Unknown candidate shape '" << name << "'. Use r1, lines or r2.\n";
+                        return 1;
+                    }
+                    shapes.push_back(shape);
+                }
+            } else if (arg == "--opponent" && i + 1 < argc) {
+                std::string opponent(argv[++i]);
+                if (opponent == "v1")          refType = AIType::HYBRID_EVALUATOR;
+                else if (opponent == "random") refType = AIType::SMART_RANDOM;
+                else { std::cerr << "Error: Unknown opponent '" << opponent << "'. Use v1 or random.\n"; return 1; }
+            } else if (arg == "--policy" && i + 1 < argc) {
+                policyPath = argv[++i];
+            } else if (arg == "--policy-width" && i + 1 < argc) {
+                policyWidth = std::atoi(argv[++i]);
+            } else if (arg == "--nnue" && i + 1 < argc) {
+                nnuePath = argv[++i];
+            } else if (arg == "--beam-margin" && i + 1 < argc) {
+                beam.margin = std::atoi(argv[++i]);
+                if (beam.margin < 1) badValue = true;
+            } else if (arg == "--beam-min" && i + 1 < argc) {
+                beam.minWidth = std::atoi(argv[++i]);
+                if (beam.minWidth < 1) badValue = true;
+            } else if (arg == "--clock" && i + 1 < argc) {
+                clock.remainingMs = std::atof(argv[++i]);
+                if (clock.remainingMs <= 0.0) badValue = true;
+            } else if (arg == "--increment" && i + 1 < argc) {
+                clock.incrementMs = std::atof(argv[++i]);
+                if (clock.incrementMs < 0.0) badValue = true;
+            } else if (arg == "--beam-shrink" && i + 1 < argc) {
+                beam.shrinkPerPly = std::atoi(argv[++i]);
+                if (beam.shrinkPerPly < 0) badValue = true;
+            } else if (cacheOptions.parse(argc, argv, i, badValue)) {
+                continue;
+            } else if (!arg.empty() && arg[0] != '-') {
+                numGames = std::atoi(argv[i]);
+            }
+        }
+
+        if (numGames < 1 || depths.empty() || topNs.empty() || shapes.empty() || policyWidth < 1 || badValue) {
             std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
             return 1;
         }
 
-        runTraining(generations, populationSize, gamesPerMatchup, trainAIType, outputPath);
+        MovePolicy policy;
+        if (!policyPath.empty() && !policy.loadFromFile(policyPath)) {
+            std::cerr << "Error: Could not load move policy from " << policyPath << "\n";
+            return 1;
+        }
+
+        NnueNetwork network;
+        if (!nnuePath.empty() && !network.loadFromFile(nnuePath)) {
+            std::cerr << "Error: Could not load NNUE network from " << nnuePath << "\n";
+            return 1;
+        }
+
+        AnalysisCache cache;
+        if (!cacheOptions.open(cache)) return 1;
+
+        runSearchSweep(numGames, depths, topNs, shapes, refType, policyPath.empty() ? nullptr : &policy, policyWidth,
+                       nnuePath.empty() ? nullptr : &network, cache.isOpen() ? &cache : nullptr, beam,
+                       clock.remainingMs > 0.0 ? &clock : nullptr);
+        return 0;
+    }
+
+    // Check for batch analysis mode
+    if (argc > 3 && std::string(argv[1]) == "--analyze-batch") {
+        std::string inputPath(argv[2]);
+        std::string outputPath(argv[3]);
+        AIType model = AIType::HYBRID_EVALUATOR_V3;
+        int depth = 2;
+        int topN = 10;
+        int threads = 0;
+        bool allPlies = false;
+        AnalysisCacheOptions cacheOptions;
+        bool badValue = false;
+
+        for (int i = 4; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--model" && i + 1 < argc) {
+                std::string name(argv[++i]);
+                if (name == "v2")      model = AIType::HYBRID_EVALUATOR_V2;
+                else if (name == "v3") model = AIType::HYBRID_EVALUATOR_V3;
+                else { std::cerr << "Error: Unknown model '" << name << "'. Use v2 or v3.\n"; return 1; }
+            } else if (arg == "--depth" && i + 1 < argc) {
+                depth = std::atoi(argv[++i]);
+            } else if (arg == "--topn" && i + 1 < argc) {
+                topN = std::atoi(argv[++i]);
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+                if (threads < 1) badValue = true;
+            } else if (arg == "--all-plies") {
+                allPlies = true;
+            } else {
+                cacheOptions.parse(argc, argv, i, badValue);
+            }
+        }
+
+        if (depth < 1 || topN < 1 || badValue) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        AnalysisCache cache;
+        if (!cacheOptions.open(cache)) return 1;
+
+        return runBatchAnalysis(inputPath, outputPath, model, depth, topN, threads, allPlies,
+                                cache.isOpen() ? &cache : nullptr) ? 0 : 1;
+    }
+
+    // Check for game server mode
+    if (argc > 1 && std::string(argv[1]) == "--server") {
+        GameServer::Config config;
+        bool badValue = false;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--port" && i + 1 < argc) {
+                config.port = std::atoi(argv[++i]);
+                if (config.port < 0 || config.port > 65535) badValue = true;
+            } else if (arg == "--unix" && i + 1 < argc) {
+                config.unixPath = argv[++i];
+            } else if (arg == "--workers" && i + 1 < argc) {
+                config.workers = std::atoi(argv[++i]);
+                if (config.workers < 1) badValue = true;
+            } else if (arg == "--max-sessions" && i + 1 < argc) {
+                config.maxSessions = std::atoi(argv[++i]);
+                if (config.maxSessions < 1) badValue = true;
+            } else if (arg == "--max-queued" && i + 1 < argc) {
+                config.maxQueued = std::atoi(argv[++i]);
+                if (config.maxQueued < 1) badValue = true;
+            } else if (arg == "--budget-ms" && i + 1 < argc) {
+                config.budgetMs = std::atoi(argv[++i]);
+                if (config.budgetMs < 1) badValue = true;
+            }
+        }
+
+        if (badValue) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        return runGameServer(config) ? 0 : 1;
+    }
+
+    // Check for move policy training mode
+    if (argc > 1 && std::string(argv[1]) == "--train-policy") {
+        int numGames = 100;
+        int depth = 3;
+        int topN = 10;
+        int epochs = 10;
+        std::string recordsPath;
+        std::string outputPath = "move_policy.txt";
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--depth" && i + 1 < argc) {
+                depth = std::atoi(argv[++i]);
+            } else if (arg == "--topn" && i + 1 < argc) {
+                topN = std::atoi(argv[++i]);
+            } else if (arg == "--epochs" && i + 1 < argc) {
+                epochs = std::atoi(argv[++i]);
+            } else if (arg == "--records" && i + 1 < argc) {
+                recordsPath = argv[++i];
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else if (!arg.empty() && arg[0] != '-') {
+                numGames = std::atoi(argv[i]);
+            }
+        }
+
+        if (numGames < 1 || depth < 1 || topN < 1 || epochs < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runPolicyTraining(numGames, depth, topN, epochs, recordsPath, outputPath);
+        return 0;
+    }
+
+    // Check for NNUE training data export mode
+    if (argc > 2 && std::string(argv[1]) == "--export-nnue-data") {
+        std::string outputPath = argv[2];
+        int numGames = 100;
+        int depth = 3;
+        int topN = 10;
+        std::string recordsPath;
+
+        for (int i = 3; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--depth" && i + 1 < argc) {
+                depth = std::atoi(argv[++i]);
+            } else if (arg == "--topn" && i + 1 < argc) {
+                topN = std::atoi(argv[++i]);
+            } else if (arg == "--records" && i + 1 < argc) {
+                recordsPath = argv[++i];
+            } else if (!arg.empty() && arg[0] != '-') {
+                numGames = std::atoi(argv[i]);
+            }
+        }
+
+        if (numGames < 1 || depth < 1 || topN < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runNnueExport(numGames, depth, topN, recordsPath, outputPath);
+        return 0;
+    }
+
+    // Check for NNUE training mode
+    if (argc > 2 && std::string(argv[1]) == "--train-nnue") {
+        std::string dataPath = argv[2];
+        int epochs = 20;
+        std::string outputPath = "nnue.bin";
+
+        for (int i = 3; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--epochs" && i + 1 < argc) {
+                epochs = std::atoi(argv[++i]);
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            }
+        }
+
+        if (epochs < 1) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
+        }
+
+        runNnueTraining(dataPath, epochs, outputPath);
         return 0;
     }
 
@@ -784,20 +1953,25 @@ int main(int argc, char* argv[]) {
     if (argc > 1 && std::string(argv[1]) == "--benchmark") {
         int numGames = 50;  // Default
         bool interactive = true;  // Default to interactive
+        MetricsOptions metricsOptions;
+        bool badMetrics = false;
 
-        if (argc > 2) {
-            if (std::string(argv[2]) == "--all") {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (metricsOptions.parse(argc, argv, i, badMetrics)) continue;
+            if (arg == "--all") {
                 interactive = false;
-            } else {
-                numGames = std::atoi(argv[2]);
+            } else if (!arg.empty() && arg[0] != '-') {
+                numGames = std::atoi(argv[i]);
             }
         }
 
-        if (argc > 3) {
-            numGames = std::atoi(argv[3]);
+        if (badMetrics) {
+            std::cerr << "Error: Invalid parameters. Use --help for usage.\n";
+            return 1;
         }
 
-        runBenchmark(numGames, interactive, verboseAI, useTrainedWeights);
+        if (!runBenchmark(numGames, interactive, verboseAI, useTrainedWeights, metricsOptions)) return 1;
     } else {
         runInteractiveGame(verboseAI, useTrainedWeights, debugMode);
     }
@@ -0,0 +1,333 @@
+// Metrics Exporter - Live throughput of long-running training and match jobs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "metricsexporter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INFINITTT_POSIX_SOCKETS 1
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#define INFINITTT_POSIX_SOCKETS 0
+#endif
+
+namespace {
+
+constexpr std::size_t MAX_REQUEST = 4096;  // Bytes of the request read before answering
+constexpr int CLIENT_DEADLINE_MS = 1000;    // Whole exchange with one client, request and response
+
+// Process resident set size, 0 where /proc is not available
+long long residentBytes() {
+#if INFINITTT_POSIX_SOCKETS
+    std::ifstream statm("/proc/self/statm");
+    long long size = 0, resident = 0;
+    if (statm >> size >> resident) return resident * sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+} // namespace
+
+JobMetrics::JobMetrics(const std::string& jobName, int threadCount)
+    : job(jobName), threads(std::max(1, threadCount)),
+      busyState(std::make_unique<std::atomic<long long>[]>(threads)) {
+    for (int t = 0; t < threads; ++t) busyState[t] = 0;
+}
+
+long long JobMetrics::nanosSinceStart() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count();
+}
+
+void JobMetrics::addGame(long long gameMoves) {
+    games.fetch_add(1, std::memory_order_relaxed);
+    moves.fetch_add(gameMoves, std::memory_order_relaxed);
+    lastGameNanos.store(nanosSinceStart(), std::memory_order_relaxed);
+}
+
+void JobMetrics::beginBusy(int thread) {
+    const long long busy = busyState[thread].load(std::memory_order_relaxed) / 2;
+    busyState[thread].store(2 * (busy - nanosSinceStart()) + 1, std::memory_order_relaxed);
+}
+
+void JobMetrics::endBusy(int thread) {
+    const long long sinceStart = (busyState[thread].load(std::memory_order_relaxed) - 1) / 2;
+    busyState[thread].store(2 * (sinceStart + nanosSinceStart()), std::memory_order_relaxed);
+}
+
+void JobMetrics::addArena(std::size_t overflowBytes, std::size_t overflowAllocations, std::size_t capacity) {
+    arenaOverflowBytes.fetch_add(static_cast<long long>(overflowBytes), std::memory_order_relaxed);
+    arenaOverflowAllocations.fetch_add(static_cast<long long>(overflowAllocations), std::memory_order_relaxed);
+    long long seen = arenaCapacity.load(std::memory_order_relaxed);
+    while (static_cast<long long>(capacity) > seen &&
+           !arenaCapacity.compare_exchange_weak(seen, static_cast<long long>(capacity), std::memory_order_relaxed)) {}
+}
+
+void JobMetrics::setGeneration(int current, int total) {
+    generation.store(current, std::memory_order_relaxed);
+    generations.store(total, std::memory_order_relaxed);
+}
+
+void JobMetrics::setBestFitness(double fitness) {
+    bestFitness.store(fitness, std::memory_order_relaxed);
+}
+
+double JobMetrics::getBusySeconds(int thread) const {
+    const long long state = busyState[thread].load(std::memory_order_relaxed);
+    const long long nanos = (state & 1) ? (state - 1) / 2 + nanosSinceStart() : state / 2;
+    return nanos / 1e9;
+}
+
+MetricsExporter::MetricsExporter(const JobMetrics& jobMetrics, const Config& exporterConfig)
+    : metrics(jobMetrics), config(exporterConfig) {
+    config.intervalMs = std::max(100, config.intervalMs);
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+#if INFINITTT_POSIX_SOCKETS
+    if (listenFd >= 0) ::close(listenFd);
+    for (int fd : wakeFds) if (fd >= 0) ::close(fd);
+#endif
+}
+
+MetricsExporter::Sample MetricsExporter::takeSample() const {
+    Sample sample;
+    sample.seconds = std::chrono::duration<double>(JobMetrics::Clock::now() - metrics.started).count();
+    sample.games = metrics.getGames();
+    sample.moves = metrics.getMoves();
+    sample.busy = std::make_unique<double[]>(metrics.threads);
+    for (int t = 0; t < metrics.threads; ++t) sample.busy[t] = metrics.getBusySeconds(t);
+    return sample;
+}
+
+std::string MetricsExporter::render() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return text;
+}
+
+// Take a sample and rebuild the exposition text; rates cover the time since the last refresh
+void MetricsExporter::refresh() {
+    Sample sample = takeSample();
+    const std::string label = "job=\"" + metrics.job + "\"";
+
+    std::ostringstream out;
+    auto metric = [&](const char* name, const char* type, const char* help, auto value,
+                      const std::string& extraLabel = "") {
+        out << "# HELP infinittt_" << name << " " << help << "\n"
+            << "# TYPE infinittt_" << name << " " << type << "\n"
+            << "infinittt_" << name << "{" << label << extraLabel << "} " << value << "\n";
+    };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    previous = std::move(latest);
+    latest = std::move(sample);
+    const double elapsed = latest.seconds - previous.seconds;
+    const bool haveRates = previous.busy && elapsed > 0.0;
+
+    metric("uptime_seconds", "gauge", "Seconds since the job started", latest.seconds);
+    metric("games_total", "counter", "Games finished", latest.games);
+    metric("moves_total", "counter", "Moves played in finished games", latest.moves);
+    metric("games_per_second", "gauge", "Games finished per second over the last interval",
+           haveRates ? (latest.games - previous.games) / elapsed : 0.0);
+    metric("moves_per_second", "gauge", "Moves played per second over the last interval",
+           haveRates ? (latest.moves - previous.moves) / elapsed : 0.0);
+    metric("average_game_length", "gauge", "Average moves per finished game",
+           latest.games ? static_cast<double>(latest.moves) / latest.games : 0.0);
+    const long long lastGame = metrics.lastGameNanos.load(std::memory_order_relaxed);
+    metric("seconds_since_last_game", "gauge", "Seconds since a game last finished (the uptime before the first)",
+           latest.seconds - (latest.games ? lastGame / 1e9 : 0.0));
+
+    out << "# HELP infinittt_thread_busy_seconds_total Seconds each worker spent playing games, the current one included\n"
+        << "# TYPE infinittt_thread_busy_seconds_total counter\n";
+    for (int t = 0; t < metrics.threads; ++t) {
+        out << "infinittt_thread_busy_seconds_total{" << label << ",thread=\"" << t << "\"} " << latest.busy[t] << "\n";
+    }
+    out << "# HELP infinittt_thread_busy_ratio Share of the last interval each worker spent playing games\n"
+        << "# TYPE infinittt_thread_busy_ratio gauge\n";
+    for (int t = 0; t < metrics.threads; ++t) {
+        const double ratio = haveRates ? std::clamp((latest.busy[t] - previous.busy[t]) / elapsed, 0.0, 1.0) : 0.0;
+        out << "infinittt_thread_busy_ratio{" << label << ",thread=\"" << t << "\"} " << ratio << "\n";
+    }
+
+    if (const int generations = metrics.generations.load(std::memory_order_relaxed); generations > 0) {
+        metric("generation", "gauge", "Current training generation (1-based)",
+               metrics.generation.load(std::memory_order_relaxed));
+        metric("generations", "gauge", "Training generations in the run", generations);
+        metric("best_fitness", "gauge", "Best fitness found so far",
+               metrics.bestFitness.load(std::memory_order_relaxed));
+    }
+
+    metric("arena_overflow_bytes_total", "counter", "Bytes v2/v3 search arenas took from the heap",
+           metrics.arenaOverflowBytes.load(std::memory_order_relaxed));
+    metric("arena_overflow_allocations_total", "counter", "Heap allocations made by v2/v3 search arenas",
+           metrics.arenaOverflowAllocations.load(std::memory_order_relaxed));
+    metric("arena_capacity_bytes", "gauge", "Largest v2/v3 search arena buffer",
+           metrics.arenaCapacity.load(std::memory_order_relaxed));
+    if (const long long resident = residentBytes(); resident > 0) {
+        metric("resident_bytes", "gauge", "Resident memory of the process", resident);
+    }
+
+    text = out.str();
+}
+
+void MetricsExporter::writeFile() {
+    if (config.filePath.empty()) return;
+    const std::string temporary = config.filePath + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << render();
+        if (!file) return;
+    }
+    std::rename(temporary.c_str(), config.filePath.c_str());
+}
+
+#if INFINITTT_POSIX_SOCKETS
+
+bool MetricsExporter::start() {
+    refresh();
+    if (config.port >= 0) {
+        if (pipe(wakeFds) != 0) {
+            error = std::string("pipe: ") + std::strerror(errno);
+            return false;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Local scrapers only
+        address.sin_port = htons(static_cast<std::uint16_t>(config.port));
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        const int reuse = 1;
+        if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd, SOMAXCONN) != 0) {
+            error = "127.0.0.1:" + std::to_string(config.port) + ": " + std::strerror(errno);
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+    } else if (pipe(wakeFds) != 0) {
+        error = std::string("pipe: ") + std::strerror(errno);
+        return false;
+    }
+    writeFile();
+    thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!thread.joinable()) return;
+    stopping = true;
+    const char byte = 0;
+    [[maybe_unused]] ssize_t written = ::write(wakeFds[1], &byte, 1);
+    thread.join();
+    refresh();
+    writeFile();
+}
+
+void MetricsExporter::run() {
+    auto nextRefresh = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.intervalMs);
+    while (!stopping) {
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            nextRefresh - std::chrono::steady_clock::now()).count();
+        pollfd fds[2] = {{wakeFds[0], POLLIN, 0}, {listenFd, POLLIN, 0}};
+        const int ready = poll(fds, listenFd >= 0 ? 2 : 1, static_cast<int>(std::max<long long>(0, wait)));
+        if (ready < 0 && errno != EINTR) break;
+        if (ready > 0 && (fds[1].revents & POLLIN)) serveClient();
+
+        if (std::chrono::steady_clock::now() >= nextRefresh) {
+            refresh();
+            writeFile();
+            nextRefresh += std::chrono::milliseconds(config.intervalMs);
+        }
+    }
+}
+
+// Answer one connection with the current text. Requests are not parsed: any GET returns the
+// metrics. The socket is non-blocking and every wait polls against one deadline for the
+// whole exchange, so a client trickling bytes cannot hold up the refreshes for longer than
+// CLIENT_DEADLINE_MS.
+void MetricsExporter::serveClient() {
+    const int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CLIENT_DEADLINE_MS);
+    auto waitFor = [&](short events) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        pollfd pfd{fd, events, 0};
+        return left > 0 && poll(&pfd, 1, static_cast<int>(left)) > 0;
+    };
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos &&
+           request.size() < MAX_REQUEST && waitFor(POLLIN)) {
+        const ssize_t count = ::read(fd, buffer, sizeof(buffer));
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+        if (count <= 0) break;
+        request.append(buffer, static_cast<std::size_t>(count));
+    }
+
+    const std::string body = render();
+    const std::string response = "HTTP/1.0 200 OK\r\n"
+                                 "Content-Type: text/plain; version=0.0.4\r\n"
+                                 "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                 "Connection: close\r\n\r\n" + body;
+    std::size_t sent = 0;
+    while (sent < response.size() && waitFor(POLLOUT)) {
+        const ssize_t count = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+        if (count <= 0) break;
+        sent += static_cast<std::size_t>(count);
+    }
+    ::close(fd);
+}
+
+#else
+
+bool MetricsExporter::start() {
+    if (config.port >= 0) {
+        error = "the metrics endpoint needs POSIX sockets (use a metrics file)";
+        return false;
+    }
+    refresh();
+    writeFile();
+    thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!thread.joinable()) return;
+    stopping = true;
+    thread.join();
+    refresh();
+    writeFile();
+}
+
+void MetricsExporter::run() {
+    auto nextRefresh = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.intervalMs);
+    while (!stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() >= nextRefresh) {
+            refresh();
+            writeFile();
+            nextRefresh += std::chrono::milliseconds(config.intervalMs);
+        }
+    }
+}
+
+void MetricsExporter::serveClient() {}
+
+#endif
@@ -0,0 +1,121 @@
+// Metrics Exporter - Live throughput of long-running training and match jobs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Counters of a job, updated by its worker threads as games finish (lock-free) and read by
+// MetricsExporter. Thread indices run from 0 to threads - 1. Busy time is credited as it
+// accrues: a game running between beginBusy() and endBusy() counts up to the moment it is read.
+class JobMetrics {
+public:
+    JobMetrics(const std::string& job, int threads);
+
+    void addGame(long long moves);
+    // Only the thread itself may call these for its index
+    void beginBusy(int thread);
+    void endBusy(int thread);
+    // Search arena use of a finished v2/v3 AI (SearchArena): heap spills and buffer size
+    void addArena(std::size_t overflowBytes, std::size_t overflowAllocations, std::size_t capacity);
+    void setGeneration(int generation, int generations);
+    void setBestFitness(double fitness);
+
+    const std::string& getJob() const { return job; }
+    int getThreads() const { return threads; }
+    long long getGames() const { return games.load(std::memory_order_relaxed); }
+    long long getMoves() const { return moves.load(std::memory_order_relaxed); }
+    double getBusySeconds(int thread) const;
+
+private:
+    friend class MetricsExporter;
+    using Clock = std::chrono::steady_clock;
+
+    std::string job;
+    int threads;
+    Clock::time_point started = Clock::now();
+    std::atomic<long long> games{0};
+    std::atomic<long long> moves{0};
+    std::atomic<long long> lastGameNanos{0};  // Since `started`
+    // Per thread: 2 * busy nanoseconds, or 2 * (busy nanoseconds - game start) + 1 during a
+    // game, so that one load reads both and the total never steps back
+    std::unique_ptr<std::atomic<long long>[]> busyState;
+    std::atomic<int> generation{0};
+    std::atomic<int> generations{0};
+    std::atomic<double> bestFitness{0.0};
+    std::atomic<long long> arenaOverflowBytes{0};
+    std::atomic<long long> arenaOverflowAllocations{0};
+    std::atomic<long long> arenaCapacity{0};  // Largest buffer seen
+
+    long long nanosSinceStart() const;
+};
+
+// Publishes a JobMetrics in the Prometheus text format, refreshed every interval:
+//   - over HTTP on 127.0.0.1:port (GET any path; a plain local socket, one request per
+//     connection, dropped if not done within a second), for a Prometheus scraper or curl
+//   - and/or by rewriting a file (written aside and renamed, so readers never see half of it)
+// Rates (games/s, moves/s, per-thread busy %) cover the last interval, so a stalled job shows
+// up as zero within one interval; totals are exported as counters as well. Resident memory
+// is read from /proc where available.
+//
+// One background thread serves and refreshes; the job only touches the JobMetrics atomics.
+// Only POSIX targets serve HTTP; the file works everywhere.
+class MetricsExporter {
+public:
+    struct Config {
+        int port = -1;          // Serve on 127.0.0.1:port if >= 0 (0 picks a free port)
+        std::string filePath;   // Rewrite this file if set
+        int intervalMs = 5000;  // Refresh period of the rates and the file
+    };
+
+    MetricsExporter(const JobMetrics& metrics, const Config& config);
+    ~MetricsExporter();
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Bind the socket and start the thread; false (with the reason in getError()) on failure
+    bool start();
+    // Write a last refresh and stop the thread (also done by the destructor)
+    void stop();
+
+    int getPort() const { return boundPort; }
+    const std::string& getError() const { return error; }
+
+    // The current exposition text
+    std::string render();
+
+private:
+    struct Sample {
+        double seconds = 0.0;  // Since the job started
+        long long games = 0;
+        long long moves = 0;
+        std::unique_ptr<double[]> busy;  // Busy seconds per thread
+    };
+
+    const JobMetrics& metrics;
+    Config config;
+    std::string error;
+    int listenFd = -1;
+    int wakeFds[2] = {-1, -1};  // Self-pipe: stop() wakes the thread
+    int boundPort = 0;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    std::mutex mutex;     // Guards the samples and the rendered text
+    Sample previous;      // The two latest refreshes: rates are their difference
+    Sample latest;
+    std::string text;
+
+    void run();
+    void refresh();
+    void writeFile();
+    void serveClient();
+    Sample takeSample() const;
+};
@@ -14,7 +14,16 @@ Popup {
 
     // Emitted when user taps Start Game
     signal gameStarted(bool p1Human, int p1AI, int p1Lvl,
-                       bool p2Human, int p2AI, int p2Lvl)
+                       bool p2Human, int p2AI, int p2Lvl,
+                       int clockSeconds, int incrementSeconds)
+
+    // AI clock choices: [label, seconds, increment seconds]; untimed AIs search a fixed depth
+    readonly property var clockOptions: [
+        ["Untimed (fixed depth)", 0, 0],
+        ["1 min + 1 s per move", 60, 1],
+        ["3 min + 2 s per move", 180, 2],
+        ["10 min + 5 s per move", 600, 5]
+    ]
 
     property bool gameActive: false
 
@@ -27,6 +36,7 @@ Popup {
         property int p2Type:  1
         property int p2AI:    3
         property int p2Level: 2
+        property int clock:   0
     }
 
     background: Rectangle {
@@ -90,6 +100,21 @@ Popup {
                     levelIndex: saved.p2Level
                 }
 
+                Rectangle { Layout.fillWidth: true; height: 1; color: "#e0e0e0" }
+
+                RowLayout {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 16; Layout.rightMargin: 16
+                    Label { text: "AI clock:"; font.pixelSize: 13; Layout.preferredWidth: 56 }
+                    ComboBox {
+                        id: clockCombo
+                        Layout.fillWidth: true
+                        model: root.clockOptions.map(option => option[0])
+                        currentIndex: saved.clock
+                        font.pixelSize: 13
+                    }
+                }
+
                 Item { height: 8 }
             }
         }
@@ -110,10 +135,13 @@ Popup {
                 saved.p2Type  = p2Panel.typeIndex
                 saved.p2AI    = p2Panel.aiIndex
                 saved.p2Level = p2Panel.levelIndex
+                saved.clock   = clockCombo.currentIndex
                 root.close()
+                const clock = root.clockOptions[clockCombo.currentIndex]
                 root.gameStarted(
                     p1Panel.typeIndex === 0, p1Panel.aiIndex, p1Panel.levelIndex,
-                    p2Panel.typeIndex === 0, p2Panel.aiIndex, p2Panel.levelIndex
+                    p2Panel.typeIndex === 0, p2Panel.aiIndex, p2Panel.levelIndex,
+                    clock[1], clock[2]
                 )
             }
         }
@@ -216,7 +216,7 @@ ApplicationWindow {
     GameSetupDialog {
         id: setupDialog
         gameActive: root.gameActive
-        onGameStarted: (p1Human, p1AI, p1Lvl, p2Human, p2AI, p2Lvl) => {
+        onGameStarted: (p1Human, p1AI, p1Lvl, p2Human, p2AI, p2Lvl, clockSeconds, incrementSeconds) => {
             aiLogModel.clear()
             board.clearBoard()
             root.moveCount    = 0
@@ -227,7 +227,8 @@ ApplicationWindow {
             root.gameActive   = true
             root.aiThinking   = false
             root.humanVsHuman = p1Human && p2Human
-            gameController.startNewGameQML(p1Human, p1AI, p1Lvl, p2Human, p2AI, p2Lvl)
+            gameController.startNewGameQML(p1Human, p1AI, p1Lvl, p2Human, p2AI, p2Lvl,
+                                           clockSeconds, incrementSeconds)
         }
     }
 
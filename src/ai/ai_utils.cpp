@@ -4,25 +4,26 @@
 
 #include "ai_utils.h"
 #include "tictactoeboard.h"
+#include "scratch_board.h"
+#include "hash_board.h"
 #include <set>
 
 namespace AIUtils {
 
 // Helper function to compute all valid adjacent moves from scratch
 // Used during minimax recursion where we don't maintain a state
-std::vector<std::pair<int, int>> computeAdjacentMoves(const TicTacToeBoard& board) {
-    std::vector<std::pair<int, int>> moves;
-    auto occupiedPositions = board.getOccupiedPositions();
-    std::set<std::pair<int, int>> uniquePositions;
+std::vector<Cell> computeAdjacentMoves(const TicTacToeBoard& board) {
+    std::vector<Cell> moves;
+    const auto& occupiedPositions = board.getOccupiedPositions();
+    std::set<Cell> uniquePositions;
 
     for (const auto& [pos, mark] : occupiedPositions) {
-        int x = pos.first, y = pos.second;
-
         // Check all adjacent positions
-        for (int i = x - 1; i <= x + 1; ++i) {
-            for (int j = y - 1; j <= y + 1; ++j) {
-                if (!board.isPositionOccupied(i, j)) {
-                    uniquePositions.insert({i, j});
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                Cell neighbour = pos.offset(dx, dy);
+                if (!board.isPositionOccupied(neighbour)) {
+                    uniquePositions.insert(neighbour);
                 }
             }
         }
@@ -34,7 +35,8 @@ std::vector<std::pair<int, int>> computeAdjacentMoves(const TicTacToeBoard& boar
 
 // Helper function to update available moves after a move
 // Removes the played position and adds adjacent empty positions
-void updateAvailableMoves(std::set<std::pair<int, int>>& availableMoves,
+template <typename MoveSet>
+void updateAvailableMoves(MoveSet& availableMoves,
                          const TicTacToeBoard& board,
                          int moveX, int moveY) {
     // Remove the position that was just played
@@ -54,112 +56,111 @@ void updateAvailableMoves(std::set<std::pair<int, int>>& availableMoves,
     }
 }
 
-bool createsOpenFour(TicTacToeBoard& board, int x, int y, char playerMark) {
-    board.placeMarkDirect(x, y, playerMark);
-    char opponent = (playerMark == 'X') ? 'O' : 'X';
-
-    int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
-    const auto& occupied = board.getOccupiedPositions();
-    std::set<std::pair<std::pair<int,int>,std::pair<int,int>>> counted;
+static_assert(BoardBackend<TicTacToeBoard>);
+static_assert(StripBoardBackend<ScratchBoard>);
 
+// Line masks through (x, y) as if playerMark stood there (the cell itself must be empty)
+template <typename Rule, StripBoardBackend Board>
+static void classifyWithStone(const Board& board, int x, int y, char playerMark, LineMasks masks[4]) {
+    char opponent = (playerMark == 'X') ? 'O' : 'X';
+    LineStrips strips;
+    board.template gatherStrips<Rule>(board.index(x, y), strips);
+    LineClassifier::classify(strips, playerMark, opponent, masks);
     for (int d = 0; d < 4; ++d) {
-        int dx = directions[d][0], dy = directions[d][1];
-        for (int offset = 0; offset < 5; ++offset) {
-            int startX = x - offset * dx, startY = y - offset * dy;
-            int endX = startX + 4 * dx, endY = startY + 4 * dy;
-
-            auto p1 = std::make_pair(startX, startY);
-            auto p2 = std::make_pair(endX, endY);
-            auto key = (p1 < p2) ? std::make_pair(p1, p2) : std::make_pair(p2, p1);
-            if (!counted.insert(key).second) continue;
-
-            int friendly = 0, opp = 0, empty = 0;
-            for (int k = 0; k < 5; ++k) {
-                int cx = startX + k * dx, cy = startY + k * dy;
-                if (!board.isPositionOccupied(cx, cy)) { ++empty; }
-                else if (occupied.at({cx, cy}) == playerMark) { ++friendly; }
-                else { ++opp; }
-            }
-
-            if (friendly != 4 || empty != 1 || opp != 0) continue;
-
-            bool openBefore = !board.isPositionOccupied(startX - dx, startY - dy) ||
-                              occupied.at({startX - dx, startY - dy}) != opponent;
-            bool openAfter  = !board.isPositionOccupied(endX + dx, endY + dy) ||
-                              occupied.at({endX + dx, endY + dy}) != opponent;
-
-            if (openBefore && openAfter) {
-                board.removeMarkDirect(x, y);
-                return true;
-            }
-        }
+        masks[d].friendly |= Rule::CENTER_BIT;
+        masks[d].empty &= static_cast<std::uint16_t>(~Rule::CENTER_BIT);
     }
-
-    board.removeMarkDirect(x, y);
-    return false;
 }
 
-// Count distinct open-3 windows that pass through (x, y) after placing playerMark there.
-// An open-3 is a 5-cell window with exactly 3 friendly marks, 2 empty cells, no opponent
-// marks, and both cells just outside the window unblocked by the opponent.
-// Uses in-place make/unmake pattern.
-int countOpenThreesAtPosition(TicTacToeBoard& board, int x, int y, char playerMark) {
-    board.placeMarkDirect(x, y, playerMark);
-    char opponent = (playerMark == 'X') ? 'O' : 'X';
+// Count the open windows through (x, y) holding `friendlyTarget` friendly marks once
+// playerMark is placed there, stopping at `limit`. Backends with line access answer from
+// classified strips; the others scan with make/unmake.
+// Every (direction, offset) pair names a different N-cell window through (x, y),
+// so the scan never needs to de-duplicate windows.
+template <typename Rule, BoardBackend Board>
+static int countOpenWindows(Board& board, int x, int y, char playerMark, int friendlyTarget, int limit) {
+    constexpr int N = Rule::LENGTH;
     int count = 0;
 
-    int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
-    std::set<std::pair<std::pair<int, int>, std::pair<int, int>>> countedWindows;
-    const auto& occupied = board.getOccupiedPositions();
-
-    for (int d = 0; d < 4; ++d) {
-        int dx = directions[d][0];
-        int dy = directions[d][1];
-
-        for (int offset = 0; offset < 5; ++offset) {
-            int startX = x - offset * dx;
-            int startY = y - offset * dy;
-            int endX = startX + 4 * dx;
-            int endY = startY + 4 * dy;
-
-            auto p1 = std::make_pair(startX, startY);
-            auto p2 = std::make_pair(endX, endY);
-            auto windowKey = (p1 < p2) ? std::make_pair(p1, p2) : std::make_pair(p2, p1);
-
-            if (countedWindows.count(windowKey) > 0) continue;
-            countedWindows.insert(windowKey);
-
-            int friendlyCount = 0, opponentCount = 0, emptyCount = 0;
-            for (int k = 0; k < 5; ++k) {
-                int cellX = startX + k * dx;
-                int cellY = startY + k * dy;
-                if (!board.isPositionOccupied(cellX, cellY)) {
-                    emptyCount++;
-                } else if (occupied.at({cellX, cellY}) == playerMark) {
-                    friendlyCount++;
-                } else {
-                    opponentCount++;
+    if constexpr (StripBoardBackend<Board>) {
+        LineMasks masks[4];
+        classifyWithStone<Rule>(board, x, y, playerMark, masks);
+
+        for (const LineMasks& m : masks) {
+            for (int offset = 0; offset < N; ++offset) {
+                const int start = Rule::STRIP_CENTER - offset;
+                if (LineClassifier::windowCount<Rule>(m.friendly, start) != friendlyTarget ||
+                    LineClassifier::windowCount<Rule>(m.opponent, start) != 0) continue;
+                if (!LineClassifier::bitSet(m.opponent, start - 1) &&
+                    !LineClassifier::bitSet(m.opponent, start + N) &&
+                    ++count >= limit) {
+                    return count;
                 }
             }
+        }
+        return count;
+    } else {
+        board.placeMarkDirect(x, y, playerMark);
+        char opponent = (playerMark == 'X') ? 'O' : 'X';
+
+        int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+        for (int d = 0; d < 4 && count < limit; ++d) {
+            int dx = directions[d][0], dy = directions[d][1];
+            for (int offset = 0; offset < N && count < limit; ++offset) {
+                int startX = x - offset * dx, startY = y - offset * dy;
+                int endX = startX + (N - 1) * dx, endY = startY + (N - 1) * dy;
+
+                int friendly = 0, opp = 0;
+                for (int k = 0; k < N; ++k) {
+                    char cell = board.getMark(startX + k * dx, startY + k * dy);
+                    if (cell == playerMark) { ++friendly; }
+                    else if (cell == opponent) { ++opp; }
+                }
 
-            if (opponentCount > 0 || friendlyCount != 3 || emptyCount != 2) continue;
-
-            int beforeX = startX - dx, beforeY = startY - dy;
-            int afterX = endX + dx, afterY = endY + dy;
+                if (friendly != friendlyTarget || opp != 0) continue;
 
-            bool openBefore = !board.isPositionOccupied(beforeX, beforeY) ||
-                              occupied.at({beforeX, beforeY}) != opponent;
-            bool openAfter = !board.isPositionOccupied(afterX, afterY) ||
-                             occupied.at({afterX, afterY}) != opponent;
+                bool openBefore = board.getMark(startX - dx, startY - dy) != opponent;
+                bool openAfter  = board.getMark(endX + dx, endY + dy) != opponent;
 
-            if (openBefore && openAfter) {
-                count++;
+                if (openBefore && openAfter) {
+                    count++;
+                }
             }
         }
+
+        board.removeMarkDirect(x, y);
+        return count;
     }
+}
 
-    board.removeMarkDirect(x, y);
-    return count;
+template <typename Rule, BoardBackend Board>
+bool createsOpenFour(Board& board, int x, int y, char playerMark) {
+    return countOpenWindows<Rule>(board, x, y, playerMark, Rule::LENGTH - 1, 1) > 0;
 }
 
+template <typename Rule, BoardBackend Board>
+int countOpenThreesAtPosition(Board& board, int x, int y, char playerMark) {
+    return countOpenWindows<Rule>(board, x, y, playerMark, Rule::LENGTH - 2, 4 * Rule::LENGTH);
+}
+
+// Explicit instantiations for the move-set flavours and the board backends
+template void updateAvailableMoves<std::set<Cell>>(std::set<Cell>&, const TicTacToeBoard&, int, int);
+#define AIUTILS_INSTANTIATE_SCANNERS(N, BoardType) \
+    template bool createsOpenFour<WinRule<N>, BoardType>(BoardType&, int, int, char); \
+    template int countOpenThreesAtPosition<WinRule<N>, BoardType>(BoardType&, int, int, char);
+AIUTILS_INSTANTIATE_SCANNERS(4, TicTacToeBoard)
+AIUTILS_INSTANTIATE_SCANNERS(5, TicTacToeBoard)
+AIUTILS_INSTANTIATE_SCANNERS(6, TicTacToeBoard)
+AIUTILS_INSTANTIATE_SCANNERS(7, TicTacToeBoard)
+AIUTILS_INSTANTIATE_SCANNERS(4, ScratchBoard)
+AIUTILS_INSTANTIATE_SCANNERS(5, ScratchBoard)
+AIUTILS_INSTANTIATE_SCANNERS(6, ScratchBoard)
+AIUTILS_INSTANTIATE_SCANNERS(7, ScratchBoard)
+AIUTILS_INSTANTIATE_SCANNERS(4, HashBoard)
+AIUTILS_INSTANTIATE_SCANNERS(5, HashBoard)
+AIUTILS_INSTANTIATE_SCANNERS(6, HashBoard)
+AIUTILS_INSTANTIATE_SCANNERS(7, HashBoard)
+#undef AIUTILS_INSTANTIATE_SCANNERS
+
 } // namespace AIUtils
@@ -4,41 +4,91 @@
 
 #pragma once
 
+#include "board_backend.h"
+#include "cell.h"
+#include "winrule.h"
 #include <vector>
 #include <set>
 #include <utility>
 
-class TicTacToeBoard;
-
 // Move with its evaluated score — shared by HybridEvaluatorAI v2 and v3
 struct MoveScore {
-    std::pair<int, int> move;
+    Cell move;
     int score;
     int ourScore;
     int oppScore;
 };
 
+// Search counters for the most recent findBestMove call — shared by HybridEvaluatorAI v2 and v3
+struct SearchStats {
+    long long nodes = 0;        // Positions made on the board during minimax (root moves included)
+    long long movesScored = 0;  // Candidate moves scored by getTopNMoves
+    long long frontierMoves = 0;  // Empty cells next to a stone at the root
+    long long rootMoves = 0;    // Of those, the root candidates left after dropping dead cells
+    long long deadMovesPruned = 0;  // Dead cells left out of the root candidates and of the moves added in the tree
+    long long policyPruned = 0;  // Candidates the move policy dropped before delta scoring
+    long long expanded = 0;     // Search nodes (root included) whose candidates were ranked
+    long long widthKept = 0;    // Candidates those nodes kept (topN or the adaptive beam)
+    long long threatNodes = 0;  // Moves made by the threat-space search (v3 Priority 2.1)
+    long long debugMismatches = 0;  // debugMode: incremental results that disagreed with a recomputation
+
+    // Children searched per expanded node, after beam and alpha-beta pruning
+    double getEffectiveBranching() const { return expanded ? static_cast<double>(nodes) / expanded : 0.0; }
+    // Candidates kept per expanded node
+    double getAverageWidth() const { return expanded ? static_cast<double>(widthKept) / expanded : 0.0; }
+};
+
+// Variable minimax width (HybridEngine::setAdaptiveBeam). A node keeps the candidates whose
+// heuristic score is within `margin` of its best, but at least minWidth and at most its
+// width limit: topN at the root, shrinking by shrinkPerPly per ply below it down to minWidth.
+// Quiet nodes with one clearly best move stay narrow; sharp ones keep every close candidate.
+// A margin of 0 turns it off (topN at every node).
+struct AdaptiveBeam {
+    int margin = 0;
+    int minWidth = 2;
+    int shrinkPerPly = 2;
+
+    bool enabled() const { return margin > 0; }
+};
+
+// What decided the most recent findBestMove call, for analysis tools — shared by v2 and v3
+struct SearchAnalysis {
+    // "opening", "win", "block", "open-4", "block-open-4", "vct", "double-3", "block-double-3",
+    // "minimax" or "cache" (a stored minimax result)
+    const char* stage = "";
+    int score = 0;  // Minimax value for the mover (win, vct, minimax and cache only)
+    std::vector<Cell> principalVariation;  // The chosen move, then the expected replies
+};
+
 namespace AIUtils {
     // Compute all valid adjacent moves from scratch
     // Used during minimax recursion where we don't maintain state
-    std::vector<std::pair<int, int>> computeAdjacentMoves(const TicTacToeBoard& board);
+    std::vector<Cell> computeAdjacentMoves(const TicTacToeBoard& board);
 
     // Update available moves after a move
     // Removes the played position and adds adjacent empty positions
-    void updateAvailableMoves(std::set<std::pair<int, int>>& availableMoves,
+    // MoveSet is std::set<Cell> (instantiated in ai_utils.cpp)
+    template <typename MoveSet>
+    void updateAvailableMoves(MoveSet& availableMoves,
                              const TicTacToeBoard& board,
                              int moveX, int moveY);
 
-    // Returns true if placing playerMark at (x,y) creates an open-4:
-    // a 5-cell window with exactly 4 friendly marks, 1 empty cell, no opponent marks,
+    // Returns true if placing playerMark at (x,y) creates an open-4 (open N-1 for WinRule<N>):
+    // an N-cell window with exactly N-1 friendly marks, 1 empty cell, no opponent marks,
     // and both cells immediately outside the window unblocked by the opponent.
     // An open-4 is an unblockable double threat — opponent can win from either end.
-    bool createsOpenFour(TicTacToeBoard& board, int x, int y, char playerMark);
+    // Board is any of the BoardBackends (board_backend.h) and Rule is WinRule<4> to WinRule<7>
+    // (instantiated in ai_utils.cpp). Backends with line access (ScratchBoard) read
+    // SIMD-classified line strips and leave the board untouched.
+    template <typename Rule = StandardWinRule, BoardBackend Board>
+    bool createsOpenFour(Board& board, int x, int y, char playerMark);
 
-    // Count distinct open-3 windows that pass through (x, y) after placing playerMark there.
-    // An open-3 is a 5-cell window with exactly 3 friendly marks, 2 empty cells, no opponent
-    // marks, and both cells just outside the window unblocked by the opponent.
+    // Count distinct open-3 windows (open N-2 for WinRule<N>) that pass through (x, y)
+    // after placing playerMark there. An open-3 is an N-cell window with exactly N-2 friendly
+    // marks, 2 empty cells, no opponent marks, and both cells just outside the window
+    // unblocked by the opponent.
     // A move creating >= 2 such windows is a "second-order double threat" (double open-3 fork).
-    // Uses in-place make/unmake pattern on the board.
-    int countOpenThreesAtPosition(TicTacToeBoard& board, int x, int y, char playerMark);
+    // Uses in-place make/unmake pattern on backends without line access.
+    template <typename Rule = StandardWinRule, BoardBackend Board>
+    int countOpenThreesAtPosition(Board& board, int x, int y, char playerMark);
 }
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "cell.h"
 #include <utility>
 #include <climits>
 #include <functional>
@@ -19,6 +20,9 @@ protected:
     bool verboseMode = false;
     std::function<void(const std::string&)> logFn_;
 
+    // True when log() output goes anywhere; check it before building expensive messages
+    bool logging() const { return logFn_ || verboseMode; }
+
     void log(const std::string& msg) {
         if (logFn_) logFn_(msg);
         else if (verboseMode) std::cout << msg;
@@ -31,8 +35,8 @@ public:
     void setMessageCallback(std::function<void(const std::string&)> fn) { logFn_ = std::move(fn); }
 
     // Find and return the best move for the current board state
-    // lastMove: the last move made by the opponent (x, y coordinates)
-    //           Use {INT_MIN, INT_MIN} to indicate no last move (first move of game)
-    virtual std::pair<int, int> findBestMove(const TicTacToeBoard& board, char playerMark,
-                                              std::pair<int, int> lastMove = {INT_MIN, INT_MIN}) = 0;
+    // lastMove: the last move made by the opponent
+    //           Use Cell::none() to indicate no last move (first move of game)
+    virtual Cell findBestMove(const TicTacToeBoard& board, char playerMark,
+                              Cell lastMove = Cell::none()) = 0;
 };
@@ -0,0 +1,304 @@
+// Analysis Cache - Search results kept in a memory-mapped file across runs and processes
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "analysis_cache.h"
+#include "tictactoeboard.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INFINITTT_POSIX_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define INFINITTT_POSIX_MMAP 0
+#endif
+
+struct AnalysisCache::Header {
+    char magic[8];
+    std::uint32_t entrySize;
+    std::uint32_t bucketCount;
+    std::uint32_t generation;  // Stores so far (all processes), the clock of LEAST_RECENT
+    std::uint32_t reserved[3];
+};
+
+namespace {
+
+constexpr char MAGIC[8] = {'I', 'T', 'T', 'A', 'N', 'C', '0', '1'};
+constexpr std::uint64_t VALID = 1;        // Flag bit of a used entry
+constexpr std::uint64_t SIDE_O = 0x9E3779B97F4A7C15ull;
+constexpr std::uint64_t STONE_O = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t LAST_MOVE = 0x165667B19E3779F9ull;
+
+constexpr std::size_t HEADER_BYTES = 32;
+constexpr std::size_t ENTRY_BYTES = 24;
+
+// splitmix64 finaliser
+std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27; h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+std::uint64_t load(const std::uint64_t& word) {
+    return std::atomic_ref<const std::uint64_t>(word).load(std::memory_order_relaxed);
+}
+void save(std::uint64_t& word, std::uint64_t value) {
+    std::atomic_ref<std::uint64_t>(word).store(value, std::memory_order_relaxed);
+}
+
+std::uint64_t packInfo(int score, int depth, std::uint64_t flags, std::uint32_t age) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(score)) << 32) |
+           (static_cast<std::uint64_t>(depth & 0xff) << 24) | ((flags & 0xff) << 16) | (age & 0xffff);
+}
+int infoScore(std::uint64_t info) { return static_cast<std::int32_t>(info >> 32); }
+int infoDepth(std::uint64_t info) { return static_cast<int>((info >> 24) & 0xff); }
+std::uint64_t infoFlags(std::uint64_t info) { return (info >> 16) & 0xff; }
+std::uint16_t infoAge(std::uint64_t info) { return static_cast<std::uint16_t>(info); }
+
+AnalysisCache::Outcome infoOutcome(std::uint64_t info) {
+    return static_cast<AnalysisCache::Outcome>((infoFlags(info) >> 1) & 3);
+}
+
+// Depth for replacement decisions: a proven result outranks any search depth
+int effectiveDepth(std::uint64_t info) {
+    return infoOutcome(info) == AnalysisCache::Outcome::UNKNOWN ? infoDepth(info) : INT_MAX;
+}
+
+// Apply a transform (see AnalysisCache::Key) without the translation
+void transform(int t, int x, int y, int& a, int& b) {
+    a = (t & 4) ? y : x;
+    b = (t & 4) ? x : y;
+    if (t & 1) a = -a;
+    if (t & 2) b = -b;
+}
+
+Cell toCanonical(const AnalysisCache::Key& key, Cell move) {
+    int a, b;
+    transform(key.transform, move.x(), move.y(), a, b);
+    return {a - key.originX, b - key.originY};
+}
+
+Cell fromCanonical(const AnalysisCache::Key& key, Cell move) {
+    int a = move.x() + key.originX;
+    int b = move.y() + key.originY;
+    if (key.transform & 1) a = -a;
+    if (key.transform & 2) b = -b;
+    return (key.transform & 4) ? Cell(b, a) : Cell(a, b);
+}
+
+std::size_t bytesFor(std::size_t buckets) {
+    return HEADER_BYTES + buckets * AnalysisCache::WAYS * ENTRY_BYTES;
+}
+
+} // namespace
+
+AnalysisCache::Key AnalysisCache::canonicalKey(const TicTacToeBoard& board, char sideToMove,
+                                               std::uint64_t context, Cell lastMove) {
+    const auto& stones = board.getOccupiedPositions();
+
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    if (!stones.empty()) {
+        minX = maxX = stones.begin()->first.x();
+        minY = maxY = stones.begin()->first.y();
+        for (const auto& [cell, mark] : stones) {
+            minX = std::min(minX, cell.x()); maxX = std::max(maxX, cell.x());
+            minY = std::min(minY, cell.y()); maxY = std::max(maxY, cell.y());
+        }
+    }
+
+    // Origin of each of the 8 transformed frames: the minimum corner of the transformed stones
+    int originA[8], originB[8];
+    for (int t = 0; t < 8; ++t) {
+        const int lowA = (t & 4) ? minY : minX, highA = (t & 4) ? maxY : maxX;
+        const int lowB = (t & 4) ? minX : minY, highB = (t & 4) ? maxX : maxY;
+        originA[t] = (t & 1) ? -highA : lowA;
+        originB[t] = (t & 2) ? -highB : lowB;
+    }
+
+    // Order-independent sum of per-stone hashes in every frame; the smallest picks the frame
+    std::uint64_t sums[8] = {};
+    for (const auto& [cell, mark] : stones) {
+        const std::uint64_t colour = mark == 'O' ? STONE_O : 0;
+        for (int t = 0; t < 8; ++t) {
+            int a, b;
+            transform(t, cell.x(), cell.y(), a, b);
+            sums[t] += mix(Cell(a - originA[t], b - originB[t]).packed() ^ colour);
+        }
+    }
+
+    Key key;
+    key.transform = static_cast<int>(std::min_element(sums, sums + 8) - sums);
+    key.originX = originA[key.transform];
+    key.originY = originB[key.transform];
+    key.hash = mix(sums[key.transform] ^ mix(context ^ (sideToMove == 'O' ? SIDE_O : 0)));
+    if (!lastMove.isNone()) {
+        int a, b;
+        transform(key.transform, lastMove.x(), lastMove.y(), a, b);
+        key.hash = mix(key.hash ^ mix(Cell(a - key.originX, b - key.originY).packed() ^ LAST_MOVE));
+    }
+    return key;
+}
+
+bool AnalysisCache::probe(const Key& key, int minDepth, Analysis& result) {
+    if (!isOpen()) return false;
+
+    Entry* bucket = entries + (key.hash & (bucketCount - 1)) * WAYS;
+    for (int way = 0; way < WAYS; ++way) {
+        Entry& entry = bucket[way];
+        const std::uint64_t info = load(entry.info);
+        const std::uint64_t move = load(entry.move);
+        if (!(infoFlags(info) & VALID) || (load(entry.check) ^ move ^ info) != key.hash) continue;
+
+        if (infoOutcome(info) == Outcome::UNKNOWN && infoDepth(info) < minDepth) break;
+
+        result.bestMove = fromCanonical(key, Cell::fromKey(move));
+        result.score = infoScore(info);
+        result.depth = infoDepth(info);
+        result.outcome = infoOutcome(info);
+
+        if (replacement == Replacement::LEAST_RECENT) {
+            const std::uint32_t now = std::atomic_ref<std::uint32_t>(header->generation).load(std::memory_order_relaxed);
+            const std::uint64_t touched = packInfo(result.score, result.depth, infoFlags(info), now);
+            save(entry.info, touched);
+            save(entry.check, key.hash ^ move ^ touched);
+        }
+        hits++;
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+void AnalysisCache::store(const Key& key, const Analysis& analysis) {
+    if (!isOpen()) return;
+
+    const std::uint32_t now = std::atomic_ref<std::uint32_t>(header->generation).fetch_add(1, std::memory_order_relaxed);
+    const std::uint64_t flags = VALID | (static_cast<std::uint64_t>(analysis.outcome) << 1);
+    const std::uint64_t info = packInfo(analysis.score, std::clamp(analysis.depth, 1, 255), flags, now);
+    const std::uint64_t move = toCanonical(key, analysis.bestMove).packed();
+
+    Entry* bucket = entries + (key.hash & (bucketCount - 1)) * WAYS;
+    Entry* victim = nullptr;
+    for (int way = 0; way < WAYS && !victim; ++way) {
+        const std::uint64_t old = load(bucket[way].info);
+        if ((infoFlags(old) & VALID) && (load(bucket[way].check) ^ load(bucket[way].move) ^ old) == key.hash) {
+            if (effectiveDepth(old) > effectiveDepth(info)) return;  // Keep the deeper result
+            victim = &bucket[way];
+        }
+    }
+    for (int way = 0; way < WAYS && !victim; ++way) {
+        if (!(infoFlags(load(bucket[way].info)) & VALID)) victim = &bucket[way];
+    }
+    if (!victim) {
+        // Full bucket: the policy's worst entry, the oldest breaking ties
+        auto staleness = [&](const Entry& e) { return static_cast<std::uint16_t>(now - infoAge(load(e.info))); };
+        victim = bucket;
+        for (int way = 1; way < WAYS; ++way) {
+            Entry& e = bucket[way];
+            bool worse;
+            if (replacement == Replacement::DEPTH_PREFERRED) {
+                const int depth = effectiveDepth(load(e.info)), victimDepth = effectiveDepth(load(victim->info));
+                worse = depth < victimDepth || (depth == victimDepth && staleness(e) > staleness(*victim));
+            } else {
+                worse = staleness(e) > staleness(*victim);
+            }
+            if (worse) victim = &e;
+        }
+    }
+
+    save(victim->move, move);
+    save(victim->info, info);
+    save(victim->check, key.hash ^ move ^ info);
+    stores++;
+}
+
+#if INFINITTT_POSIX_MMAP
+
+bool AnalysisCache::open(const std::string& filename, std::size_t maxBytes, Replacement replacementPolicy) {
+    static_assert(sizeof(Header) == HEADER_BYTES && sizeof(Entry) == ENTRY_BYTES, "File layout");
+    close();
+
+    std::size_t buckets = 0;
+    while (bytesFor(buckets ? buckets * 2 : 1) <= maxBytes) buckets = buckets ? buckets * 2 : 1;
+    if (buckets == 0) return false;
+
+    // Reuse a valid file as is
+    int fd = ::open(filename.c_str(), O_RDWR);
+    std::size_t bytes = 0;
+    if (fd >= 0) {
+        struct stat st;
+        Header existing;
+        if (fstat(fd, &st) == 0 && pread(fd, &existing, sizeof(existing), 0) == sizeof(existing) &&
+            std::memcmp(existing.magic, MAGIC, sizeof(MAGIC)) == 0 && existing.entrySize == sizeof(Entry) &&
+            existing.bucketCount != 0 && (existing.bucketCount & (existing.bucketCount - 1)) == 0 &&
+            static_cast<std::size_t>(st.st_size) == bytesFor(existing.bucketCount) &&
+            static_cast<std::size_t>(st.st_size) <= maxBytes) {
+            bytes = static_cast<std::size_t>(st.st_size);
+        } else {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Otherwise build a fresh one beside it and rename it into place, so that processes
+    // still mapping the old file keep a valid (if no longer shared) table
+    if (fd < 0) {
+        const std::string temporary = filename + ".tmp" + std::to_string(getpid());
+        fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+
+        Header fresh{};
+        std::memcpy(fresh.magic, MAGIC, sizeof(MAGIC));
+        fresh.entrySize = sizeof(Entry);
+        fresh.bucketCount = static_cast<std::uint32_t>(buckets);
+        bytes = bytesFor(buckets);
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0 ||
+            pwrite(fd, &fresh, sizeof(fresh), 0) != sizeof(fresh) ||
+            std::rename(temporary.c_str(), filename.c_str()) != 0) {
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+    }
+
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file open
+    if (mapped == MAP_FAILED) return false;
+
+    mapping = mapped;
+    mappedBytes = bytes;
+    header = static_cast<Header*>(mapped);
+    entries = reinterpret_cast<Entry*>(static_cast<char*>(mapped) + sizeof(Header));
+    bucketCount = header->bucketCount;
+    replacement = replacementPolicy;
+    hits = 0;
+    misses = 0;
+    stores = 0;
+    return true;
+}
+
+void AnalysisCache::close() {
+    if (mapping) munmap(mapping, mappedBytes);
+    mapping = nullptr;
+    mappedBytes = 0;
+    header = nullptr;
+    entries = nullptr;
+    bucketCount = 0;
+}
+
+#else
+
+bool AnalysisCache::open(const std::string&, std::size_t, Replacement) {
+    return false;
+}
+
+void AnalysisCache::close() {}
+
+#endif
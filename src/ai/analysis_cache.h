@@ -0,0 +1,111 @@
+// Analysis Cache - Search results kept in a memory-mapped file across runs and processes
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TicTacToeBoard;
+
+// A hash file of finished root searches (best move, score, depth, proven win/loss), mapped
+// with mmap(MAP_SHARED) so that every process opening the same file sees the same table.
+// The engine probes it before searching a position and stores its result afterwards, so
+// openings and puzzles analysed once come back instantly in later runs.
+//
+// Positions are keyed by a canonical hash: the same stones translated anywhere on the
+// infinite board, rotated or mirrored, share one entry. The best move is kept in the
+// canonical frame and mapped back to the caller's board on a hit (for a symmetric position,
+// possibly as one of its equivalent mirror images). The key also mixes in a
+// caller-supplied context (engine, limits, weights), since a result is only reusable by the
+// configuration that produced it.
+//
+// Layout: a 32-byte header ("ITTANC01", entry size, bucket count, store counter), then
+// buckets of WAYS 24-byte entries. Each entry stores check = key ^ move ^ info, so a
+// reader racing a writer (another thread or process) sees a key mismatch instead of a
+// torn result. Entries are read and written with relaxed atomics and no locks.
+//
+// Replacement within a full bucket:
+//   DEPTH_PREFERRED - evict the shallowest entry (oldest among equals); proven results are
+//                     treated as infinitely deep
+//   LEAST_RECENT    - evict the entry stored or hit longest ago
+// An entry for the same position is always overwritten by an equally deep or deeper result.
+//
+// Only POSIX targets (Linux, Android, macOS) can open a cache; elsewhere open() returns false.
+class AnalysisCache {
+public:
+    static constexpr int WAYS = 4;
+    static constexpr std::size_t DEFAULT_MAX_BYTES = std::size_t(64) << 20;
+
+    enum class Replacement { DEPTH_PREFERRED, LEAST_RECENT };
+
+    // Game-theoretic value for the side to move, when the search proved one
+    enum class Outcome : std::uint8_t { UNKNOWN, WIN, LOSS };
+
+    struct Analysis {
+        Cell bestMove = Cell::none();
+        int score = 0;   // Search score for the side to move
+        int depth = 0;   // Search depth that produced it (1..255)
+        Outcome outcome = Outcome::UNKNOWN;
+    };
+
+    // Canonical hash of a position plus the transform that maps it to the canonical frame
+    struct Key {
+        std::uint64_t hash = 0;
+        int transform = 0;    // Bit 2: swap x and y, bit 0: negate x, bit 1: negate y
+        int originX = 0;      // Canonical-frame origin (the transformed stones' minimum corner)
+        int originY = 0;
+    };
+
+    AnalysisCache() = default;
+    ~AnalysisCache() { close(); }
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    // Map `filename`, creating it if needed. An existing file is reused when its layout is
+    // valid and fits in maxBytes, otherwise it is reinitialised (empty) at the largest power
+    // of two buckets that fits. Returns false if the file cannot be opened or mapped.
+    bool open(const std::string& filename, std::size_t maxBytes = DEFAULT_MAX_BYTES,
+              Replacement replacement = Replacement::DEPTH_PREFERRED);
+    void close();
+    bool isOpen() const { return entries != nullptr; }
+    std::size_t capacity() const { return bucketCount * WAYS; }  // Entries
+
+    // lastMove, unless none, is mixed in too (in the canonical frame) for callers whose result
+    // depends on it
+    static Key canonicalKey(const TicTacToeBoard& board, char sideToMove, std::uint64_t context,
+                            Cell lastMove = Cell::none());
+
+    // Result for the position if one at least minDepth deep (or proven) is stored.
+    // The best move comes back in the coordinates of the board the key was made from.
+    bool probe(const Key& key, int minDepth, Analysis& result);
+    void store(const Key& key, const Analysis& analysis);
+
+    // Hits, misses and stores through this object since open() (safe to share across threads)
+    struct Counters {
+        long long hits = 0;
+        long long misses = 0;
+        long long stores = 0;
+    };
+    Counters getCounters() const { return {hits.load(), misses.load(), stores.load()}; }
+
+private:
+    struct Header;
+    struct Entry {
+        std::uint64_t check;  // key ^ move ^ info
+        std::uint64_t move;   // Best move in the canonical frame (Cell::packed)
+        std::uint64_t info;   // score << 32 | depth << 24 | flags << 16 | age
+    };
+
+    void* mapping = nullptr;
+    std::size_t mappedBytes = 0;
+    Header* header = nullptr;
+    Entry* entries = nullptr;
+    std::size_t bucketCount = 0;
+    Replacement replacement = Replacement::DEPTH_PREFERRED;
+    std::atomic<long long> hits{0}, misses{0}, stores{0};
+};
@@ -0,0 +1,68 @@
+// Board Backend - The board interface the AIs need, and the build-time choice of storage
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "winrule.h"
+#include <concepts>
+#include <type_traits>
+
+class TicTacToeBoard;
+class HashBoard;
+class ScratchBoard;
+struct LineStrips;
+
+// What an AI reads and does on a board while it thinks: occupancy and mark queries, make and
+// unmake of a stone, a visit of every stone (to build frontiers and evaluations) and win
+// checks. Code templated on a BoardBackend runs unchanged on every storage:
+//   TicTacToeBoard  the game board (std::map)
+//   HashBoard       open-addressing hash table (hash_board.h)
+//   ScratchBoard    dense bounding-box array (scratch_board.h)
+template <typename Board>
+concept BoardBackend = requires(Board& board, const Board& view, int x, int y, int length, char mark) {
+    { view.isPositionOccupied(x, y) } -> std::same_as<bool>;
+    { view.getMark(x, y) } -> std::same_as<char>;  // '\0' for an empty cell
+    board.placeMarkDirect(x, y, mark);
+    board.removeMarkDirect(x, y);
+    view.forEachStone([](int, int, char) {});      // fn(x, y, mark) for every stone
+    { view.checkWinQuiet(x, y, length) } -> std::same_as<bool>;
+    { view.template checkWinQuiet<StandardWinRule>(x, y) } -> std::same_as<bool>;
+};
+
+// Backends with line access: the four line strips through a cell copied out in one go, for
+// LineClassifier (line_classifier.h). Scanners classify these with SIMD instead of reading
+// the lines cell by cell; the v2/v3 evaluators are built on them.
+template <typename Board>
+concept StripBoardBackend = BoardBackend<Board> && requires(const Board& view, int x, int y, LineStrips& strips) {
+    { view.index(x, y) } -> std::same_as<int>;
+    view.template gatherStrips<StandardWinRule>(view.index(x, y), strips);
+};
+
+// Copy the game board into a working board of any backend. `focus` (usually the last move)
+// centres the window of a backend that bounds its size (ScratchBoard::MAX_SPAN).
+template <BoardBackend Board>
+void loadBoard(Board& work, const TicTacToeBoard& board, Cell focus = Cell::none()) {
+    if constexpr (std::is_same_v<Board, TicTacToeBoard>) work = board;
+    else if constexpr (requires { work.loadFrom(board, focus); }) work.loadFrom(board, focus);
+    else work.loadFrom(board);
+}
+
+// Short name of a backend for reports
+template <typename Board>
+constexpr const char* boardBackendName() {
+    if constexpr (std::is_same_v<Board, TicTacToeBoard>) return "map";
+    else if constexpr (std::is_same_v<Board, HashBoard>) return "hash";
+    else return "dense";
+}
+
+// Storage behind the v1 AI, chosen at build time (CMake option INFINITTT_BOARD_BACKEND). The
+// hash table is the default: its memory follows the stone count wherever the stones are.
+#if defined(INFINITTT_BOARD_BACKEND_MAP)
+using AIBoard = TicTacToeBoard;
+#elif defined(INFINITTT_BOARD_BACKEND_DENSE)
+using AIBoard = ScratchBoard;
+#else
+using AIBoard = HashBoard;
+#endif
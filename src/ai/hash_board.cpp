@@ -0,0 +1,93 @@
+// Hash Board - Open-addressing hash table of stones, a board backend for the AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "hash_board.h"
+#include "board_backend.h"
+#include "tictactoeboard.h"
+#include <algorithm>
+#include <bit>
+
+static_assert(BoardBackend<HashBoard>);
+
+void HashBoard::reserve(std::size_t stones) {
+    const std::size_t capacity = std::max(MIN_CAPACITY, std::bit_ceil(2 * stones + 1));
+    if (capacity == slots.size()) {
+        std::fill(slots.begin(), slots.end(), Slot{});
+    } else {
+        slots.assign(capacity, Slot{});
+    }
+    mask = capacity - 1;
+    shift = 64 - std::countr_zero(capacity);
+    stoneCount = 0;
+}
+
+void HashBoard::loadFrom(const TicTacToeBoard& board) {
+    const auto& occupied = board.getOccupiedPositions();
+    // Keep a larger table from an earlier load: the game only grows between moves
+    reserve(std::max(occupied.size(), slots.size() / 2 - 1));
+    for (const auto& [cell, mark] : occupied) {
+        insert(cell.packed(), mark);
+    }
+}
+
+void HashBoard::insert(std::uint64_t key, char mark) {
+    std::size_t i = home(key);
+    while (slots[i].key != FREE && slots[i].key != key) i = (i + 1) & mask;
+    if (slots[i].key == FREE) stoneCount++;
+    slots[i] = {key, mark};
+}
+
+void HashBoard::placeMarkDirect(int x, int y, char mark) {
+    if (2 * (stoneCount + 1) > slots.size()) {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(2 * old.size(), Slot{});
+        mask = slots.size() - 1;
+        shift--;
+        stoneCount = 0;
+        for (const Slot& slot : old) {
+            if (slot.key != FREE) insert(slot.key, slot.mark);
+        }
+    }
+    insert(Cell(x, y).packed(), mark);
+}
+
+// Backward-shift deletion: later entries of the probe run move into the hole unless that
+// would put them before their home slot
+void HashBoard::removeMarkDirect(int x, int y) {
+    const std::uint64_t key = Cell(x, y).packed();
+    std::size_t hole = home(key);
+    while (slots[hole].key != key) {
+        if (slots[hole].key == FREE) return;
+        hole = (hole + 1) & mask;
+    }
+    stoneCount--;
+
+    for (std::size_t i = (hole + 1) & mask; slots[i].key != FREE; i = (i + 1) & mask) {
+        // Distance from home to i, and from the hole to i, along the probe order
+        const std::size_t fromHome = (i - home(slots[i].key)) & mask;
+        const std::size_t fromHole = (i - hole) & mask;
+        if (fromHome >= fromHole) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole] = Slot{};
+}
+
+// Same rule as TicTacToeBoard::checkWinQuiet
+bool HashBoard::checkWinQuiet(int x, int y, int length) const {
+    const char mark = getMark(x, y);
+    if (mark == EMPTY) return false;
+    if (isSupportedWinLength(length)) {
+        return withWinRule(length, [&](auto rule) { return checkWinQuiet<decltype(rule)>(x, y); });
+    }
+
+    for (const auto& d : DIRECTIONS) {
+        int count = 1;
+        for (int i = 1; getMark(x + i * d[0], y + i * d[1]) == mark; ++i) count++;
+        for (int i = 1; getMark(x - i * d[0], y - i * d[1]) == mark; ++i) count++;
+        if (count >= length) return true;
+    }
+    return false;
+}
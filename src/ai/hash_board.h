@@ -0,0 +1,91 @@
+// Hash Board - Open-addressing hash table of stones, a board backend for the AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "winrule.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TicTacToeBoard;
+
+// The stones in a flat power-of-two table keyed by the packed Cell, with linear probing:
+// a lookup is one multiply and usually one cache line, where the game board's std::map walks
+// a tree of heap nodes. Unlike ScratchBoard it costs nothing to spread out (memory follows
+// the stone count, not the bounding box), so it suits sparse positions and far-reaching
+// searches. Removal shifts the following probe run back instead of leaving tombstones, so
+// make/unmake keeps lookups as short as a fresh load.
+class HashBoard {
+public:
+    static constexpr char EMPTY = '\0';
+
+    HashBoard() { reserve(0); }
+
+    // Rebuild from the game board (reuses the table when large enough)
+    void loadFrom(const TicTacToeBoard& board);
+
+    bool isPositionOccupied(int x, int y) const { return getMark(x, y) != EMPTY; }
+    char getMark(int x, int y) const {
+        const std::uint64_t key = Cell(x, y).packed();
+        for (std::size_t i = home(key);; i = (i + 1) & mask) {
+            if (slots[i].key == key) return slots[i].mark;
+            if (slots[i].key == FREE) return EMPTY;
+        }
+    }
+    void placeMarkDirect(int x, int y, char mark);
+    void removeMarkDirect(int x, int y);
+    bool checkWinQuiet(int x, int y, int length) const;
+
+    // Win check with the length fixed at compile time; each half-line stops after N - 1 cells
+    template <typename Rule>
+    bool checkWinQuiet(int x, int y) const {
+        const char mark = getMark(x, y);
+        if (mark == EMPTY) return false;
+        for (const auto& d : DIRECTIONS) {
+            int count = 1;
+            for (int i = 1; i < Rule::LENGTH && getMark(x + i * d[0], y + i * d[1]) == mark; ++i) count++;
+            for (int i = 1; i < Rule::LENGTH && getMark(x - i * d[0], y - i * d[1]) == mark; ++i) count++;
+            if (count >= Rule::LENGTH) return true;
+        }
+        return false;
+    }
+
+    bool empty() const { return stoneCount == 0; }
+    std::size_t size() const { return stoneCount; }
+
+    // Visit every stone as fn(x, y, mark), in table order
+    template <typename Fn>
+    void forEachStone(Fn fn) const {
+        for (const Slot& slot : slots) {
+            if (slot.key == FREE) continue;
+            const Cell cell = Cell::fromKey(slot.key);
+            fn(cell.x(), cell.y(), slot.mark);
+        }
+    }
+
+private:
+    static constexpr std::uint64_t FREE = 0;  // Key of Cell::none(), never a stone
+    static constexpr std::size_t MIN_CAPACITY = 64;
+    static constexpr int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+    struct Slot {
+        std::uint64_t key = FREE;
+        char mark = EMPTY;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask = 0;
+    int shift = 64;  // 64 - log2(capacity)
+    std::size_t stoneCount = 0;
+
+    // Fibonacci hashing: the top bits of key * 2^64/phi spread neighbouring cells apart
+    std::size_t home(std::uint64_t key) const {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+    // Empty table with room for `stones` at no more than half load
+    void reserve(std::size_t stones);
+    void insert(std::uint64_t key, char mark);
+};
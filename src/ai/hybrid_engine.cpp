@@ -0,0 +1,1059 @@
+// Hybrid Engine - Minimax search shared by the v2/v3 hybrid evaluator AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "hybrid_engine.h"
+#include "hybrid_evaluator_ai_v2.h"
+#include "hybrid_evaluator_ai_v3.h"
+#include "ai_utils.h"
+#include "tictactoeboard.h"
+#include "scratch_board.h"
+#include "line_classifier.h"
+#include "line_pattern_cache.h"
+#include "move_policy.h"
+#include "nnue_evaluator.h"
+#include "analysis_cache.h"
+#include "search_arena.h"
+#include "evaluationweights.h"
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+template <typename Policy>
+bool HybridEngine<Policy>::setWinLength(int length) {
+    if (!isSupportedWinLength(length)) return false;
+    winLength = length;
+    frontier.setWindowLength(length);
+    patternCache.clear();  // Cached scores are for the old window length
+    return true;
+}
+
+template <typename Policy>
+std::uint64_t HybridEngine<Policy>::analysisContext() const {
+    // FNV-1a over the engine name, the settings and the digests of the policy's and network's weights
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    auto add = [&](std::uint64_t value) { h = (h ^ value) * 0x100000001B3ull; };
+    for (char c : std::string_view(Policy::NAME)) add(static_cast<unsigned char>(c));
+    const EvaluationWeights w = weights ? *weights : EvaluationWeights();
+    for (int value : {topN, winLength, int(useAlphaBeta), w.four_open, w.four_blocked, w.three_open,
+                      w.three_blocked, w.two_open, w.double_threat, movePolicy ? policyWidth : 0}) {
+        add(static_cast<std::uint32_t>(value));
+    }
+    if (movePolicy) add(movePolicy->contentHash());
+    if (network) add(network->contentHash());
+    if (beam.enabled()) {
+        for (int value : {beam.margin, beam.minWidth, beam.shrinkPerPly}) add(static_cast<std::uint32_t>(value));
+    }
+    if (frontier.getShape() != CandidateShape::RADIUS_1) add(static_cast<std::uint32_t>(frontier.getShape()));
+    return h;
+}
+
+// Helper to check if a move results in a win (modifies board temporarily)
+template <typename Policy>
+template <typename Rule>
+bool HybridEngine<Policy>::isWinningMove(ScratchBoard& board, int x, int y, char playerMark) const {
+    board.placeMarkDirect(x, y, playerMark);
+    bool wins = board.checkWinQuiet<Rule>(x, y);
+    board.removeMarkDirect(x, y);
+    return wins;
+}
+
+namespace {
+
+// Fewest friendly stones for a window to score. The weight tiers are named for five in a row
+// and map to N-1 ("four"), N-2 ("three") and N-3 ("two") stones of an N-cell window.
+template <typename Rule>
+constexpr int MIN_SCORED_COUNT = std::max(2, Rule::LENGTH - 3);
+
+// Score the N N-cell windows through a strip centre from the friendly side of the masks.
+// Window `offset` (position of the centre inside the window) starts at strip bit
+// STRIP_CENTER - offset; the bits just outside it tell whether each end is open.
+template <typename Rule>
+int scoreLineWindows(const LineMasks& m, const EvaluationWeights& w) {
+    constexpr int N = Rule::LENGTH;
+    int score = 0;
+    for (int offset = 0; offset < N; ++offset) {
+        const int start = Rule::STRIP_CENTER - offset;
+
+        // If opponent has any pieces in this window, it's blocked
+        if (LineClassifier::windowCount<Rule>(m.opponent, start) > 0) continue;
+        // Need enough friendly pieces for the window to count
+        int friendlyCount = LineClassifier::windowCount<Rule>(m.friendly, start);
+        if (friendlyCount < MIN_SCORED_COUNT<Rule>) continue;
+        int emptyCount = N - friendlyCount;
+
+        bool openBefore = !LineClassifier::bitSet(m.opponent, start - 1);
+        bool openAfter = !LineClassifier::bitSet(m.opponent, start + N);
+
+        if (friendlyCount == N - 1) {
+            score += (openBefore && openAfter) ? w.four_open : w.four_blocked;
+        } else if (friendlyCount == N - 2) {
+            if (emptyCount == 2) {
+                score += (openBefore && openAfter) ? w.three_open : w.three_blocked;
+            }
+        } else if (friendlyCount == N - 3) {
+            if (emptyCount == 3 && openBefore && openAfter) {
+                score += w.two_open;
+            }
+        }
+    }
+    return score;
+}
+
+// Pattern cache entry of one strip: its window score and its move policy class
+template <typename Rule>
+const LinePatternCache::Entry& lookupStrip(const LineMasks& masks, const EvaluationWeights& w,
+                                           LinePatternCache& cache) {
+    return cache.lookup(masks, [&w](const LineMasks& m) {
+        return LinePatternCache::Entry{scoreLineWindows<Rule>(m, w), MovePolicy::lineClass<Rule>(m)};
+    });
+}
+
+// Sum of scoreLineWindows over the four strips, each looked up in the pattern cache first
+template <typename Rule>
+int scoreStripWindows(const LineMasks masks[4], const EvaluationWeights& w, LinePatternCache& cache) {
+    int score = 0;
+    for (int d = 0; d < 4; ++d) {
+        score += lookupStrip<Rule>(masks[d], w, cache).score;
+    }
+    return score;
+}
+
+// Masks after a stone lands on the (empty) strip centre
+template <typename Rule>
+void placeCenter(const LineMasks in[4], bool friendly, LineMasks out[4]) {
+    for (int d = 0; d < 4; ++d) {
+        out[d] = in[d];
+        if (friendly) out[d].friendly |= Rule::CENTER_BIT;
+        else out[d].opponent |= Rule::CENTER_BIT;
+        out[d].empty &= static_cast<std::uint16_t>(~Rule::CENTER_BIT);
+    }
+}
+
+// Same strips seen from the other player
+void swapSides(const LineMasks in[4], LineMasks out[4]) {
+    for (int d = 0; d < 4; ++d) {
+        out[d] = {in[d].opponent, in[d].friendly, in[d].empty};
+    }
+}
+
+// True if some friendly N-cell window through the centre is complete
+template <typename Rule>
+bool completesLine(const LineMasks masks[4]) {
+    for (int d = 0; d < 4; ++d) {
+        for (int start = Rule::STRIP_CENTER - (Rule::LENGTH - 1); start <= Rule::STRIP_CENTER; ++start) {
+            if (LineClassifier::windowCount<Rule>(masks[d].friendly, start) == Rule::LENGTH) return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Full board evaluation - same scoring as v1 (for initialization and debugging)
+// Each window is scored once, from the first friendly stone it contains
+template <typename Policy>
+template <typename Rule>
+int HybridEngine<Policy>::evaluatePositionFull(const ScratchBoard& board, char mark) const {
+    constexpr int N = Rule::LENGTH;
+    EvaluationWeights defaultWeights;
+    const EvaluationWeights& w = weights ? *weights : defaultWeights;
+
+    int score = 0;
+    char opponent = (mark == 'X') ? 'O' : 'X';
+    std::pmr::vector<int> winningMoves(arena.resource());  // Board indices of cells that complete a line
+
+    int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    LineStrips strips;
+    LineMasks masks[4];
+
+    board.forEachStone([&](int x, int y, char m) {
+        if (m != mark) return;
+
+        const int center = board.index(x, y);
+        board.gatherStrips<Rule>(center, strips);
+        LineClassifier::classify(strips, mark, opponent, masks);
+
+        for (int d = 0; d < 4; ++d) {
+            const LineMasks& lm = masks[d];
+
+            for (int offset = 0; offset < N; ++offset) {
+                const int start = Rule::STRIP_CENTER - offset;
+
+                // Skip windows that an earlier friendly stone already scored
+                if ((lm.friendly >> start) & ((1u << offset) - 1)) continue;
+
+                if (LineClassifier::windowCount<Rule>(lm.opponent, start) > 0) continue;
+                int friendlyCount = LineClassifier::windowCount<Rule>(lm.friendly, start);
+                if (friendlyCount < MIN_SCORED_COUNT<Rule>) continue;
+                int emptyCount = N - friendlyCount;
+
+                bool openBefore = !LineClassifier::bitSet(lm.opponent, start - 1);
+                bool openAfter = !LineClassifier::bitSet(lm.opponent, start + N);
+
+                int windowScore = 0;
+
+                if (friendlyCount == N - 1) {
+                    const int step = board.step(directions[d][0], directions[d][1]);
+                    for (int k = 0; k < N; ++k) {
+                        if (!LineClassifier::bitSet(lm.empty, start + k)) continue;
+                        int cell = center + (start + k - Rule::STRIP_CENTER) * step;
+                        if (std::find(winningMoves.begin(), winningMoves.end(), cell) == winningMoves.end()) {
+                            winningMoves.push_back(cell);
+                        }
+                    }
+                    windowScore = (openBefore && openAfter) ? w.four_open : w.four_blocked;
+                } else if (friendlyCount == N - 2) {
+                    if (emptyCount == 2) {
+                        windowScore = (openBefore && openAfter) ? w.three_open : w.three_blocked;
+                    }
+                } else if (friendlyCount == N - 3) {
+                    if (emptyCount == 3 && openBefore && openAfter) {
+                        windowScore = w.two_open;
+                    }
+                }
+
+                score += windowScore;
+            }
+        }
+    });
+
+    if (winningMoves.size() >= 2) {
+        score += w.double_threat;
+    }
+
+    return score;
+}
+
+// Incremental evaluation - only evaluates windows containing the move position
+// This is more efficient than full evaluation when we only need to know
+// the score contribution of windows in the area around a move
+template <typename Policy>
+template <typename Rule>
+int HybridEngine<Policy>::evaluatePositionIncremental(const ScratchBoard& board,
+                                                        int moveX, int moveY, char evalMark) const {
+    EvaluationWeights defaultWeights;
+    const EvaluationWeights& w = weights ? *weights : defaultWeights;
+
+    char opponent = (evalMark == 'X') ? 'O' : 'X';
+
+    // Only windows that include the move position matter; the (2N+1)-cell strips through
+    // the move cover all of them plus their end cells
+    LineStrips strips;
+    LineMasks masks[4];
+    board.gatherStrips<Rule>(board.index(moveX, moveY), strips);
+    LineClassifier::classify(strips, evalMark, opponent, masks);
+
+    // Note: Double threat bonus is NOT added here in incremental mode
+    // because we can't reliably detect full-board double threats
+    // from just the local windows. The full evaluation handles this.
+
+    return scoreStripWindows<Rule>(masks, w, patternCache);
+}
+
+// Calculate score delta caused by placing a move
+// The "after" position is the "before" masks with the centre bit set, so the board is not touched
+template <typename Policy>
+template <typename Rule>
+int HybridEngine<Policy>::calculateScoreDelta(const ScratchBoard& board, int moveX, int moveY,
+                                                char moveMark, char evalMark) const {
+    EvaluationWeights defaultWeights;
+    const EvaluationWeights& w = weights ? *weights : defaultWeights;
+
+    char opponent = (evalMark == 'X') ? 'O' : 'X';
+    LineStrips strips;
+    LineMasks before[4], after[4];
+    board.gatherStrips<Rule>(board.index(moveX, moveY), strips);
+    LineClassifier::classify(strips, evalMark, opponent, before);
+    placeCenter<Rule>(before, moveMark == evalMark, after);
+
+    return scoreStripWindows<Rule>(after, w, patternCache) - scoreStripWindows<Rule>(before, w, patternCache);
+}
+
+// debugMode verification. The running minimax score (root full evaluation plus candidate
+// deltas) is not compared with a full evaluation: the deltas only rescore windows through the
+// move, so by design they leave out the double-threat bonus and the open ends of neighbouring
+// windows. Every structure that is meant to be exact is checked instead.
+template <typename Policy>
+void HybridEngine<Policy>::debugMismatch(const std::string& what) const {
+    stats.debugMismatches++;
+    std::cerr << "[DEBUG] " << what << "\n";
+}
+
+template <typename Policy>
+template <typename Rule>
+void HybridEngine<Policy>::verifyScoreDeltas(const ScratchBoard& board, Cell move, char moverMark,
+                                             int ourDelta, int oppDelta) const {
+    EvaluationWeights defaultWeights;
+    const EvaluationWeights& w = weights ? *weights : defaultWeights;
+    const char opponent = (moverMark == 'X') ? 'O' : 'X';
+
+    LineStrips before, after;
+    board.gatherStrips<Rule>(board.index(move.x(), move.y()), before);
+    after = before;
+    for (auto& strip : after.cells) strip[Rule::STRIP_CENTER] = moverMark;
+
+    // Freshly classified strips, scored without the pattern cache
+    auto score = [&](const LineStrips& strips, char mark) {
+        LineMasks masks[4];
+        LineClassifier::classify(strips, mark, mark == 'X' ? 'O' : 'X', masks);
+        int total = 0;
+        for (const LineMasks& m : masks) total += scoreLineWindows<Rule>(m, w);
+        return total;
+    };
+    const int expectedOur = score(after, moverMark) - score(before, moverMark);
+    const int expectedOpp = score(after, opponent) - score(before, opponent);
+    if (ourDelta != expectedOur || oppDelta != expectedOpp) {
+        debugMismatch("Score delta mismatch at (" + std::to_string(move.x()) + "," + std::to_string(move.y()) +
+                      ") mover=" + moverMark + ": incremental=" + std::to_string(ourDelta) + "/" +
+                      std::to_string(oppDelta) + " recomputed=" + std::to_string(expectedOur) + "/" +
+                      std::to_string(expectedOpp));
+    }
+}
+
+template <typename Policy>
+void HybridEngine<Policy>::verifyFrontier(const TicTacToeBoard& board) {
+    MoveFrontier fresh;
+    fresh.setWindowLength(winLength);
+    fresh.setShape(frontier.getShape());
+    fresh.attach(board);
+    if (!std::ranges::equal(fresh.cells(), frontier.cells())) {
+        debugMismatch("Frontier mismatch: incremental=" + std::to_string(frontier.cells().size()) +
+                      " cells, rebuilt=" + std::to_string(fresh.cells().size()));
+    }
+    if (!std::ranges::equal(fresh.liveCells(), frontier.liveCells())) {
+        debugMismatch("Live cell mismatch: incremental=" + std::to_string(frontier.liveCells().size()) +
+                      " cells, rebuilt=" + std::to_string(fresh.liveCells().size()));
+    }
+}
+
+template <typename Policy>
+void HybridEngine<Policy>::verifyScratch(const TicTacToeBoard& board) {
+    // Stones outside a window are left out on purpose
+    std::size_t stones = 0, kept = 0;
+    bool same = true;
+    scratch.forEachStone([&](int x, int y, char mark) {
+        stones++;
+        same = same && board.getMark(x, y) == mark;
+    });
+    for (const auto& [cell, mark] : board.getOccupiedPositions()) {
+        if (!scratch.reaches(cell.x(), cell.y())) continue;
+        kept++;
+        same = same && scratch.getMark(cell.x(), cell.y()) == mark;
+    }
+    if (!same || stones != kept) {
+        debugMismatch("Scratch board mismatch: " + std::to_string(stones) + " stones, game board " +
+                      std::to_string(kept) + " in the window");
+    }
+}
+
+template <typename Policy>
+template <typename Rule>
+void HybridEngine<Policy>::verifyAccumulator(const ScratchBoard& board) {
+    NnueAccumulator fresh;
+    fresh.refresh<Rule>(board, *network);
+    if (std::memcmp(&fresh.top(), &accumulator.top(), sizeof(NnueAccumulator::Frame)) != 0) {
+        debugMismatch("NNUE accumulator mismatch after a push");
+    }
+}
+
+template <typename Policy>
+int HybridEngine<Policy>::probeFullEvaluation(const TicTacToeBoard& board, char mark) {
+    arena.reset();
+    scratch.loadFrom(board);
+    return withWinRule(winLength, [&](auto rule) {
+        return evaluatePositionFull<decltype(rule)>(scratch, mark);
+    });
+}
+
+template <typename Policy>
+int HybridEngine<Policy>::probeScoreDelta(const TicTacToeBoard& board, Cell move, char moveMark, char evalMark) {
+    arena.reset();
+    scratch.loadFrom(board);
+    return withWinRule(winLength, [&](auto rule) {
+        return calculateScoreDelta<decltype(rule)>(scratch, move.x(), move.y(), moveMark, evalMark);
+    });
+}
+
+// Add the live candidate cells around a move to available moves, return list of what was added
+template <typename Policy>
+template <typename Rule>
+std::pmr::vector<Cell> HybridEngine<Policy>::addAdjacentMoves(
+     std::pmr::set<Cell>& moves,
+     const ScratchBoard& board, int x, int y) const {
+
+    std::pmr::vector<Cell> added(arena.resource());
+    const Cell center(x, y);
+    for (const auto [dx, dy] : candidateOffsets(frontier.getShape())) {
+        Cell near = center.offset(dx, dy);
+        if (!board.reaches(near.x(), near.y()) || board.isPositionOccupied(near.x(), near.y()) ||
+            moves.contains(near)) continue;
+        // A dead cell stays dead while stones are only added, so it is never a move below here
+        if (isDeadCell<Rule>(board, near)) {
+            stats.deadMovesPruned++;
+            continue;
+        }
+        moves.insert(near);
+        added.push_back(near);
+    }
+    return added;
+}
+
+template <typename Policy>
+template <typename Rule>
+bool HybridEngine<Policy>::isDeadCell(const ScratchBoard& board, Cell cell) {
+    LineStrips strips;
+    LineMasks masks[4];
+    board.gatherStrips<Rule>(board.index(cell.x(), cell.y()), strips);
+    LineClassifier::classify(strips, 'X', 'O', masks);
+    for (const auto& line : masks) {
+        for (int start = Rule::STRIP_CENTER - (Rule::LENGTH - 1); start <= Rule::STRIP_CENTER; ++start) {
+            if (((line.friendly >> start) & Rule::WINDOW_MASK) == 0 ||
+                ((line.opponent >> start) & Rule::WINDOW_MASK) == 0) return false;
+        }
+    }
+    return true;
+}
+
+// Get top N moves sorted by heuristic score
+// (moves: any sorted range of empty cells - the maintained set, a search set or a shortlist)
+template <typename Policy>
+template <typename Rule, typename MoveRange>
+std::pmr::vector<MoveScore> HybridEngine<Policy>::getTopNMoves(const ScratchBoard& board,
+                                                                const MoveRange& moves,
+                                                                char playerMark, int n,
+                                                                Cell lastMove, int ply) const {
+    char opponent = (playerMark == 'X') ? 'O' : 'X';
+    LineStrips strips;
+    LineMasks ours[4], oursAfter[4], theirs[4], theirsAfter[4];
+
+    EvaluationWeights defaultWeights;
+    const EvaluationWeights& w = weights ? *weights : defaultWeights;
+    std::pmr::vector<MoveScore> scores(arena.resource());
+
+    // Delta scores of a candidate from its classified strips (ours: the mover is friendly)
+    auto scoreMove = [&](Cell move, const LineMasks (&ours)[4]) {
+        placeCenter<Rule>(ours, true, oursAfter);
+        swapSides(ours, theirs);
+        swapSides(oursAfter, theirsAfter);
+
+        // Calculate score delta for this move
+        int ourDelta = scoreStripWindows<Rule>(oursAfter, w, patternCache) -
+                       scoreStripWindows<Rule>(ours, w, patternCache);
+        int oppDelta = scoreStripWindows<Rule>(theirsAfter, w, patternCache) -
+                       scoreStripWindows<Rule>(theirs, w, patternCache);
+        int netScore = ourDelta - oppDelta;
+
+        // Check for immediate win (huge bonus)
+        if (completesLine<Rule>(oursAfter)) {
+            netScore += WIN_SCORE;
+        }
+
+        if (debugMode) verifyScoreDeltas<Rule>(board, move, playerMark, ourDelta, oppDelta);
+        scores.push_back({move, netScore, ourDelta, oppDelta});
+    };
+
+    const bool usePolicy = movePolicy && movePolicy->getWinLength() == Rule::LENGTH &&
+                           policyWidth > 0 && static_cast<int>(moves.size()) > policyWidth;
+    if (!usePolicy) {
+        // One strip classification per candidate serves both players' deltas and the win check
+        scores.reserve(moves.size());
+        stats.movesScored += moves.size();
+        for (const auto& move : moves) {
+            board.gatherStrips<Rule>(board.index(move.x(), move.y()), strips);
+            LineClassifier::classify(strips, playerMark, opponent, ours);
+            scoreMove(move, ours);
+        }
+    } else {
+        // The move policy ranks every candidate from the same strips (its line classes come
+        // with the cached "before" scores); only its best `policyWidth`, plus any move that
+        // wins or blocks a win, are delta scored
+        struct PolicyScore {
+            Cell move;
+            float score;
+            bool forcing;
+            LineMasks masks[4];
+        };
+        std::pmr::vector<PolicyScore> ranked(arena.resource());
+        ranked.reserve(moves.size());
+        for (const auto& move : moves) {
+            PolicyScore& ps = ranked.emplace_back();
+            board.gatherStrips<Rule>(board.index(move.x(), move.y()), strips);
+            LineClassifier::classify(strips, playerMark, opponent, ps.masks);
+            std::uint8_t lines[4];
+            for (int d = 0; d < 4; ++d) lines[d] = lookupStrip<Rule>(ps.masks[d], w, patternCache).policyClass;
+            PolicyFeatures f = MovePolicy::features(lines, move, lastMove);
+            ps.move = move;
+            ps.forcing = movePolicy->isForcing(f);
+            ps.score = movePolicy->score(f);
+        }
+        // Forcing moves first, then by policy score
+        auto shortlistEnd = ranked.begin() + policyWidth;
+        std::partial_sort(ranked.begin(), shortlistEnd, ranked.end(),
+                          [](const PolicyScore& a, const PolicyScore& b) {
+                              return a.forcing != b.forcing ? a.forcing : a.score > b.score;
+                          });
+        while (shortlistEnd != ranked.end() && shortlistEnd->forcing) ++shortlistEnd;
+
+        const auto kept = static_cast<std::size_t>(shortlistEnd - ranked.begin());
+        scores.reserve(kept);
+        stats.movesScored += kept;
+        stats.policyPruned += ranked.size() - kept;
+        for (auto it = ranked.begin(); it != shortlistEnd; ++it) scoreMove(it->move, it->masks);
+    }
+
+    // Sort by score descending
+    std::sort(scores.begin(), scores.end(),
+              [](const MoveScore& a, const MoveScore& b) { return a.score > b.score; });
+
+    // Return top N, or at a search node with the adaptive beam the moves close to the best
+    int width = std::min(n, static_cast<int>(scores.size()));
+    if (ply >= 0 && beam.enabled() && width > 0) {
+        const int limit = std::max(beam.minWidth, n - beam.shrinkPerPly * ply);
+        const int cutoff = scores.front().score - beam.margin;
+        int close = 1;
+        while (close < width && close < limit && scores[close].score >= cutoff) close++;
+        width = std::min(width, std::max(close, beam.minWidth));
+    }
+    scores.resize(width);
+
+    if (ply >= 0) {
+        stats.expanded++;
+        stats.widthKept += width;
+    }
+    return scores;
+}
+
+// Minimax with alpha-beta pruning
+template <typename Policy>
+template <typename Rule>
+int HybridEngine<Policy>::minimax(ScratchBoard& board, int depth, int alpha, int beta,
+                                    bool isMaximizing, char ourMark, char oppMark,
+                                    std::pmr::set<Cell>& currentMoves,
+                                    int currentOurScore, int currentOppScore, Cell lastMove) {
+    // Row of the PV table for this node; a leaf's line is empty
+    const int ply = searchDepth - depth;
+    pvLength[ply] = 0;
+
+    // Terminal: depth reached, or no moves available
+    if (depth == 0 || currentMoves.empty()) {
+        if (nnueActive) return nnueScore(isMaximizing ? ourMark : oppMark, ourMark);
+        return currentOurScore - currentOppScore;
+    }
+
+    char currentMark = isMaximizing ? ourMark : oppMark;
+
+    // Get top N moves for this depth
+    std::pmr::vector<MoveScore> topMoves = getTopNMoves<Rule>(board, currentMoves, currentMark, topN, lastMove, ply);
+
+    if (isMaximizing) {
+        int bestValue = std::numeric_limits<int>::min();
+
+        for (const auto& ms : topMoves) {
+            int x = ms.move.x();
+            int y = ms.move.y();
+
+            // Make move
+            board.placeMarkDirect(x, y, currentMark);
+            stats.nodes++;
+
+            // Check for win
+            if (board.checkWinQuiet<Rule>(x, y)) {
+                board.removeMarkDirect(x, y);
+                pvLength[ply + 1] = 0;  // The line ends with the winning move
+                recordPv(ply, ms.move);
+                return WIN_SCORE;  // We win!
+            }
+
+            // Update available moves
+            currentMoves.erase(ms.move);
+            auto addedMoves = addAdjacentMoves<Rule>(currentMoves, board, x, y);
+            if (nnueActive) {
+                accumulator.push<Rule>(board, x, y, *network);
+                if (debugMode) verifyAccumulator<Rule>(board);
+            }
+
+            // Score deltas were computed by getTopNMoves before the move was placed
+            // (current mover is us here, so its "our" delta is ourMark's)
+            int ourDelta = ms.ourScore;
+            int oppDelta = ms.oppScore;
+
+            // Recurse
+            int value = minimax<Rule>(board, depth - 1, alpha, beta, false, ourMark, oppMark,
+                               currentMoves, currentOurScore + ourDelta, currentOppScore + oppDelta, ms.move);
+
+            // Undo move
+            board.removeMarkDirect(x, y);
+            if (nnueActive) accumulator.pop();
+            for (const auto& added : addedMoves) {
+                currentMoves.erase(added);
+            }
+            currentMoves.insert(ms.move);
+
+            if (value > bestValue) {
+                bestValue = value;
+                recordPv(ply, ms.move);
+            }
+
+            if (useAlphaBeta) {
+                alpha = std::max(alpha, value);
+                if (beta <= alpha) {
+                    break;  // Beta cutoff
+                }
+            }
+        }
+
+        return bestValue;
+    } else {
+        // Minimizing (opponent's turn)
+        int bestValue = std::numeric_limits<int>::max();
+
+        for (const auto& ms : topMoves) {
+            int x = ms.move.x();
+            int y = ms.move.y();
+
+            // Make move
+            board.placeMarkDirect(x, y, currentMark);
+            stats.nodes++;
+
+            // Check for opponent win
+            if (board.checkWinQuiet<Rule>(x, y)) {
+                board.removeMarkDirect(x, y);
+                pvLength[ply + 1] = 0;  // The line ends with the winning move
+                recordPv(ply, ms.move);
+                return -WIN_SCORE;  // Opponent wins
+            }
+
+            // Update available moves
+            currentMoves.erase(ms.move);
+            auto addedMoves = addAdjacentMoves<Rule>(currentMoves, board, x, y);
+            if (nnueActive) {
+                accumulator.push<Rule>(board, x, y, *network);
+                if (debugMode) verifyAccumulator<Rule>(board);
+            }
+
+            // Score deltas from getTopNMoves, seen from the opponent as mover
+            int ourDelta = ms.oppScore;
+            int oppDelta = ms.ourScore;
+
+            // Recurse
+            int value = minimax<Rule>(board, depth - 1, alpha, beta, true, ourMark, oppMark,
+                               currentMoves, currentOurScore + ourDelta, currentOppScore + oppDelta, ms.move);
+
+            // Undo move
+            board.removeMarkDirect(x, y);
+            if (nnueActive) accumulator.pop();
+            for (const auto& added : addedMoves) {
+                currentMoves.erase(added);
+            }
+            currentMoves.insert(ms.move);
+
+            if (value < bestValue) {
+                bestValue = value;
+                recordPv(ply, ms.move);
+            }
+
+            if (useAlphaBeta) {
+                beta = std::min(beta, value);
+                if (beta <= alpha) {
+                    break;  // Alpha cutoff
+                }
+            }
+        }
+
+        return bestValue;
+    }
+}
+
+// Main entry point: find best move
+template <typename Policy>
+Cell HybridEngine<Policy>::findBestMove(const TicTacToeBoard& board, char playerMark,
+                                        Cell lastMove) {
+    stats = SearchStats();
+    arena.reset();  // Nothing from the previous search is still alive
+
+    // Candidate cells follow the board through its change listeners; attaching to a board
+    // the frontier is not following yet (first move, new game, another board) rebuilds it
+    frontier.attach(board);
+    if (debugMode) verifyFrontier(board);
+
+    // If board is empty, start at origin
+    if (frontier.cells().empty()) {
+        return decide("opening", {0, 0});
+    }
+
+    // Dense search-local copy of the board for all priorities and the minimax search; stones
+    // too scattered for it to hold are searched in a window around the last move
+    scratch.loadFrom(board, lastMove);
+    if (debugMode) verifyScratch(board);
+    if (scratch.isWindowed()) {
+        windowMoves.clear();
+        for (const Cell cell : frontierMoves()) {
+            if (scratch.reaches(cell.x(), cell.y())) windowMoves.insert(windowMoves.end(), cell);
+        }
+        if (logging()) log("Scratch board windowed around the last move; wins and blocks are read from the game board\n");
+    }
+
+    // Branching factor before and after dropping dead cells (see move_frontier.h)
+    const auto& availableMoves = candidateMoves();
+    stats.frontierMoves = frontier.cells().size();
+    stats.rootMoves = availableMoves.size();
+    stats.deadMovesPruned = stats.frontierMoves - stats.rootMoves;
+
+    if (logging()) log(std::string("\n[") + Policy::NAME + " - Player " + playerMark + "]\n"
+        "Depth: " + std::to_string(searchDepth) + ", TopN: " + std::to_string(topN) + "\n"
+        "Evaluating " + std::to_string(availableMoves.size()) + " available moves ("
+        + std::to_string(stats.deadMovesPruned) + " dead cells pruned)\n");
+
+    // A windowed search depends on the last move, which the cache key leaves out. So does the
+    // move policy's distance feature, so with a policy the last move goes into the key.
+    if (analysisCache && !scratch.isWindowed()) {
+        analysisKey = AnalysisCache::canonicalKey(board, playerMark, analysisContext(),
+                                                  movePolicy ? lastMove : Cell::none());
+    }
+
+    // Everything from here on runs with the win length fixed at compile time
+    return withWinRule(winLength, [&](auto rule) {
+        return chooseMove<decltype(rule)>(board, playerMark, lastMove);
+    });
+}
+
+// Priorities 1-3 on the loaded scratch board for a compile-time win rule
+template <typename Policy>
+template <typename Rule>
+Cell HybridEngine<Policy>::chooseMove(const TicTacToeBoard& board, char playerMark, Cell lastMove) {
+    const auto& availableMoves = candidateMoves();
+
+    // Stones a windowed scratch board left out still win and must still be blocked, so the
+    // first two priorities then read the game board over the whole frontier
+    const bool windowed = scratch.isWindowed();
+    const auto& lineMoves = windowed ? frontierMoves() : availableMoves;
+    auto completesLine = [&](Cell move, char mark) {
+        return windowed ? board.completesLine(move.x(), move.y(), mark, Rule::LENGTH)
+                        : isWinningMove<Rule>(scratch, move.x(), move.y(), mark);
+    };
+
+    // PRIORITY 1: Check for winning moves
+    std::pmr::vector<Cell> winningMoves(arena.resource());
+    for (const auto& move : lineMoves) {
+        if (completesLine(move, playerMark)) {
+            winningMoves.push_back(move);
+        }
+    }
+
+    if (!winningMoves.empty()) {
+        if (logging()) log("Priority 1: Winning moves - " + std::to_string(winningMoves.size()) + " found\n");
+
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(0, winningMoves.size() - 1);
+        auto winningMove = winningMoves[dis(gen)];
+
+        if (logging()) log("Selected winning move: (" + std::to_string(winningMove.x()) + ", " + std::to_string(winningMove.y()) + ")\n\n");
+
+        return decide("win", winningMove, WIN_SCORE);
+    }
+
+    if (logging()) log("Priority 1: Winning moves - 0 found\n");
+
+    // PRIORITY 2: Block opponent winning moves
+    char opponentMark = (playerMark == 'X') ? 'O' : 'X';
+    std::pmr::vector<Cell> blockingMoves(arena.resource());
+    for (const auto& move : lineMoves) {
+        if (completesLine(move, opponentMark)) {
+            blockingMoves.push_back(move);
+        }
+    }
+
+    if (!blockingMoves.empty()) {
+        if (logging()) log("Priority 2: Blocking moves - " + std::to_string(blockingMoves.size()) + " found\n");
+
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(0, blockingMoves.size() - 1);
+        auto blockingMove = blockingMoves[dis(gen)];
+
+        if (logging()) log("Selected blocking move: (" + std::to_string(blockingMove.x()) + ", " + std::to_string(blockingMove.y()) + ")\n\n");
+
+        return decide("block", blockingMove);
+    }
+
+    if (logging()) log("Priority 2: Blocking moves - 0 found\n");
+
+    // PRIORITY 2.1: Win by continuous threats (fours and open threes, see threat_search.h).
+    // A real open-4 is a one-threat win, so this runs ahead of the open-4 stages as well.
+    // A complete search without a win (NONE) also rules out our forks in 2.5.
+    auto ourThreats = ThreatSearch::Outcome::UNKNOWN;
+    if constexpr (Policy::THREAT_SEARCH) {
+        const auto ours = threatSearch.search<Rule>(scratch, playerMark, availableMoves, arena.resource());
+        stats.threatNodes += ours.nodes;
+        if (ours.outcome == ThreatSearch::Outcome::WIN) {
+            if (logging()) log("Priority 2.1: Winning threat sequence of " + std::to_string(threatSearch.getLine().size()) + " moves ("
+                               + std::to_string(ours.nodes) + " nodes)\n"
+                               "Selected threat: (" + std::to_string(ours.move.x()) + ", " + std::to_string(ours.move.y()) + ")\n\n");
+            decide("vct", ours.move, WIN_SCORE);
+            lastAnalysis.principalVariation = threatSearch.getLine();
+            return ours.move;
+        }
+        ourThreats = ours.outcome;
+        if (logging()) log(std::string("Priority 2.1: Winning threat sequence - ")
+                           + (ourThreats == ThreatSearch::Outcome::NONE ? "none" : "unknown (budget)") + "\n");
+    }
+
+    // PRIORITY 2.2: Create an open-4 (immediate double threat) for ourselves.
+    // An open-4 (_XXXX_) has two winning endpoints — the opponent can block at most one,
+    // so creating one guarantees a win on the next move.
+    if constexpr (Policy::CREATE_OPEN_FOUR) {
+        std::pmr::vector<Cell> createOpenFourMoves(arena.resource());
+        for (const auto& move : availableMoves) {
+            if (AIUtils::createsOpenFour<Rule>(scratch, move.x(), move.y(), playerMark)) {
+                createOpenFourMoves.push_back(move);
+            }
+        }
+        if (!createOpenFourMoves.empty()) {
+            if (logging()) log("Priority 2.2: Create open-4 double-threat - " + std::to_string(createOpenFourMoves.size()) + " found\n");
+            auto ranked = getTopNMoves<Rule>(scratch, createOpenFourMoves, playerMark, 1);
+            auto chosenMove = ranked.empty() ? createOpenFourMoves[0] : ranked[0].move;
+            if (logging()) log("Selected create open-4: (" + std::to_string(chosenMove.x()) + "," + std::to_string(chosenMove.y()) + ")\n\n");
+            return decide("open-4", chosenMove);
+        }
+        if (logging()) log("Priority 2.2: Create open-4 double-threat - 0 found\n");
+    }
+
+    // PRIORITY 2.3: Block opponent from creating an open-4 (unblockable double threat)
+    // An open-4 (_XXXX_) has two winning endpoints — Priority 2 can only block one,
+    // so we must prevent it from being created in the first place.
+    if constexpr (Policy::BLOCK_OPEN_FOUR) {
+        std::pmr::vector<Cell> openFourBlockMoves(arena.resource());
+        for (const auto& move : availableMoves) {
+            if (AIUtils::createsOpenFour<Rule>(scratch, move.x(), move.y(), opponentMark)) {
+                openFourBlockMoves.push_back(move);
+            }
+        }
+        if (!openFourBlockMoves.empty()) {
+            if (logging()) log("Priority 2.3: Block open-4 - " + std::to_string(openFourBlockMoves.size()) + " found\n");
+            auto ranked = getTopNMoves<Rule>(scratch, openFourBlockMoves, playerMark, 1);
+            auto chosenMove = ranked.empty() ? openFourBlockMoves[0] : ranked[0].move;
+            if (logging()) log("Selected open-4 block: (" + std::to_string(chosenMove.x()) + "," + std::to_string(chosenMove.y()) + ")\n\n");
+            return decide("block-open-4", chosenMove);
+        }
+        if (logging()) log("Priority 2.3: Block open-4 - 0 found\n");
+    }
+
+    // PRIORITY 2.5: Create a second-order double threat (double open-3 fork)
+    // A move that simultaneously creates >= 2 open-3 sequences. The opponent can block
+    // at most one, so the other will become a first-order double threat next turn.
+    // Skipped when the threat search proved that no threat line, forks included, wins.
+    if constexpr (Policy::CREATE_DOUBLE_OPEN_THREE) {
+        std::pmr::vector<Cell> doubleOpenThreeMoves(arena.resource());
+
+        for (const auto& move : availableMoves) {
+            if (ourThreats == ThreatSearch::Outcome::NONE) break;
+            if (AIUtils::countOpenThreesAtPosition<Rule>(scratch, move.x(), move.y(), playerMark) >= 2) {
+                doubleOpenThreeMoves.push_back(move);
+            }
+        }
+
+        if (!doubleOpenThreeMoves.empty()) {
+            if (logging()) log("Priority 2.5: Second-order double-threat moves - " + std::to_string(doubleOpenThreeMoves.size()) + " found\n");
+
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> dis(0, doubleOpenThreeMoves.size() - 1);
+            auto chosenMove = doubleOpenThreeMoves[dis(gen)];
+
+            if (logging()) log("Selected second-order double-threat move: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
+
+            return decide("double-3", chosenMove);
+        }
+
+        if (logging()) log("Priority 2.5: Second-order double-threat moves - 0 found\n");
+    }
+
+    // PRIORITY 2.7: Block opponent second-order double threat
+    // With the threat search, the opponent's forks are searched as if they were to move: none
+    // is blocked when they have no winning threat line, and when their line starts with one
+    // of the forks, that fork is the one blocked.
+    if constexpr (Policy::BLOCK_DOUBLE_OPEN_THREE) {
+        std::pmr::vector<Cell> blockDoubleOpenThreeMoves(arena.resource());
+
+        for (const auto& move : availableMoves) {
+            if (AIUtils::countOpenThreesAtPosition<Rule>(scratch, move.x(), move.y(), opponentMark) >= 2) {
+                blockDoubleOpenThreeMoves.push_back(move);
+            }
+        }
+
+        Cell theirThreatMove = Cell::none();
+        if constexpr (Policy::THREAT_SEARCH) {
+            if (!blockDoubleOpenThreeMoves.empty()) {
+                const auto theirs = threatSearch.search<Rule>(scratch, opponentMark, availableMoves, arena.resource());
+                stats.threatNodes += theirs.nodes;
+                theirThreatMove = theirs.move;
+                if (theirs.outcome == ThreatSearch::Outcome::NONE) {
+                    if (logging()) log("Priority 2.7: Opponent forks refuted by threat search - " + std::to_string(blockDoubleOpenThreeMoves.size()) + " skipped\n");
+                    blockDoubleOpenThreeMoves.clear();
+                }
+            }
+        }
+
+        if (!blockDoubleOpenThreeMoves.empty()) {
+            if (logging()) log("Priority 2.7: Block opponent second-order double-threat - " + std::to_string(blockDoubleOpenThreeMoves.size()) + " found\n");
+
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> dis(0, blockDoubleOpenThreeMoves.size() - 1);
+            auto chosenMove = blockDoubleOpenThreeMoves[dis(gen)];
+            if (std::find(blockDoubleOpenThreeMoves.begin(), blockDoubleOpenThreeMoves.end(), theirThreatMove) !=
+                blockDoubleOpenThreeMoves.end()) {
+                chosenMove = theirThreatMove;
+            }
+
+            if (logging()) log("Selected second-order double-threat block: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
+
+            return decide("block-double-3", chosenMove);
+        }
+
+        if (logging()) log("Priority 2.7: Block opponent second-order double-threat - 0 found\n");
+    }
+
+    if (logging()) log("Priority 3: Minimax evaluation (depth=" + std::to_string(searchDepth) + ")\n");
+
+    // A position searched before at this depth or deeper (this run or an earlier one)
+    AnalysisCache::Analysis cached;
+    if (analysisCache && !scratch.isWindowed() && analysisCache->probe(analysisKey, searchDepth, cached) &&
+        availableMoves.count(cached.bestMove)) {
+        if (logging()) log("Analysis cache hit (depth " + std::to_string(cached.depth) + "): (" +
+                           std::to_string(cached.bestMove.x()) + ", " + std::to_string(cached.bestMove.y()) + ")\n\n");
+        return decide("cache", cached.bestMove, cached.score);
+    }
+
+    // PRIORITY 3: Use minimax to evaluate moves
+    // Get initial scores
+    int initialOurScore = evaluatePositionFull<Rule>(scratch, playerMark);
+    int initialOppScore = evaluatePositionFull<Rule>(scratch, opponentMark);
+
+    // With a network, leaves are scored by it from an accumulator that follows the scratch board
+    nnueActive = network && network->getWinLength() == Rule::LENGTH;
+    if (nnueActive) accumulator.refresh<Rule>(scratch, *network);
+
+    // Create a working copy of available moves for minimax
+    std::pmr::set<Cell> searchMoves(availableMoves.begin(), availableMoves.end(), arena.resource());
+
+    // Evaluate all moves using minimax
+    struct MinimaxResult {
+        Cell move;
+        int value;
+        std::size_t lineBegin;  // The replies expected after it, in `lines`
+        int lineLength;
+    };
+    std::pmr::vector<MinimaxResult> results(arena.resource());
+    std::pmr::vector<Cell> lines(arena.resource());
+
+    // Row p of the PV table is the best line from ply p (the root is ply 0)
+    pvTable.resize(static_cast<std::size_t>(searchDepth + 1) * (searchDepth + 1));
+    pvLength.assign(searchDepth + 1, 0);
+
+    // Get top N moves to evaluate with minimax
+    std::pmr::vector<MoveScore> topMoves = getTopNMoves<Rule>(scratch, availableMoves, playerMark, topN, lastMove, 0);
+
+    for (const auto& ms : topMoves) {
+        int x = ms.move.x();
+        int y = ms.move.y();
+
+        // Make move
+        scratch.placeMarkDirect(x, y, playerMark);
+        stats.nodes++;
+
+        // Update search moves
+        searchMoves.erase(ms.move);
+        auto addedMoves = addAdjacentMoves<Rule>(searchMoves, scratch, x, y);
+        if (nnueActive) {
+            accumulator.push<Rule>(scratch, x, y, *network);
+            if (debugMode) verifyAccumulator<Rule>(scratch);
+        }
+
+        // Calculate deltas for this move
+        int ourDelta = ms.ourScore;  // Already calculated in getTopNMoves
+        int oppDelta = ms.oppScore;
+
+        // Run minimax from this position
+        int value;
+        if (searchDepth <= 1) {
+            // Depth 1: just use the heuristic (or network) score
+            value = nnueActive ? nnueScore(opponentMark, playerMark) : ms.score;
+        } else {
+            // Depth > 1: run minimax for opponent's response
+            value = minimax<Rule>(scratch, searchDepth - 1,
+                           std::numeric_limits<int>::min(),
+                           std::numeric_limits<int>::max(),
+                           false,  // Opponent's turn (minimizing)
+                           playerMark, opponentMark,
+                           searchMoves,
+                           initialOurScore + ourDelta,
+                           initialOppScore + oppDelta,
+                           ms.move);
+        }
+
+        // Undo
+        scratch.removeMarkDirect(x, y);
+        if (nnueActive) accumulator.pop();
+        for (const auto& added : addedMoves) {
+            searchMoves.erase(added);
+        }
+        searchMoves.insert(ms.move);
+
+        const int width = searchDepth + 1;
+        const int lineLength = searchDepth <= 1 ? 0 : pvLength[1];
+        results.push_back({ms.move, value, lines.size(), lineLength});
+        lines.insert(lines.end(), pvTable.begin() + width, pvTable.begin() + width + lineLength);
+
+        if (logging()) log("  Move (" + std::to_string(x) + "," + std::to_string(y) + "): minimax value = " + std::to_string(value) + "\n");
+    }
+
+    // Find best move(s)
+    int bestValue = std::numeric_limits<int>::min();
+    std::pmr::vector<Cell> bestMoves(arena.resource());
+
+    for (const auto& result : results) {
+        if (result.value > bestValue) {
+            bestValue = result.value;
+            bestMoves.clear();
+            bestMoves.push_back(result.move);
+        } else if (result.value == bestValue) {
+            bestMoves.push_back(result.move);
+        }
+    }
+
+    if (bestMoves.empty()) {
+        // Fallback - shouldn't happen
+        bestMoves.push_back(*availableMoves.begin());
+    }
+
+    // Random tie-breaking
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(0, bestMoves.size() - 1);
+    auto chosenMove = bestMoves[dis(gen)];
+
+    if (logging()) log("Best value: " + std::to_string(bestValue) + " (" + std::to_string(bestMoves.size()) + " tied)\n"
+        "Selected: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
+
+    // A search over the top-N shortlist proves nothing, so the outcome is left unknown
+    if (analysisCache && !scratch.isWindowed()) analysisCache->store(analysisKey, {chosenMove, bestValue, searchDepth});
+
+    decide("minimax", chosenMove, bestValue);
+    for (const auto& result : results) {
+        if (result.move == chosenMove) {
+            lastAnalysis.principalVariation.insert(lastAnalysis.principalVariation.end(),
+                lines.begin() + result.lineBegin, lines.begin() + result.lineBegin + result.lineLength);
+        }
+    }
+    return chosenMove;
+}
+
+// The variants built on the engine (policies in hybrid_evaluator_ai_v2.h / _v3.h)
+template class HybridEngine<HybridV2Policy>;
+template class HybridEngine<HybridV3Policy>;
@@ -0,0 +1,256 @@
+// Hybrid Engine - Minimax search shared by the v2/v3 hybrid evaluator AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "aiplayer.h"
+#include "ai_utils.h"
+#include "move_frontier.h"
+#include "scratch_board.h"
+#include "search_arena.h"
+#include "line_pattern_cache.h"
+#include "move_policy.h"
+#include "nnue_evaluator.h"
+#include "analysis_cache.h"
+#include "threat_search.h"
+#include <algorithm>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <vector>
+
+class EvaluationWeights;
+class TicTacToeBoard;
+
+// Minimax engine behind HybridEvaluatorAIv2 and v3, which are aliases of HybridEngine<Policy>.
+// Features:
+// - Incremental position evaluation (only affected 11x11 area around moves)
+// - Search runs on a dense scratch copy of the board (no hashing or bounds checks)
+// - Window counts come from SIMD-classified line strips (see line_classifier.h)
+// - Scores of recurring line strips are memoised (see line_pattern_cache.h)
+// - In-place minimax with undo (no board copies during search)
+// - Candidate moves follow the game board through its change listeners (see move_frontier.h);
+//   the cells around each stone that count are configurable (CandidateShape, 8 neighbours by default)
+// - Dead cells (every window through them blocked for both players) are never searched
+// - Transient containers live in a per-search arena (no global allocations once warmed up)
+// - Search kernels are compiled per win length (WinRule<4..7>, 5 by default)
+// - Top-N move pruning for opponent simulation
+// - Optional learned move policy that shortlists candidates before delta scoring (see move_policy.h)
+// - Optional NNUE leaf evaluator with make/unmake accumulator updates (see nnue_evaluator.h)
+// - Optional on-disk cache of root results shared across runs (see analysis_cache.h)
+// - Optional threat-space search proving wins by continuous threats (see threat_search.h)
+// - Configurable search depth (default: 2 = our move + opponent response)
+//
+// Priority system (stages marked * are switched by the policy):
+// 1.    Take winning moves
+// 2.    Block opponent winning moves
+// 2.1*  Win by continuous threats (VCT); the result for each side also decides 2.5 and 2.7
+// 2.2*  Create an open-4 double threat for ourselves (_XXXX_ guarantees win next move)
+// 2.3*  Block opponent from creating an open-4
+// 2.5*  Create a second-order double threat (double open-3 fork)
+// 2.7*  Block opponent second-order double threat
+// 3.    Minimax evaluation
+//
+// With 2.1 enabled the fork stages are proven rather than assumed: a double open-3 that the
+// threat search shows cannot be forced through (for us in 2.5, for the opponent in 2.7) is
+// left to minimax, and 2.7 blocks the fork that starts the opponent's winning line. When the
+// search runs out of budget the fork stages fall back to the plain pattern test.
+//
+// Policy is a struct of compile-time constants:
+//   static constexpr const char* NAME;            // Shown in log output
+//   static constexpr bool THREAT_SEARCH;           // Priority 2.1
+//   static constexpr bool CREATE_OPEN_FOUR;        // Priority 2.2
+//   static constexpr bool BLOCK_OPEN_FOUR;         // Priority 2.3
+//   static constexpr bool CREATE_DOUBLE_OPEN_THREE; // Priority 2.5
+//   static constexpr bool BLOCK_DOUBLE_OPEN_THREE;  // Priority 2.7
+// Disabled stages are discarded with if constexpr. The engine is explicitly instantiated for
+// the v2 and v3 policies in hybrid_engine.cpp; a new variant adds its policy and alias there.
+template <typename Policy>
+class HybridEngine : public AIPlayer {
+private:
+    MoveFrontier frontier;             // Candidate moves, kept in step with the game board
+    const EvaluationWeights* weights;  // Optional custom weights
+    int searchDepth;     // Minimax search depth
+    int topN;            // Number of top moves to consider at each depth
+    bool useAlphaBeta;   // Enable alpha-beta pruning
+    bool debugMode;      // Verify the incremental structures against recomputation
+    int winLength = StandardWinRule::LENGTH;  // Stones in a row needed to win
+    mutable SearchStats stats;  // Counters for the most recent search (updated by const scorers)
+    ScratchBoard scratch;       // Dense search-local board, rebuilt at each findBestMove
+    std::pmr::set<Cell> windowMoves;  // Root candidates inside a windowed scratch board
+    mutable SearchArena arena;  // Memory for the transient containers of one search, reset per move
+    mutable LinePatternCache patternCache;  // Line strip scores for these weights, kept across moves
+    const MovePolicy* movePolicy = nullptr;  // Optional candidate shortlisting (not owned)
+    int policyWidth = 0;                     // Candidates kept by the policy at each node
+    AdaptiveBeam beam;                       // Variable width per node (off by default)
+    const NnueNetwork* network = nullptr;    // Optional leaf evaluator (not owned)
+    bool nnueActive = false;                 // Network in use for the current search
+    NnueAccumulator accumulator;             // Network's first layer, following the scratch board
+    AnalysisCache* analysisCache = nullptr;  // Optional results of earlier searches (not owned)
+    AnalysisCache::Key analysisKey;          // Key of the position being searched
+    ThreatSearch threatSearch;               // Priority 2.1 (policies with THREAT_SEARCH)
+    SearchAnalysis lastAnalysis;             // Stage, score and line of the most recent move
+    std::vector<Cell> pvTable;  // Triangular PV table: row p holds the best line found from ply p
+    std::vector<int> pvLength;  // Moves in each row
+
+    static constexpr int WIN_SCORE = 1000000;  // Score for winning position
+
+    // The search members below are templates on the win rule (see winrule.h); findBestMove
+    // dispatches once on winLength and everything underneath runs with N fixed at compile time.
+
+    // Priorities 1-3 on the scratch board, once it has been loaded
+    template <typename Rule>
+    Cell chooseMove(const TicTacToeBoard& board, char playerMark, Cell lastMove);
+
+    // Record what decided the move (see getLastAnalysis) and return it
+    Cell decide(const char* stage, Cell move, int score = 0) {
+        lastAnalysis.stage = stage;
+        lastAnalysis.score = score;
+        lastAnalysis.principalVariation.assign(1, move);
+        return move;
+    }
+
+    // Row `ply` of the PV table becomes `move` followed by the line below it
+    void recordPv(int ply, Cell move) {
+        const int width = searchDepth + 1;
+        pvTable[ply * width] = move;
+        std::copy_n(&pvTable[(ply + 1) * width], pvLength[ply + 1], &pvTable[ply * width + 1]);
+        pvLength[ply] = pvLength[ply + 1] + 1;
+    }
+
+    // Hash of everything besides the depth that changes what a search returns
+    std::uint64_t analysisContext() const;
+
+    // Network score of the scratch position with `sideToMove` to play, from ourMark's side
+    int nnueScore(char sideToMove, char ourMark) const {
+        const int score = network->evaluate(accumulator, sideToMove);
+        return sideToMove == ourMark ? score : -score;
+    }
+
+    // Helper to check if a move results in a win
+    template <typename Rule>
+    bool isWinningMove(ScratchBoard& board, int x, int y, char playerMark) const;
+
+    // Full board evaluation (for initialization and debugging)
+    template <typename Rule>
+    int evaluatePositionFull(const ScratchBoard& board, char mark) const;
+
+    // Incremental evaluation - returns score for the position considering only
+    // windows that include the move position (x, y)
+    // This evaluates the score contribution of windows in the (2N+1)x(2N+1) area around the move
+    template <typename Rule>
+    int evaluatePositionIncremental(const ScratchBoard& board, int moveX, int moveY, char evalMark) const;
+
+    // Calculate score delta caused by placing a move
+    // Returns: (newScore - oldScore) for the evaluating player
+    template <typename Rule>
+    int calculateScoreDelta(const ScratchBoard& board, int moveX, int moveY,
+                            char moveMark, char evalMark) const;
+
+    // debugMode checks: each incremental structure against a recomputation from scratch.
+    // A mismatch is printed to stderr and counted in SearchStats::debugMismatches.
+    void debugMismatch(const std::string& what) const;
+    // Candidate deltas (pattern cache, masks edited in place) vs strips rescored uncached
+    template <typename Rule>
+    void verifyScoreDeltas(const ScratchBoard& board, Cell move, char moverMark, int ourDelta, int oppDelta) const;
+    // Frontier and live cells vs a frontier built from the board
+    void verifyFrontier(const TicTacToeBoard& board);
+    // Scratch board vs the game board it was loaded from
+    void verifyScratch(const TicTacToeBoard& board);
+    // Accumulator after a push vs a refresh of the whole board
+    template <typename Rule>
+    void verifyAccumulator(const ScratchBoard& board);
+
+    // Minimax with alpha-beta pruning (in-place with undo)
+    template <typename Rule>
+    int minimax(ScratchBoard& board, int depth, int alpha, int beta,
+                bool isMaximizing, char ourMark, char oppMark,
+                std::pmr::set<Cell>& currentMoves,
+                int currentOurScore, int currentOppScore, Cell lastMove);
+
+    // Get top N moves sorted by heuristic score
+    // (lastMove: the move just played, a feature of the move policy; ply: the node's distance
+    // from the root for a search node, which applies the adaptive beam, or -1 for exactly n)
+    template <typename Rule, typename MoveRange>
+    std::pmr::vector<MoveScore> getTopNMoves(const ScratchBoard& board,
+                                              const MoveRange& moves,
+                                              char playerMark, int n,
+                                              Cell lastMove = Cell::none(), int ply = -1) const;
+
+    // The live frontier cells, or the whole frontier if every cell is dead
+    const std::pmr::set<Cell>& frontierMoves() const {
+        return frontier.liveCells().empty() ? frontier.cells() : frontier.liveCells();
+    }
+    // Root candidates: the frontier moves, only those inside the scratch board's window when it
+    // had to leave stones out
+    const std::pmr::set<Cell>& candidateMoves() const {
+        return scratch.isWindowed() ? windowMoves : frontierMoves();
+    }
+
+    // Available moves management during search: the empty cells of the candidate shape
+    // around (x, y) that the board holds, less the dead ones (counted in
+    // stats.deadMovesPruned). Returns vector of positions that were added (for undoing)
+    template <typename Rule>
+    std::pmr::vector<Cell> addAdjacentMoves(
+        std::pmr::set<Cell>& moves,
+        const ScratchBoard& board, int x, int y) const;
+
+    // Every window through the empty cell holds both an X and an O: the MoveFrontier's dead
+    // cells, recognised on the scratch board from the cell's line strips
+    template <typename Rule>
+    static bool isDeadCell(const ScratchBoard& board, Cell cell);
+
+public:
+    // Constructor with all configurable parameters
+    // weights: Optional evaluation weights (nullptr uses defaults)
+    // depth: Search depth (1 = just our move, 2 = our move + opponent response)
+    // topN: Number of top moves to consider at each depth level
+    // useAlphaBeta: Enable alpha-beta pruning (recommended)
+    // debugMode: Verify every incremental structure against recomputation (slow)
+    // verbose: Enable verbose output
+    HybridEngine(const EvaluationWeights* w = nullptr,
+                 int depth = 2,
+                 int topN = 10,
+                 bool useAlphaBeta = true,
+                 bool debugMode = false,
+                 bool verbose = false)
+        : AIPlayer(verbose), weights(w), searchDepth(depth), topN(topN),
+          useAlphaBeta(useAlphaBeta), debugMode(debugMode) {}
+
+    Cell findBestMove(const TicTacToeBoard& board, char playerMark,
+                      Cell lastMove = Cell::none()) override;
+
+    // Configuration setters
+    void setDepth(int depth) { searchDepth = depth; }
+    void setTopN(int n) { topN = n; }
+    void setDebugMode(bool debug) { debugMode = debug; }
+    // Play N-in-a-row instead of five; returns false (and keeps the old length) unless 4 <= N <= 7
+    bool setWinLength(int length);
+    int getWinLength() const { return winLength; }
+    // Shortlist each node's candidates to the `width` best by the policy before delta scoring
+    // (nullptr turns it off; a policy trained for another win length is ignored)
+    void setMovePolicy(const MovePolicy* policy, int width) { movePolicy = policy; policyWidth = width; }
+    // Score minimax leaves with a network instead of the window weights
+    // (nullptr turns it off; a network trained for another win length is ignored)
+    void setNnueNetwork(const NnueNetwork* nnue) { network = nnue; }
+    // Vary the number of moves searched per node with the score gaps (see AdaptiveBeam)
+    void setAdaptiveBeam(const AdaptiveBeam& options) { beam = options; }
+    // Cells around each stone that are candidate moves, at the root and inside the search
+    void setCandidateShape(CandidateShape shape) { frontier.setShape(shape); }
+    CandidateShape getCandidateShape() const { return frontier.getShape(); }
+    // Reuse minimax results at least as deep as searchDepth from the cache, and store new ones
+    // (nullptr turns it off)
+    void setAnalysisCache(AnalysisCache* cache) { analysisCache = cache; }
+
+    // Differential testing (see enginefuzzer.h): the optimised scorers on a scratch copy of
+    // `board`, at the engine's win length
+    int probeFullEvaluation(const TicTacToeBoard& board, char mark);
+    int probeScoreDelta(const TicTacToeBoard& board, Cell move, char moveMark, char evalMark);
+
+    // Counters collected during the most recent findBestMove call
+    const SearchStats& getLastSearchStats() const { return stats; }
+    const SearchAnalysis& getLastAnalysis() const { return lastAnalysis; }
+    const SearchArena& getSearchArena() const { return arena; }
+    const LinePatternCache& getPatternCache() const { return patternCache; }
+};
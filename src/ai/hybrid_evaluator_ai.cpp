@@ -12,19 +12,21 @@
 #include <limits>
 
 // Helper to check if a move results in a win (from SmartRandomAI)
-bool HybridEvaluatorAI::isWinningMove(const TicTacToeBoard& board, int x, int y, char playerMark, int winLength) const {
-    // Create a copy of the board and try the move
-    TicTacToeBoard boardCopy = board;
-    boardCopy.placeMarkDirect(x, y, playerMark);
+template <BoardBackend Board>
+bool BasicHybridEvaluatorAI<Board>::isWinningMove(int x, int y, char playerMark, int winLength) {
+    // Try the move on the working board
+    work.placeMarkDirect(x, y, playerMark);
 
     // Check if this move creates a win using checkWinQuiet with the move position
-    bool wins = boardCopy.checkWinQuiet(x, y, winLength);
+    bool wins = work.checkWinQuiet(x, y, winLength);
 
+    work.removeMarkDirect(x, y);
     return wins;
 }
 
 // Evaluate board position for a given player mark (from MinimaxAI)
-int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark) const
+template <BoardBackend Board>
+int BasicHybridEvaluatorAI<Board>::evaluatePosition(const Board& board, char mark) const
 {
     // Use default weights if none provided
     EvaluationWeights defaultWeights;
@@ -32,20 +34,15 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
 
     int score = 0;
     char opponent = (mark == 'X') ? 'O' : 'X';
-    std::set<std::pair<std::pair<int, int>, std::pair<int, int>>> countedWindows;
-    std::set<std::pair<int, int>> winningMoves;  // Positions that create immediate win
+    std::set<Cell> countedWindows[4];  // Start cell of every window already scored, per direction
+    std::set<Cell> winningMoves;  // Positions that create immediate win
 
     // Directions: horizontal, vertical, diagonal \, diagonal /
     int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
 
-    // Get all occupied positions from the board
-    auto occupiedPositions = board.getOccupiedPositions();
-
     // For each occupied position of our mark, examine 5-cell windows in all directions
-    for (const auto& [pos, m] : occupiedPositions) {
-        if (m != mark) continue;
-
-        int x = pos.first, y = pos.second;
+    board.forEachStone([&](int x, int y, char m) {
+        if (m != mark) return;
 
         for (int d = 0; d < 4; ++d) {
             int dx = directions[d][0];
@@ -60,16 +57,10 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
                 int endX = startX + 4 * dx;
                 int endY = startY + 4 * dy;
 
-                // Create canonical key (normalize by direction and position)
-                // For any window, store it with the lexicographically smaller endpoint first
-                auto p1 = std::make_pair(startX, startY);
-                auto p2 = std::make_pair(endX, endY);
-                std::pair<std::pair<int, int>, std::pair<int, int>> windowKey =
-                    (p1 < p2) ? std::make_pair(p1, p2) : std::make_pair(p2, p1);
-
+                // A window is identified by its direction and start cell
+                // (every direction steps forward in x or y, so the start is always the smaller endpoint)
                 // Skip if already evaluated this window
-                if (countedWindows.count(windowKey) > 0) continue;
-                countedWindows.insert(windowKey);
+                if (!countedWindows[d].insert({startX, startY}).second) continue;
 
                 // Analyze this 5-cell window
                 int friendlyCount = 0;
@@ -80,9 +71,10 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
                     int cellX = startX + k * dx;
                     int cellY = startY + k * dy;
 
-                    if (!board.isPositionOccupied(cellX, cellY)) {
+                    char cell = board.getMark(cellX, cellY);
+                    if (cell == '\0') {
                         emptyCount++;
-                    } else if (occupiedPositions.at({cellX, cellY}) == mark) {
+                    } else if (cell == mark) {
                         friendlyCount++;
                     } else {
                         opponentCount++;
@@ -101,10 +93,8 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
                 int afterX = endX + dx;
                 int afterY = endY + dy;
 
-                bool openBefore = !board.isPositionOccupied(beforeX, beforeY) ||
-                                  occupiedPositions.at({beforeX, beforeY}) != opponent;
-                bool openAfter = !board.isPositionOccupied(afterX, afterY) ||
-                                 occupiedPositions.at({afterX, afterY}) != opponent;
+                bool openBefore = board.getMark(beforeX, beforeY) != opponent;
+                bool openAfter = board.getMark(afterX, afterY) != opponent;
 
                 // Score based on pattern quality
                 int windowScore = 0;
@@ -149,7 +139,7 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
                 score += windowScore;
             }
         }
-    }
+    });
 
     // Apply double threat bonus if we have multiple winning moves
     // This represents positions where opponent cannot defend all threats
@@ -161,8 +151,9 @@ int HybridEvaluatorAI::evaluatePosition(const TicTacToeBoard& board, char mark)
 }
 
 // Find best move using three-level priority system
-std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board, char playerMark,
-                                                     std::pair<int, int> lastMove) {
+template <BoardBackend Board>
+Cell BasicHybridEvaluatorAI<Board>::findBestMove(const TicTacToeBoard& board, char playerMark,
+                                     Cell lastMove) {
     // If board is empty, initialize available moves with origin and return it
     if (board.getOccupiedPositions().empty()) {
         availableMoves.clear();
@@ -171,8 +162,14 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
     }
 
     // Update internal available moves based on lastMove
-    if (lastMove.first != INT_MIN && lastMove.second != INT_MIN) {
-        AIUtils::updateAvailableMoves(availableMoves, board, lastMove.first, lastMove.second);
+    if (windowedMoves) {
+        // Cut down to a window last move: start again from the board
+        auto tempMoves = AIUtils::computeAdjacentMoves(board);
+        availableMoves.clear();
+        availableMoves.insert(tempMoves.begin(), tempMoves.end());
+        windowedMoves = false;
+    } else if (!lastMove.isNone()) {
+        AIUtils::updateAvailableMoves(availableMoves, board, lastMove.x(), lastMove.y());
     } else if (availableMoves.empty()) {
         // First call - compute from board
         auto tempMoves = AIUtils::computeAdjacentMoves(board);
@@ -182,7 +179,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
     // Filter out any occupied positions that may have accumulated
     auto it = availableMoves.begin();
     while (it != availableMoves.end()) {
-        if (board.isPositionOccupied(it->first, it->second)) {
+        if (board.isPositionOccupied(it->x(), it->y())) {
             it = availableMoves.erase(it);
         } else {
             ++it;
@@ -193,14 +190,25 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
         return {0, 0};
     }
 
+    loadBoard(work, board, lastMove);
+
+    // A dense work board windowed around the last move (ScratchBoard::MAX_SPAN) left stones
+    // out. Those still win and must still be blocked, so the first two priorities read the
+    // game board instead; the later ones only try the cells inside the window.
+    bool windowed = false;
+    if constexpr (requires { work.isWindowed(); }) windowed = work.isWindowed();
+    auto completesLine = [&](Cell move, char mark) {
+        return windowed ? board.completesLine(move.x(), move.y(), mark, 5) : isWinningMove(move.x(), move.y(), mark);
+    };
+
     log(std::string("\n[HybridEvaluatorAI - Player ") + playerMark + "]\n"
         "Evaluating " + std::to_string(availableMoves.size()) + " available moves\n");
 
     // PRIORITY LEVEL 1: Check for winning moves
-    std::vector<std::pair<int, int>> winningMoves;
+    std::vector<Cell> winningMoves;
 
     for (const auto& move : availableMoves) {
-        if (isWinningMove(board, move.first, move.second, playerMark)) {
+        if (completesLine(move, playerMark)) {
             winningMoves.push_back(move);
         }
     }
@@ -209,7 +217,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
         {
             std::string msg = "Priority 1: Winning moves - " + std::to_string(winningMoves.size()) + " found\n";
             for (const auto& move : winningMoves)
-                msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
             log(msg);
         }
 
@@ -219,15 +227,15 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
         std::uniform_int_distribution<> dis(0, winningMoves.size() - 1);
         auto winningMove = winningMoves[dis(gen)];
 
-        log("Selected winning move: (" + std::to_string(winningMove.first) + ", " + std::to_string(winningMove.second) + ")\n\n");
+        log("Selected winning move: (" + std::to_string(winningMove.x()) + ", " + std::to_string(winningMove.y()) + ")\n\n");
 
         // Update internal available moves
         availableMoves.erase(winningMove);
 
         // Add adjacent positions
-        for (int i = winningMove.first - 1; i <= winningMove.first + 1; ++i) {
-            for (int j = winningMove.second - 1; j <= winningMove.second + 1; ++j) {
-                if (i == winningMove.first && j == winningMove.second) continue;
+        for (int i = winningMove.x() - 1; i <= winningMove.x() + 1; ++i) {
+            for (int j = winningMove.y() - 1; j <= winningMove.y() + 1; ++j) {
+                if (i == winningMove.x() && j == winningMove.y()) continue;
                 availableMoves.insert({i, j});
             }
         }
@@ -239,10 +247,10 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
 
     // PRIORITY LEVEL 2: Block opponent winning moves
     char opponentMark = (playerMark == 'X') ? 'O' : 'X';
-    std::vector<std::pair<int, int>> blockingMoves;
+    std::vector<Cell> blockingMoves;
 
     for (const auto& move : availableMoves) {
-        if (isWinningMove(board, move.first, move.second, opponentMark)) {
+        if (completesLine(move, opponentMark)) {
             blockingMoves.push_back(move);
         }
     }
@@ -251,7 +259,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
         {
             std::string msg = "Priority 2: Blocking moves - " + std::to_string(blockingMoves.size()) + " found\n";
             for (const auto& move : blockingMoves)
-                msg += "  Blocking threat at (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                msg += "  Blocking threat at (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
             log(msg);
         }
 
@@ -261,15 +269,15 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
         std::uniform_int_distribution<> dis(0, blockingMoves.size() - 1);
         auto blockingMove = blockingMoves[dis(gen)];
 
-        log("Selected blocking move: (" + std::to_string(blockingMove.first) + ", " + std::to_string(blockingMove.second) + ")\n\n");
+        log("Selected blocking move: (" + std::to_string(blockingMove.x()) + ", " + std::to_string(blockingMove.y()) + ")\n\n");
 
         // Update internal available moves
         availableMoves.erase(blockingMove);
 
         // Add adjacent positions
-        for (int i = blockingMove.first - 1; i <= blockingMove.first + 1; ++i) {
-            for (int j = blockingMove.second - 1; j <= blockingMove.second + 1; ++j) {
-                if (i == blockingMove.first && j == blockingMove.second) continue;
+        for (int i = blockingMove.x() - 1; i <= blockingMove.x() + 1; ++i) {
+            for (int j = blockingMove.y() - 1; j <= blockingMove.y() + 1; ++j) {
+                if (i == blockingMove.x() && j == blockingMove.y()) continue;
                 availableMoves.insert({i, j});
             }
         }
@@ -279,15 +287,21 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
 
     log("Priority 2: Blocking moves - 0 found\n");
 
+    if constexpr (requires { work.reaches(0, 0); }) {
+        if (windowed) {
+            std::erase_if(availableMoves, [&](Cell cell) { return !work.reaches(cell.x(), cell.y()); });
+            windowedMoves = true;
+        }
+    }
+
     // PRIORITY LEVEL 2.5: Create a second-order double threat (double open-3 fork)
     // A move that simultaneously creates >= 2 open-3 sequences. The opponent can block
     // at most one, so the other will become a first-order double threat next turn.
     {
-        std::vector<std::pair<int, int>> doubleOpenThreeMoves;
-        TicTacToeBoard boardCopy2 = board;
+        std::vector<Cell> doubleOpenThreeMoves;
 
         for (const auto& move : availableMoves) {
-            if (AIUtils::countOpenThreesAtPosition(boardCopy2, move.first, move.second, playerMark) >= 2) {
+            if (AIUtils::countOpenThreesAtPosition(work, move.x(), move.y(), playerMark) >= 2) {
                 doubleOpenThreeMoves.push_back(move);
             }
         }
@@ -296,7 +310,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
             {
                 std::string msg = "Priority 2.5: Second-order double-threat moves - " + std::to_string(doubleOpenThreeMoves.size()) + " found\n";
                 for (const auto& move : doubleOpenThreeMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -305,12 +319,12 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
             std::uniform_int_distribution<> dis(0, doubleOpenThreeMoves.size() - 1);
             auto chosenMove = doubleOpenThreeMoves[dis(gen)];
 
-            log("Selected second-order double-threat move: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n\n");
+            log("Selected second-order double-threat move: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -323,11 +337,10 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
 
     // PRIORITY LEVEL 2.7: Block opponent second-order double threat
     {
-        std::vector<std::pair<int, int>> blockDoubleOpenThreeMoves;
-        TicTacToeBoard boardCopy3 = board;
+        std::vector<Cell> blockDoubleOpenThreeMoves;
 
         for (const auto& move : availableMoves) {
-            if (AIUtils::countOpenThreesAtPosition(boardCopy3, move.first, move.second, opponentMark) >= 2) {
+            if (AIUtils::countOpenThreesAtPosition(work, move.x(), move.y(), opponentMark) >= 2) {
                 blockDoubleOpenThreeMoves.push_back(move);
             }
         }
@@ -336,7 +349,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
             {
                 std::string msg = "Priority 2.7: Block opponent second-order double-threat - " + std::to_string(blockDoubleOpenThreeMoves.size()) + " found\n";
                 for (const auto& move : blockDoubleOpenThreeMoves)
-                    msg += "  Blocking at (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  Blocking at (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -345,12 +358,12 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
             std::uniform_int_distribution<> dis(0, blockDoubleOpenThreeMoves.size() - 1);
             auto chosenMove = blockDoubleOpenThreeMoves[dis(gen)];
 
-            log("Selected second-order double-threat block: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n\n");
+            log("Selected second-order double-threat block: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -363,7 +376,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
 
     // PRIORITY LEVEL 3: Evaluate all moves using position scoring
     struct MoveScore {
-        std::pair<int, int> move;
+        Cell move;
         int score;
         int ourSeq;
         int oppSeq;
@@ -371,11 +384,10 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
     std::vector<MoveScore> moveScores;
 
     for (const auto& move : availableMoves) {
-        TicTacToeBoard boardCopy = board;
-        boardCopy.placeMarkDirect(move.first, move.second, playerMark);
-
-        int ourScore = evaluatePosition(boardCopy, playerMark);
-        int oppScore = evaluatePosition(boardCopy, opponentMark);
+        work.placeMarkDirect(move.x(), move.y(), playerMark);
+        int ourScore = evaluatePosition(work, playerMark);
+        int oppScore = evaluatePosition(work, opponentMark);
+        work.removeMarkDirect(move.x(), move.y());
         int netScore = ourScore - oppScore;
 
         moveScores.push_back({move, netScore, ourScore, oppScore});
@@ -397,7 +409,7 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
 
     if (!bestMoves.empty()) {
         log("  Best score: " + std::to_string(bestScore) + " (" + std::to_string(bestMoves.size()) + " move(s) tied)\n"
-            "  Top move: (" + std::to_string(bestMoves[0].move.first) + ", " + std::to_string(bestMoves[0].move.second) + ")"
+            "  Top move: (" + std::to_string(bestMoves[0].move.x()) + ", " + std::to_string(bestMoves[0].move.y()) + ")"
             " (Our: " + std::to_string(bestMoves[0].ourSeq) + ", Opp: " + std::to_string(bestMoves[0].oppSeq) + ")\n");
     }
 
@@ -407,18 +419,22 @@ std::pair<int, int> HybridEvaluatorAI::findBestMove(const TicTacToeBoard& board,
     std::uniform_int_distribution<> dis(0, bestMoves.size() - 1);
     auto chosenMove = bestMoves[dis(gen)].move;
 
-    log("Selected: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n\n");
+    log("Selected: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n\n");
 
     // Update internal available moves
     availableMoves.erase(chosenMove);
 
     // Add adjacent positions
-    for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-        for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-            if (i == chosenMove.first && j == chosenMove.second) continue;
+    for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+        for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+            if (i == chosenMove.x() && j == chosenMove.y()) continue;
             availableMoves.insert({i, j});
         }
     }
 
     return chosenMove;
 }
+
+template class BasicHybridEvaluatorAI<TicTacToeBoard>;
+template class BasicHybridEvaluatorAI<HashBoard>;
+template class BasicHybridEvaluatorAI<ScratchBoard>;
@@ -5,30 +5,42 @@
 #pragma once
 
 #include "aiplayer.h"
+#include "board_backend.h"
+#include "hash_board.h"
+#include "scratch_board.h"
+#include "tictactoeboard.h"
 #include <set>
 
 class EvaluationWeights;
-class TicTacToeBoard;
 
 // Hybrid Evaluator AI - Combines tactical play with strategic position evaluation
 // Priority 1: Take winning moves
 // Priority 2: Block opponent winning moves
 // Priority 3: Maximize position score using trainable sequence evaluation
-class HybridEvaluatorAI : public AIPlayer {
+//
+// Each move copies the game board once into a working Board (any BoardBackend, see
+// board_backend.h) and tries candidates on it with make/unmake. Instantiated for
+// TicTacToeBoard, HashBoard and ScratchBoard; HybridEvaluatorAI uses the build's AIBoard.
+template <BoardBackend Board>
+class BasicHybridEvaluatorAI : public AIPlayer {
 private:
-    std::set<std::pair<int, int>> availableMoves;  // Maintained internally by AI
+    std::set<Cell> availableMoves;  // Maintained internally by AI
+    bool windowedMoves = false;     // availableMoves were cut to a windowed work board last move
     const EvaluationWeights* weights;  // Optional custom weights for learning
+    Board work;  // Working copy of the game board for the current move
 
     // Helper to check if a move results in a win (from SmartRandomAI)
-    bool isWinningMove(const TicTacToeBoard& board, int x, int y, char playerMark, int winLength = 5) const;
+    bool isWinningMove(int x, int y, char playerMark, int winLength = 5);
 
     // Evaluate board position using sequence scoring (from MinimaxAI)
-    int evaluatePosition(const TicTacToeBoard& board, char mark) const;
+    int evaluatePosition(const Board& board, char mark) const;
 
 public:
-    HybridEvaluatorAI(const EvaluationWeights* w = nullptr, bool verbose = false)
+    BasicHybridEvaluatorAI(const EvaluationWeights* w = nullptr, bool verbose = false)
         : AIPlayer(verbose), weights(w) {}
 
-    std::pair<int, int> findBestMove(const TicTacToeBoard& board, char playerMark,
-                                      std::pair<int, int> lastMove = {INT_MIN, INT_MIN}) override;
+    Cell findBestMove(const TicTacToeBoard& board, char playerMark,
+                      Cell lastMove = Cell::none()) override;
 };
+
+using HybridEvaluatorAI = BasicHybridEvaluatorAI<AIBoard>;
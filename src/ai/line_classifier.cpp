@@ -0,0 +1,124 @@
+// Line Classifier - Vectorised cell classification for the line strips through a cell
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "line_classifier.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define INFINITTT_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define INFINITTT_X86_SIMD 0
+#endif
+
+namespace {
+
+using ClassifyFn = void (*)(const LineStrips&, char, char, LineMasks*);
+
+// Bits for the strip bytes; the sixteenth byte is alignment only
+constexpr std::uint16_t STRIP_MASK = (1u << LineStrips::MAX_LENGTH) - 1;
+
+void classifyScalar(const LineStrips& strips, char mark, char opponent, LineMasks out[4]) {
+    for (int d = 0; d < 4; ++d) {
+        std::uint16_t friendly = 0, opp = 0;
+        for (int i = 0; i < LineStrips::MAX_LENGTH; ++i) {
+            char cell = strips.cells[d][i];
+            if (cell == mark) friendly |= static_cast<std::uint16_t>(1u << i);
+            else if (cell == opponent) opp |= static_cast<std::uint16_t>(1u << i);
+        }
+        out[d] = {friendly, opp, static_cast<std::uint16_t>(~(friendly | opp) & STRIP_MASK)};
+    }
+}
+
+#if INFINITTT_X86_SIMD
+
+// One 16-byte compare per strip
+__attribute__((target("sse2")))
+void classifySse2(const LineStrips& strips, char mark, char opponent, LineMasks out[4]) {
+    const __m128i vMark = _mm_set1_epi8(mark);
+    const __m128i vOpp = _mm_set1_epi8(opponent);
+    const __m128i vEmpty = _mm_setzero_si128();
+    for (int d = 0; d < 4; ++d) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(strips.cells[d]));
+        out[d].friendly = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vMark)) & STRIP_MASK);
+        out[d].opponent = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vOpp)) & STRIP_MASK);
+        out[d].empty = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, vEmpty)) & STRIP_MASK);
+    }
+}
+
+// Two strips per 32-byte register: all four strips in two loads and six compares
+__attribute__((target("avx2")))
+void classifyAvx2(const LineStrips& strips, char mark, char opponent, LineMasks out[4]) {
+    const __m256i vMark = _mm256_set1_epi8(mark);
+    const __m256i vOpp = _mm256_set1_epi8(opponent);
+    const __m256i vEmpty = _mm256_setzero_si256();
+    for (int pair = 0; pair < 2; ++pair) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(strips.cells[2 * pair]));
+        auto friendly = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vMark)));
+        auto opp = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vOpp)));
+        auto empty = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, vEmpty)));
+        for (int half = 0; half < 2; ++half) {
+            LineMasks& m = out[2 * pair + half];
+            m.friendly = static_cast<std::uint16_t>((friendly >> (16 * half)) & STRIP_MASK);
+            m.opponent = static_cast<std::uint16_t>((opp >> (16 * half)) & STRIP_MASK);
+            m.empty = static_cast<std::uint16_t>((empty >> (16 * half)) & STRIP_MASK);
+        }
+    }
+}
+
+bool cpuSupports(const std::string& name) {
+    __builtin_cpu_init();
+    if (name == "avx2") return __builtin_cpu_supports("avx2");
+    if (name == "sse2") return __builtin_cpu_supports("sse2");
+    return name == "scalar";
+}
+
+#else
+
+bool cpuSupports(const std::string& name) {
+    return name == "scalar";
+}
+
+#endif
+
+struct Implementation {
+    ClassifyFn fn;
+    const char* name;
+};
+
+Implementation selectBest() {
+#if INFINITTT_X86_SIMD
+    if (cpuSupports("avx2")) return {classifyAvx2, "avx2"};
+    if (cpuSupports("sse2")) return {classifySse2, "sse2"};
+#endif
+    return {classifyScalar, "scalar"};
+}
+
+Implementation& current() {
+    static Implementation impl = selectBest();
+    return impl;
+}
+
+} // namespace
+
+namespace LineClassifier {
+
+void classify(const LineStrips& strips, char mark, char opponent, LineMasks out[4]) {
+    current().fn(strips, mark, opponent, out);
+}
+
+const char* implementationName() {
+    return current().name;
+}
+
+bool forceImplementation(const std::string& name) {
+    if (!cpuSupports(name)) return false;
+#if INFINITTT_X86_SIMD
+    if (name == "avx2") { current() = {classifyAvx2, "avx2"}; return true; }
+    if (name == "sse2") { current() = {classifySse2, "sse2"}; return true; }
+#endif
+    current() = {classifyScalar, "scalar"};
+    return true;
+}
+
+} // namespace LineClassifier
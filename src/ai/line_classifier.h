@@ -0,0 +1,64 @@
+// Line Classifier - Vectorised cell classification for the line strips through a cell
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "winrule.h"
+#include <bit>
+#include <cstdint>
+#include <string>
+
+// The four line strips (horizontal, vertical, diagonal \, diagonal /) centred on a cell.
+// For a WinRule<N>, byte i of a strip holds the cell at center + (i - N) * step, so the
+// 2N + 1 bytes cover every N-cell window through the centre plus the cell just outside
+// each end. The remaining bytes up to 16 are zero padding.
+struct LineStrips {
+    static constexpr int MAX_LENGTH = 15;
+    alignas(32) char cells[4][16];
+};
+
+// Per-strip bit masks: bit i describes byte i of the strip (padding bytes read as empty)
+struct LineMasks {
+    std::uint16_t friendly;
+    std::uint16_t opponent;
+    std::uint16_t empty;
+};
+
+namespace LineClassifier {
+    // Copy the four strips through `center` out of a dense board
+    // steps: index delta for one cell along each of the 4 directions
+    template <typename Rule>
+    inline void gather(const char* cells, int center, const int steps[4], LineStrips& strips) {
+        for (int d = 0; d < 4; ++d) {
+            const char* p = cells + center - Rule::STRIP_CENTER * steps[d];
+            for (int i = 0; i < Rule::STRIP_LENGTH; ++i) {
+                strips.cells[d][i] = p[i * steps[d]];
+            }
+            for (int i = Rule::STRIP_LENGTH; i < 16; ++i) {
+                strips.cells[d][i] = 0;
+            }
+        }
+    }
+
+    // Build friendly/opponent/empty masks for all four strips at once.
+    // Dispatches at runtime to an AVX2, SSE2 or scalar implementation.
+    void classify(const LineStrips& strips, char mark, char opponent, LineMasks out[4]);
+
+    // Name of the implementation in use ("avx2", "sse2" or "scalar")
+    const char* implementationName();
+
+    // Force a specific implementation (for benchmarks and cross-checking).
+    // Returns false if the name is unknown or the CPU does not support it.
+    bool forceImplementation(const std::string& name);
+
+    // Number of set bits in the N-cell window starting at strip position `start`
+    template <typename Rule>
+    inline int windowCount(std::uint16_t mask, int start) {
+        return std::popcount(static_cast<unsigned>((mask >> start) & Rule::WINDOW_MASK));
+    }
+
+    inline bool bitSet(std::uint16_t mask, int pos) {
+        return (mask >> pos) & 1u;
+    }
+}
@@ -0,0 +1,66 @@
+// Line Pattern Cache - Memoised window scores of single line strips
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "line_classifier.h"
+#include <array>
+#include <cstdint>
+
+// The score of the N windows through a cell along one direction depends only on that
+// direction's line strip, i.e. on its friendly and opponent masks (2N+1 cells each). The same
+// strips recur constantly across candidates, search nodes and moves, so the v2/v3 evaluators
+// look them up here before scoring the windows. Only the friendly side's windows are scored;
+// the opponent's score is the lookup of the same strip with the masks swapped (its own slot).
+// Direct-mapped: one slot per hash bucket, a colliding pattern simply replaces the old one.
+// Scores depend on the evaluation weights and the win length; the owner clears the cache when
+// either changes. Each slot also keeps the strip's move policy class (see move_policy.h), so
+// ranking a candidate by the policy costs the same four lookups as its "before" score.
+class LinePatternCache {
+public:
+    static constexpr int BITS = 12;  // 4096 slots, 48 KB
+
+    struct Entry {
+        int score;                // Friendly windows only (opponent stones just block them)
+        std::uint8_t policyClass;
+    };
+
+    LinePatternCache() { clear(); }
+
+    void clear() {
+        for (auto& slot : slots) slot.key = EMPTY_KEY;
+    }
+
+    // Entry of the strip, computing it with fillFn(masks) on a miss
+    template <typename FillFn>
+    const Entry& lookup(const LineMasks& masks, FillFn&& fillFn) {
+        const std::uint32_t key = static_cast<std::uint32_t>(masks.friendly) |
+                                  (static_cast<std::uint32_t>(masks.opponent) << 16);
+        Slot& slot = slots[(key * 0x9E3779B1u) >> (32 - BITS)];
+        lookups++;
+        if (slot.key == key) {
+            hits++;
+            return slot.entry;
+        }
+        slot.key = key;
+        slot.entry = fillFn(masks);
+        return slot.entry;
+    }
+
+    long long lookupCount() const { return lookups; }
+    long long hitCount() const { return hits; }
+
+private:
+    // No strip has a cell that is both friendly and opponent, so this key never occurs
+    static constexpr std::uint32_t EMPTY_KEY = 0xFFFFFFFFu;
+
+    struct Slot {
+        std::uint32_t key;
+        Entry entry;
+    };
+
+    std::array<Slot, 1u << BITS> slots;
+    long long lookups = 0;
+    long long hits = 0;
+};
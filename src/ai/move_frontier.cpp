@@ -0,0 +1,187 @@
+// Move Frontier - Candidate moves kept in step with a board through its change listeners
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "move_frontier.h"
+#include "tictactoeboard.h"
+
+namespace {
+
+// Index into the per-colour counters; -1 for anything that is not a player mark
+int colourIndex(char mark) {
+    return mark == 'X' ? 0 : mark == 'O' ? 1 : -1;
+}
+
+} // namespace
+
+const char* candidateShapeName(CandidateShape shape) {
+    switch (shape) {
+        case CandidateShape::LINES_2:  return "lines";
+        case CandidateShape::RADIUS_2: return "r2";
+        default:                       return "r1";
+    }
+}
+
+bool parseCandidateShape(std::string_view name, CandidateShape& shape) {
+    if (name == "r1")         shape = CandidateShape::RADIUS_1;
+    else if (name == "lines") shape = CandidateShape::LINES_2;
+    else if (name == "r2")    shape = CandidateShape::RADIUS_2;
+    else return false;
+    return true;
+}
+
+void MoveFrontier::attach(const TicTacToeBoard& board) {
+    if (board_ == &board) return;
+    detach();
+    board_ = &board;
+    board.subscribe(*this);
+    rebuild(board);
+}
+
+void MoveFrontier::detach() {
+    if (board_) board_->unsubscribe(this);
+    board_ = nullptr;
+}
+
+void MoveFrontier::setWindowLength(int length) {
+    if (length == windowLength) return;
+    windowLength = length;
+    if (board_) rebuild(*board_);
+}
+
+void MoveFrontier::setShape(CandidateShape candidateShape) {
+    if (candidateShape == shape) return;
+    shape = candidateShape;
+    if (board_) rebuild(*board_);
+}
+
+void MoveFrontier::rebuild(const TicTacToeBoard& board) {
+    frontier.clear();
+    live.clear();
+    clearTiles();
+    for (const auto& [pos, mark] : board.getOccupiedPositions()) {
+        onPlace(board, pos, mark);
+    }
+}
+
+void MoveFrontier::clearTiles() {
+    tiles.clear();
+    tileTable.assign(16, TileSlot{});
+    tableShift = 64 - 4;
+    lastKey = FREE_TILE;
+    lastTile = NO_TILE;
+}
+
+// Fibonacci hashing and linear probing, as in HashBoard
+std::uint32_t MoveFrontier::findTile(std::uint64_t key) const {
+    if (key == lastKey) return lastTile;
+    if (tileTable.empty()) return NO_TILE;
+    const std::size_t mask = tileTable.size() - 1;
+    for (std::size_t i = (key * 0x9E3779B97F4A7C15ull) >> tableShift;; i = (i + 1) & mask) {
+        if (tileTable[i].key == key) {
+            lastKey = key;
+            lastTile = tileTable[i].tile;
+            return lastTile;
+        }
+        if (tileTable[i].key == FREE_TILE) return NO_TILE;
+    }
+}
+
+void MoveFrontier::ensureCovers(Cell cell) {
+    if (tileTable.empty()) clearTiles();
+    for (int ty = (cell.y() - MARGIN) >> TILE_SHIFT; ty <= (cell.y() + MARGIN) >> TILE_SHIFT; ++ty) {
+        for (int tx = (cell.x() - MARGIN) >> TILE_SHIFT; tx <= (cell.x() + MARGIN) >> TILE_SHIFT; ++tx) {
+            const std::uint64_t key = Cell(tx, ty).packed();
+            if (findTile(key) != NO_TILE) continue;
+
+            if (2 * (tiles.size() + 1) > tileTable.size()) {
+                std::vector<TileSlot> old(2 * tileTable.size());
+                old.swap(tileTable);
+                tableShift--;
+                const std::size_t mask = tileTable.size() - 1;
+                for (const TileSlot& slot : old) {
+                    if (slot.key == FREE_TILE) continue;
+                    std::size_t i = (slot.key * 0x9E3779B97F4A7C15ull) >> tableShift;
+                    while (tileTable[i].key != FREE_TILE) i = (i + 1) & mask;
+                    tileTable[i] = slot;
+                }
+            }
+            const std::size_t mask = tileTable.size() - 1;
+            std::size_t i = (key * 0x9E3779B97F4A7C15ull) >> tableShift;
+            while (tileTable[i].key != FREE_TILE) i = (i + 1) & mask;
+            tileTable[i] = {key, static_cast<std::uint32_t>(tiles.size())};
+            tiles.emplace_back();
+        }
+    }
+}
+
+bool MoveFrontier::isDead(Cell cell) const {
+    const CellCounts& counts = at(cell);
+    const int windows = 4 * windowLength;
+    return counts.blockedWindows[0] == windows && counts.blockedWindows[1] == windows;
+}
+
+void MoveFrontier::refresh(Cell cell) {
+    if (at(cell).nearbyStones > 0 && frontier.count(cell) && !isDead(cell)) live.insert(cell);
+    else live.erase(cell);
+}
+
+// A window changes state only when it gains its first, or loses its last, stone of a colour
+void MoveFrontier::updateWindows(Cell cell, int colour, bool placed) {
+    const int windows = 4 * windowLength;
+    for (int d = 0; d < 4; ++d) {
+        const int dx = DIRECTIONS[d][0], dy = DIRECTIONS[d][1];
+        for (int k = 0; k < windowLength; ++k) {
+            Cell start = cell.offset(-k * dx, -k * dy);
+            std::uint8_t& count = at(start).windowStones[d][colour];
+            bool flipped = placed ? count++ == 0 : --count == 0;
+            if (!flipped) continue;
+
+            for (int j = 0; j < windowLength; ++j) {
+                Cell member = start.offset(j * dx, j * dy);
+                std::uint8_t& blocked = at(member).blockedWindows[colour];
+                if (placed) {
+                    if (++blocked == windows) refresh(member);
+                } else {
+                    if (blocked-- == windows) refresh(member);
+                }
+            }
+        }
+    }
+}
+
+void MoveFrontier::onPlace(const TicTacToeBoard& board, Cell cell, char mark) {
+    ensureCovers(cell);
+    frontier.erase(cell);
+    live.erase(cell);
+    for (const auto [dx, dy] : candidateOffsets(shape)) {
+        Cell near = cell.offset(dx, dy);
+        at(near).nearbyStones++;
+        if (!board.isPositionOccupied(near) && frontier.insert(near).second && !isDead(near)) {
+            live.insert(near);
+        }
+    }
+
+    int colour = colourIndex(mark);
+    if (colour >= 0) updateWindows(cell, colour, true);
+}
+
+void MoveFrontier::onRemove(const TicTacToeBoard&, Cell cell, char mark) {
+    for (const auto [dx, dy] : candidateOffsets(shape)) {
+        Cell near = cell.offset(dx, dy);
+        if (--at(near).nearbyStones == 0) {
+            frontier.erase(near);
+            live.erase(near);
+        }
+    }
+    // The emptied cell is a candidate again if another stone is still near it
+    if (at(cell).nearbyStones > 0) frontier.insert(cell);
+
+    int colour = colourIndex(mark);
+    if (colour >= 0) updateWindows(cell, colour, false);
+    refresh(cell);
+}
+
+void MoveFrontier::onReset(const TicTacToeBoard& board) {
+    rebuild(board);
+}
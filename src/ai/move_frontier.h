@@ -0,0 +1,161 @@
+// Move Frontier - Candidate moves kept in step with a board through its change listeners
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "winrule.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <set>
+#include <span>
+#include <string_view>
+#include <vector>
+
+class TicTacToeBoard;
+
+// Which empty cells near a stone are candidate moves
+enum class CandidateShape {
+    RADIUS_1,  // The 8 neighbours (what every AI uses by default)
+    LINES_2,   // Up to two steps along the 4 line directions (16 cells)
+    RADIUS_2   // The 5x5 square around the stone (24 cells)
+};
+
+struct CandidateOffset {
+    int dx, dy;
+};
+
+// Offsets of the shapes' cells from the stone. They are ordered so that every shape is a prefix:
+// the 8 neighbours, then the second step along each line, then the rest of the 5x5 square.
+inline constexpr CandidateOffset CANDIDATE_OFFSETS[24] = {
+    {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1},
+    {-2, -2}, {-2, 0}, {-2, 2}, {0, -2}, {0, 2}, {2, -2}, {2, 0}, {2, 2},
+    {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+
+inline std::span<const CandidateOffset> candidateOffsets(CandidateShape shape) {
+    const std::size_t count = shape == CandidateShape::RADIUS_1 ? 8 : shape == CandidateShape::LINES_2 ? 16 : 24;
+    return {CANDIDATE_OFFSETS, count};
+}
+
+// Furthest any shape's cell lies from its stone along either axis
+inline constexpr int CANDIDATE_REACH = [] {
+    int reach = 0;
+    for (const auto [dx, dy] : CANDIDATE_OFFSETS) reach = std::max({reach, dx, -dx, dy, -dy});
+    return reach;
+}();
+
+// Command-line names: "r1", "lines", "r2"
+const char* candidateShapeName(CandidateShape shape);
+bool parseCandidateShape(std::string_view name, CandidateShape& shape);
+
+// The empty cells near at least one stone (the stone's CandidateShape, by default its 8
+// neighbours), which is where every AI looks for moves.
+// Once attached, the frontier subscribes to the board and updates itself on each place/remove
+// in O(shape) set operations: every such cell keeps a count of the stones it is near, so undoing
+// a move retracts exactly the cells that only that stone was supporting. Wider shapes add cells
+// that are mostly dead, so liveCells() grows far less than cells() does.
+// The frontier follows one board at a time; attaching to another board rebuilds it.
+//
+// Dead cells
+// A window (N cells in a row, N = window length) is live for a player while it holds no
+// opponent stone. A cell whose windows are all dead for both players can never be part of a
+// win or a threat, and every evaluation delta there is zero, so liveCells() leaves it out.
+// Per window the frontier keeps the number of X and O stones; per cell, how many of its 4N
+// windows hold at least one X and at least one O. A place/remove touches the 4N windows through
+// the stone and, when a window gains its first or loses its last stone of a colour, its N cells.
+//
+// The counters live in 16x16 tiles created the first time a stone comes within MARGIN of them
+// and found through a small open-addressing table keyed by the tile coordinate. Memory follows
+// the cells near stones, not their bounding box, so stones far apart cost no more than stones
+// close together; a stone adds at most four tiles, so the listeners only ever grow the storage
+// by a few kilobytes. Consecutive lookups mostly land in the same tile, which is remembered.
+class MoveFrontier {
+public:
+    MoveFrontier() = default;
+    MoveFrontier(const MoveFrontier&) = delete;
+    MoveFrontier& operator=(const MoveFrontier&) = delete;
+    ~MoveFrontier() { detach(); }
+
+    // Rebuild from the board and follow its changes from now on
+    void attach(const TicTacToeBoard& board);
+    void detach();
+    bool isAttachedTo(const TicTacToeBoard& board) const { return board_ == &board; }
+
+    // Length of the windows used for dead-cell detection (the game's win length)
+    void setWindowLength(int length);
+    // Cells around each stone that become candidates (rebuilds when it changes)
+    void setShape(CandidateShape candidateShape);
+    CandidateShape getShape() const { return shape; }
+
+    // Empty cells near a stone, in Cell order
+    const std::pmr::set<Cell>& cells() const { return frontier; }
+    // The same without dead cells
+    const std::pmr::set<Cell>& liveCells() const { return live; }
+    std::size_t deadCount() const { return frontier.size() - live.size(); }
+
+    // Board listener interface
+    void onPlace(const TicTacToeBoard& board, Cell cell, char mark);
+    void onRemove(const TicTacToeBoard& board, Cell cell, char mark);
+    void onReset(const TicTacToeBoard& board);
+    void onDetach() { board_ = nullptr; }
+
+private:
+    static constexpr int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    // Every counter an update touches lies within this many cells of the stone
+    static constexpr int MARGIN = WinRule<7>::LENGTH;
+
+    struct CellCounts {
+        std::uint8_t nearbyStones = 0;        // Stones whose shape covers the cell
+        std::uint8_t blockedWindows[2] = {};  // Windows through the cell holding an X / an O
+        std::uint8_t windowStones[4][2] = {}; // Window starting here, per direction: X / O stones
+    };
+
+    const TicTacToeBoard* board_ = nullptr;
+    int windowLength = StandardWinRule::LENGTH;
+    CandidateShape shape = CandidateShape::RADIUS_1;
+    std::pmr::unsynchronized_pool_resource pool;  // Recycles nodes as cells enter and leave
+    std::pmr::set<Cell> frontier{&pool};
+    std::pmr::set<Cell> live{&pool};
+
+    static constexpr int TILE_SHIFT = 4;
+    static constexpr int TILE = 1 << TILE_SHIFT;
+    static constexpr std::uint64_t FREE_TILE = 0;  // Key of Cell::none(), never a tile coordinate
+    static constexpr std::uint32_t NO_TILE = ~0u;
+
+    struct Tile {
+        CellCounts cells[TILE * TILE];
+    };
+    struct TileSlot {
+        std::uint64_t key = FREE_TILE;  // Packed (x >> TILE_SHIFT, y >> TILE_SHIFT)
+        std::uint32_t tile = 0;         // Index into `tiles`
+    };
+
+    std::vector<Tile> tiles;
+    std::vector<TileSlot> tileTable;  // Power-of-two size, at most half full
+    int tableShift = 64;              // 64 - log2(tileTable.size())
+    mutable std::uint64_t lastKey = FREE_TILE;
+    mutable std::uint32_t lastTile = NO_TILE;
+
+    static std::uint64_t tileKey(Cell cell) { return Cell(cell.x() >> TILE_SHIFT, cell.y() >> TILE_SHIFT).packed(); }
+    static std::size_t cellIndex(Cell cell) { return ((cell.y() & (TILE - 1)) << TILE_SHIFT) | (cell.x() & (TILE - 1)); }
+    std::uint32_t findTile(std::uint64_t key) const;  // NO_TILE if the tile does not exist
+
+    // Counters of a cell within MARGIN of a stone (its tile exists)
+    CellCounts& at(Cell cell) { return tiles[findTile(tileKey(cell))].cells[cellIndex(cell)]; }
+    // Counters of any cell; all zero where no stone was ever near
+    const CellCounts& at(Cell cell) const {
+        static const CellCounts NONE;
+        const std::uint32_t tile = findTile(tileKey(cell));
+        return tile == NO_TILE ? NONE : tiles[tile].cells[cellIndex(cell)];
+    }
+    void ensureCovers(Cell cell);  // Create the tiles of everything within MARGIN of cell
+    void clearTiles();
+
+    void rebuild(const TicTacToeBoard& board);
+    void updateWindows(Cell cell, int colour, bool placed);
+    bool isDead(Cell cell) const;
+    void refresh(Cell cell);  // Re-derive the cell's membership in `live`
+};
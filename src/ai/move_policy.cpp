@@ -0,0 +1,182 @@
+// Move Policy - Learned move ordering from local line patterns
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "move_policy.h"
+#include "scratch_board.h"
+#include "tictactoeboard.h"
+#include "gamerecord.h"
+#include <cmath>
+#include <fstream>
+#include <set>
+
+MovePolicy::MovePolicy(int winLength) : winLength(winLength) {
+    // Untrained prior: longer lines through the cell first, ours and theirs alike
+    for (int ours = 0; ours < LEVELS; ++ours) {
+        for (int theirs = 0; theirs < LEVELS; ++theirs) {
+            lineWeights[ours * LEVELS + theirs] = static_cast<float>(ours + theirs);
+        }
+    }
+    updateContentHash();
+}
+
+void MovePolicy::updateContentHash() {
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    auto add = [&](const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) h = (h ^ bytes[i]) * 0x100000001B3ull;
+    };
+    add(&winLength, sizeof(winLength));
+    add(lineWeights, sizeof(lineWeights));
+    add(distanceWeights, sizeof(distanceWeights));
+    digest = h;
+}
+
+bool MovePolicy::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+
+    file << "movepolicy " << winLength << "\n";
+    for (int i = 0; i < LINE_CLASSES; ++i) file << lineWeights[i] << (i + 1 < LINE_CLASSES ? ' ' : '\n');
+    for (int i = 0; i < DISTANCE_BUCKETS; ++i) file << distanceWeights[i] << (i + 1 < DISTANCE_BUCKETS ? ' ' : '\n');
+    return file.good();
+}
+
+bool MovePolicy::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+
+    std::string tag;
+    int length = 0;
+    if (!(file >> tag >> length) || tag != "movepolicy" || !isSupportedWinLength(length)) return false;
+
+    MovePolicy loaded(length);
+    for (float& w : loaded.lineWeights) if (!(file >> w)) return false;
+    for (float& w : loaded.distanceWeights) if (!(file >> w)) return false;
+    loaded.updateContentHash();
+    *this = loaded;
+    return true;
+}
+
+namespace {
+
+// One recorded position: the features of every candidate and which one was played
+struct PolicySample {
+    std::size_t first;  // Index of the first candidate in the shared feature array
+    int count;
+    int chosen;         // Offset of the played move among the candidates
+};
+
+// Replay the games and collect a sample for every position where the played move was a
+// frontier cell (the opening move and far-away moves have nothing to rank against)
+template <typename Rule>
+void collectSamples(const std::vector<GameRecord>& games, std::size_t begin, std::size_t end,
+                    std::vector<PolicyFeatures>& features, std::vector<PolicySample>& samples) {
+    static constexpr int NEIGHBOURS[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                             {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+    ScratchBoard board;
+    LineStrips strips;
+    LineMasks masks[4];
+
+    for (std::size_t g = begin; g < end; ++g) {
+        const auto& moves = games[g].moves;
+        TicTacToeBoard empty;
+        board.loadFrom(empty);
+        std::set<Cell> frontier;
+
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            const Cell move = moves[i];
+            const char mover = GameRecord::moverOf(i);
+            const char opponent = mover == 'X' ? 'O' : 'X';
+            if (board.isPositionOccupied(move.x(), move.y())) break;  // Corrupt record
+
+            if (frontier.count(move)) {
+                PolicySample sample{features.size(), 0, -1};
+                const Cell lastMove = i > 0 ? moves[i - 1] : Cell::none();
+                for (const auto& candidate : frontier) {
+                    if (candidate == move) sample.chosen = sample.count;
+                    board.gatherStrips<Rule>(board.index(candidate.x(), candidate.y()), strips);
+                    LineClassifier::classify(strips, mover, opponent, masks);
+                    features.push_back(MovePolicy::features<Rule>(masks, candidate, lastMove));
+                    sample.count++;
+                }
+                samples.push_back(sample);
+            }
+
+            board.placeMarkDirect(move.x(), move.y(), mover);
+            frontier.erase(move);
+            for (const auto& n : NEIGHBOURS) {
+                Cell neighbour = move.offset(n[0], n[1]);
+                if (!board.isPositionOccupied(neighbour.x(), neighbour.y())) frontier.insert(neighbour);
+            }
+        }
+    }
+}
+
+} // namespace
+
+MovePolicy::TrainingReport MovePolicy::train(const std::vector<GameRecord>& games, int epochs,
+                                             double learningRate, double holdout) {
+    TrainingReport report;
+    const std::size_t testBegin = games.size() - static_cast<std::size_t>(games.size() * holdout);
+
+    std::vector<PolicyFeatures> trainFeatures, testFeatures;
+    std::vector<PolicySample> trainSamples, testSamples;
+    withWinRule(winLength, [&](auto rule) {
+        using Rule = decltype(rule);
+        collectSamples<Rule>(games, 0, testBegin, trainFeatures, trainSamples);
+        collectSamples<Rule>(games, testBegin, games.size(), testFeatures, testSamples);
+    });
+    report.trainPositions = static_cast<int>(trainSamples.size());
+    report.testPositions = static_cast<int>(testSamples.size());
+
+    // Stochastic gradient ascent on the log-likelihood of the played moves
+    std::vector<double> probabilities;
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        for (const auto& sample : trainSamples) {
+            const PolicyFeatures* candidates = &trainFeatures[sample.first];
+            probabilities.resize(sample.count);
+
+            double maxScore = -1e30, total = 0.0;
+            for (int c = 0; c < sample.count; ++c) maxScore = std::max(maxScore, double(score(candidates[c])));
+            for (int c = 0; c < sample.count; ++c) {
+                probabilities[c] = std::exp(score(candidates[c]) - maxScore);
+                total += probabilities[c];
+            }
+
+            for (int c = 0; c < sample.count; ++c) {
+                const float step = static_cast<float>(learningRate *
+                    ((c == sample.chosen ? 1.0 : 0.0) - probabilities[c] / total));
+                for (std::uint8_t line : candidates[c].line) lineWeights[line] += step;
+                distanceWeights[candidates[c].distance] += step;
+            }
+        }
+    }
+
+    // Rank of the played move among the candidates of each held-out position
+    static constexpr int K[4] = {1, 3, 5, 10};
+    std::vector<int> ranks;
+    long long candidateTotal = 0;
+    for (const auto& sample : testSamples) {
+        const PolicyFeatures* candidates = &testFeatures[sample.first];
+        const float chosenScore = score(candidates[sample.chosen]);
+        int rank = 1;
+        for (int c = 0; c < sample.count; ++c) {
+            if (c != sample.chosen && score(candidates[c]) >= chosenScore) rank++;
+        }
+        ranks.push_back(rank);
+        candidateTotal += sample.count;
+    }
+
+    if (!ranks.empty()) {
+        report.averageCandidates = static_cast<double>(candidateTotal) / ranks.size();
+        for (int k = 0; k < 4; ++k) {
+            report.topK[k] = static_cast<double>(std::count_if(ranks.begin(), ranks.end(),
+                [&](int rank) { return rank <= K[k]; })) / ranks.size();
+        }
+        std::sort(ranks.begin(), ranks.end());
+        report.widthFor95 = ranks[static_cast<std::size_t>(std::ceil(0.95 * ranks.size())) - 1];
+    }
+    updateContentHash();
+    return report;
+}
@@ -0,0 +1,351 @@
+// NNUE Evaluator - Small quantised network over window patterns, updated incrementally
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "nnue_evaluator.h"
+#include "tictactoeboard.h"
+#include "gamerecord.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define INFINITTT_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define INFINITTT_X86_SIMD 0
+#endif
+
+namespace {
+
+constexpr char WEIGHTS_MAGIC[8] = {'I', 'T', 'T', 'N', 'N', 'U', 'W', '1'};
+constexpr char DATA_MAGIC[8] = {'I', 'T', 'T', 'N', 'N', 'U', 'D', '1'};
+constexpr int INPUTS = 2 * NnueNetwork::HIDDEN;
+
+// Dot product of the clipped accumulators (0..QA) with the int8 output weights
+using DotFn = int (*)(const std::uint8_t* inputs, const std::int8_t* weights);
+
+int dotScalar(const std::uint8_t* inputs, const std::int8_t* weights) {
+    int sum = 0;
+    for (int i = 0; i < INPUTS; ++i) sum += inputs[i] * weights[i];
+    return sum;
+}
+
+#if INFINITTT_X86_SIMD
+
+// Widen both sides to int16 and multiply-add pairs into int32
+__attribute__((target("sse2")))
+int dotSse2(const std::uint8_t* inputs, const std::int8_t* weights) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int i = 0; i < INPUTS; i += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputs + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        __m128i wLo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        __m128i wHi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(in, zero), wLo));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(in, zero), wHi));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// u8 x s8 multiply-add of 32 pairs per instruction; inputs <= 127 keep the int16 sums exact
+__attribute__((target("avx2")))
+int dotAvx2(const std::uint8_t* inputs, const std::int8_t* weights) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < INPUTS; i += 32) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+}
+
+DotFn selectDot() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return dotAvx2;
+    if (__builtin_cpu_supports("sse2")) return dotSse2;
+    return dotScalar;
+}
+
+#else
+
+DotFn selectDot() {
+    return dotScalar;
+}
+
+#endif
+
+DotFn dot() {
+    static DotFn fn = selectDot();
+    return fn;
+}
+
+// Window code with the friendly and opponent digits exchanged (the other player's view)
+std::vector<std::uint16_t> swappedCodes(int winLength) {
+    const int count = Nnue::powerOfThree(winLength);
+    std::vector<std::uint16_t> swapped(count);
+    for (int code = 0; code < count; ++code) {
+        int value = 0;
+        for (int k = 0, rest = code, power = 1; k < winLength; ++k, rest /= 3, power *= 3) {
+            const int digit = rest % 3;
+            value += (digit == 0 ? 0 : 3 - digit) * power;
+        }
+        swapped[code] = static_cast<std::uint16_t>(value);
+    }
+    return swapped;
+}
+
+template <typename T>
+void writeRaw(std::ofstream& file, const T* data, std::size_t count) {
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+bool readRaw(std::ifstream& file, T* data, std::size_t count) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count)));
+}
+
+} // namespace
+
+NnueNetwork::NnueNetwork(int winLength)
+    : winLength(winLength), codeCount(Nnue::powerOfThree(winLength)),
+      inputWeights(static_cast<std::size_t>(codeCount) * HIDDEN, 0) {
+    updateContentHash();
+}
+
+void NnueNetwork::updateContentHash() {
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    auto add = [&](const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) h = (h ^ bytes[i]) * 0x100000001B3ull;
+    };
+    add(&winLength, sizeof(winLength));
+    add(inputWeights.data(), inputWeights.size() * sizeof(std::int16_t));
+    add(inputBiases.data(), sizeof(inputBiases));
+    add(outputWeights, sizeof(outputWeights));
+    add(&outputBias, sizeof(outputBias));
+    digest = h;
+}
+
+bool NnueNetwork::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    const std::uint32_t header[2] = {static_cast<std::uint32_t>(winLength), HIDDEN};
+    writeRaw(file, WEIGHTS_MAGIC, 8);
+    writeRaw(file, header, 2);
+    writeRaw(file, inputWeights.data(), inputWeights.size());
+    writeRaw(file, inputBiases.data(), HIDDEN);
+    writeRaw(file, outputWeights, INPUTS);
+    writeRaw(file, &outputBias, 1);
+    return file.good();
+}
+
+bool NnueNetwork::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[8];
+    std::uint32_t header[2];
+    if (!readRaw(file, magic, 8) || std::memcmp(magic, WEIGHTS_MAGIC, 8) != 0) return false;
+    if (!readRaw(file, header, 2) || !isSupportedWinLength(static_cast<int>(header[0])) ||
+        header[1] != HIDDEN) return false;
+
+    NnueNetwork loaded(static_cast<int>(header[0]));
+    if (!readRaw(file, loaded.inputWeights.data(), loaded.inputWeights.size()) ||
+        !readRaw(file, loaded.inputBiases.data(), HIDDEN) ||
+        !readRaw(file, loaded.outputWeights, INPUTS) ||
+        !readRaw(file, &loaded.outputBias, 1)) return false;
+    loaded.updateContentHash();
+    *this = std::move(loaded);
+    return true;
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator& accumulator, char sideToMove) const {
+    const auto& values = accumulator.top().values;
+    const int us = (sideToMove == 'X') ? 0 : 1;
+
+    // Clipped ReLU into bytes: the side to move's accumulator first
+    alignas(32) std::uint8_t inputs[INPUTS];
+    for (int j = 0; j < HIDDEN; ++j) {
+        inputs[j] = static_cast<std::uint8_t>(std::clamp<int>(values[us][j], 0, QA));
+        inputs[HIDDEN + j] = static_cast<std::uint8_t>(std::clamp<int>(values[1 - us][j], 0, QA));
+    }
+
+    const long long logit = static_cast<long long>(dot()(inputs, outputWeights)) + outputBias;
+    return static_cast<int>(logit * OUTPUT_SCALE / (QA * QB));
+}
+
+long long NnueNetwork::exportTrainingData(const std::vector<GameRecord>& games, int winLength,
+                                          const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return -1;
+
+    const std::uint32_t length = static_cast<std::uint32_t>(winLength);
+    writeRaw(file, DATA_MAGIC, 8);
+    writeRaw(file, &length, 1);
+
+    long long positions = 0;
+    ScratchBoard board;
+    std::vector<std::uint16_t> codes;
+    const TicTacToeBoard empty;
+
+    withWinRule(winLength, [&](auto rule) {
+        using Rule = decltype(rule);
+        for (const auto& game : games) {
+            board.loadFrom(empty);
+            for (std::size_t i = 0; i < game.moves.size(); ++i) {
+                const char mover = GameRecord::moverOf(i);
+                const Cell move = game.moves[i];
+                if (board.isPositionOccupied(move.x(), move.y())) break;  // Corrupt record
+
+                if (!board.empty()) {
+                    codes.clear();
+                    Nnue::forEachWindow<Rule>(board, [&](int codeX, int codeO) {
+                        codes.push_back(static_cast<std::uint16_t>(mover == 'X' ? codeX : codeO));
+                    });
+                    const std::int8_t result = game.winner == mover ? 1 : (game.winner == 'D' ? 0 : -1);
+                    const std::uint8_t reserved = 0;
+                    const std::uint16_t count = static_cast<std::uint16_t>(std::min<std::size_t>(codes.size(), 0xFFFF));
+                    writeRaw(file, &result, 1);
+                    writeRaw(file, &reserved, 1);
+                    writeRaw(file, &count, 1);
+                    writeRaw(file, codes.data(), count);
+                    positions++;
+                }
+                board.placeMarkDirect(move.x(), move.y(), mover);
+            }
+        }
+    });
+    return file.good() ? positions : -1;
+}
+
+bool NnueNetwork::train(const std::string& dataFilename, int epochs, NnueNetwork& network,
+                        TrainingReport& report) {
+    std::ifstream file(dataFilename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[8];
+    std::uint32_t length = 0;
+    if (!readRaw(file, magic, 8) || std::memcmp(magic, DATA_MAGIC, 8) != 0) return false;
+    if (!readRaw(file, &length, 1) || !isSupportedWinLength(static_cast<int>(length))) return false;
+
+    // Positions: target in [0, 1] and the range of their codes in one flat array
+    struct Position {
+        float target;
+        std::size_t first;
+        std::uint16_t count;
+    };
+    std::vector<Position> positions;
+    std::vector<std::uint16_t> codes;
+    std::int8_t result;
+    std::uint8_t reserved;
+    std::uint16_t count;
+    // Codes index weight rows, so a file with one out of range is rejected rather than trained on
+    const int codeLimit = Nnue::powerOfThree(static_cast<int>(length));
+    while (readRaw(file, &result, 1) && readRaw(file, &reserved, 1) && readRaw(file, &count, 1)) {
+        if (result < -1 || result > 1) return false;
+        positions.push_back({(result + 1) / 2.0f, codes.size(), count});
+        codes.resize(codes.size() + count);
+        if (!readRaw(file, codes.data() + positions.back().first, count)) return false;
+        for (std::size_t i = positions.back().first; i < codes.size(); ++i) {
+            if (codes[i] >= codeLimit) return false;
+        }
+    }
+
+    network = NnueNetwork(static_cast<int>(length));
+    report = TrainingReport();
+    report.positions = static_cast<long long>(positions.size());
+    const std::vector<std::uint16_t> swapped = swappedCodes(network.winLength);
+
+    // Float model with the same shape: a = b1 + sum of rows, h = clamp(a, 0, 1),
+    // logit = b2 + w2 . [h_us, h_them]
+    std::mt19937 rng(20240601);
+    // A position has hundreds of windows, so rows start tiny and hidden units start mid-range
+    std::uniform_real_distribution<float> small(-0.002f, 0.002f), outInit(-0.5f, 0.5f);
+    std::vector<float> w1(network.inputWeights.size());
+    for (float& w : w1) w = small(rng);
+    std::vector<float> b1(HIDDEN, 0.5f), w2(INPUTS);
+    for (float& w : w2) w = outInit(rng);
+    float b2 = 0.0f;
+    const float maxOutputWeight = 127.0f / QB;
+
+    std::vector<float> a(INPUTS), h(INPUTS), gradA(INPUTS);
+    auto forward = [&](const Position& p) {
+        for (int j = 0; j < HIDDEN; ++j) a[j] = a[HIDDEN + j] = b1[j];
+        for (std::size_t i = p.first; i < p.first + p.count; ++i) {
+            const float* us = &w1[codes[i] * HIDDEN];
+            const float* them = &w1[swapped[codes[i]] * HIDDEN];
+            for (int j = 0; j < HIDDEN; ++j) { a[j] += us[j]; a[HIDDEN + j] += them[j]; }
+        }
+        float logit = b2;
+        for (int j = 0; j < INPUTS; ++j) {
+            h[j] = std::clamp(a[j], 0.0f, 1.0f);
+            logit += w2[j] * h[j];
+        }
+        return 1.0f / (1.0f + std::exp(-logit));
+    };
+    auto meanLoss = [&] {
+        double total = 0.0;
+        for (const auto& p : positions) {
+            const float error = forward(p) - p.target;
+            total += error * error;
+        }
+        return positions.empty() ? 0.0 : total / positions.size();
+    };
+
+    report.initialLoss = meanLoss();
+    std::vector<std::size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    const float learningRate = 0.01f;
+
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        for (std::size_t index : order) {
+            const Position& p = positions[index];
+            const float predicted = forward(p);
+            const float gradLogit = 2.0f * (predicted - p.target) * predicted * (1.0f - predicted);
+
+            for (int j = 0; j < INPUTS; ++j) {
+                gradA[j] = (a[j] > 0.0f && a[j] < 1.0f) ? gradLogit * w2[j] : 0.0f;
+                w2[j] = std::clamp(w2[j] - learningRate * gradLogit * h[j], -maxOutputWeight, maxOutputWeight);
+            }
+            b2 -= learningRate * gradLogit;
+            for (int j = 0; j < HIDDEN; ++j) b1[j] -= learningRate * (gradA[j] + gradA[HIDDEN + j]);
+            // Rows share the step so that one update moves the accumulator as far as the bias
+            const float rowRate = learningRate / std::max<int>(1, p.count);
+            for (std::size_t i = p.first; i < p.first + p.count; ++i) {
+                float* us = &w1[codes[i] * HIDDEN];
+                float* them = &w1[swapped[codes[i]] * HIDDEN];
+                for (int j = 0; j < HIDDEN; ++j) {
+                    us[j] -= rowRate * gradA[j];
+                    them[j] -= rowRate * gradA[HIDDEN + j];
+                }
+            }
+        }
+    }
+    report.finalLoss = meanLoss();
+
+    // Quantise: accumulator units of 1/QA, output weights of 1/QB
+    auto toInt16 = [](float value) {
+        return static_cast<std::int16_t>(std::clamp(std::lround(value * QA), -32767L, 32767L));
+    };
+    for (std::size_t i = 0; i < w1.size(); ++i) network.inputWeights[i] = toInt16(w1[i]);
+    for (int j = 0; j < HIDDEN; ++j) network.inputBiases[j] = toInt16(b1[j]);
+    for (int j = 0; j < INPUTS; ++j) {
+        network.outputWeights[j] = static_cast<std::int8_t>(std::clamp(std::lround(w2[j] * QB), -127L, 127L));
+    }
+    network.outputBias = static_cast<std::int32_t>(std::lround(b2 * QA * QB));
+    network.updateContentHash();
+    return true;
+}
@@ -0,0 +1,211 @@
+// NNUE Evaluator - Small quantised network over window patterns, updated incrementally
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "scratch_board.h"
+#include "winrule.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GameRecord;
+class NnueAccumulator;
+
+// An efficiently updatable network in the style of chess NNUEs, replacing the hand-written
+// window scores at the leaves of the v2/v3 search.
+//
+// Input features: every N-cell window (4 directions) holding at least one stone is one sparse
+// feature, identified by its content as a base-3 number (digit k: 0 empty, 1 friendly,
+// 2 opponent). The 3^N codes share one weight row per code across directions, and a window
+// with no stones has no feature. A stone changes the code of the 4N windows through it, so
+// the first layer is updated in O(4N) row additions per move instead of being recomputed.
+//
+// Layers: two int16 accumulators of HIDDEN values (one from each player's side) hold the
+// first layer's output. The side to move's accumulator and the other one are clipped to
+// [0, QA], concatenated and dotted with int8 output weights (AVX2 / SSE2 / scalar, chosen at
+// runtime) into a logit for the side to move.
+//
+// Weights file (native byte order, little-endian on every supported target):
+//   char[8] "ITTNNUW1", uint32 win length, uint32 HIDDEN,
+//   int16 input weights [3^N][HIDDEN], int16 input bias [HIDDEN],
+//   int8 output weights [2 * HIDDEN], int32 output bias
+// Training data file (exportTrainingData):
+//   char[8] "ITTNNUD1", uint32 win length, then per position:
+//   int8 result for the side to move (1 win, 0 draw, -1 loss), uint8 0, uint16 count,
+//   uint16 window codes [count] seen from the side to move
+class NnueNetwork {
+public:
+    static constexpr int HIDDEN = 32;
+    static constexpr int QA = 127;            // Accumulator value of a fully active hidden unit
+    static constexpr int QB = 64;             // Output weight value of 1.0
+    static constexpr int OUTPUT_SCALE = 1000; // Search score per unit of output logit
+
+    // All-zero weights (every position evaluates to 0) until loaded or trained
+    explicit NnueNetwork(int winLength = StandardWinRule::LENGTH);
+
+    int getWinLength() const { return winLength; }
+    int featureCount() const { return codeCount; }  // 3^N
+
+    bool loadFromFile(const std::string& filename);
+    bool saveToFile(const std::string& filename) const;
+
+    // FNV-1a digest of the win length and weights, kept up to date by loading and training, so
+    // that cached analyses are only reused with the same network
+    std::uint64_t contentHash() const { return digest; }
+
+    const std::int16_t* featureRow(int code) const { return &inputWeights[code * HIDDEN]; }
+    const std::int16_t* inputBias() const { return inputBiases.data(); }
+
+    // Score of the accumulated position for the side to move, in search units
+    int evaluate(const NnueAccumulator& accumulator, char sideToMove) const;
+
+    // Replay the games and write one training position per move (format above).
+    // Returns the number of positions written, or -1 if the file cannot be written.
+    static long long exportTrainingData(const std::vector<GameRecord>& games, int winLength,
+                                        const std::string& filename);
+
+    struct TrainingReport {
+        long long positions = 0;
+        double initialLoss = 0.0;  // Mean squared error of the predicted result, before training
+        double finalLoss = 0.0;    // ... and after the last epoch (float weights)
+    };
+
+    // Fit a network to exported training data (float SGD on the squared error between the
+    // sigmoid of the logit and the game result, then quantised). Returns false if the file
+    // cannot be read or holds a result outside -1..1 or a window code outside 3^length.
+    static bool train(const std::string& dataFilename, int epochs, NnueNetwork& network,
+                      TrainingReport& report);
+
+private:
+    int winLength;
+    int codeCount;
+    std::vector<std::int16_t> inputWeights;  // [codeCount][HIDDEN]
+    std::array<std::int16_t, HIDDEN> inputBiases{};
+    alignas(32) std::int8_t outputWeights[2 * HIDDEN] = {};
+    std::int32_t outputBias = 0;  // In units of QA * QB
+    std::uint64_t digest = 0;
+
+    void updateContentHash();
+};
+
+namespace Nnue {
+    // Value of an N-bit window mask read as base-3 digits that are 0 or 1
+    template <typename Rule>
+    inline constexpr auto TERNARY = [] {
+        std::array<std::uint16_t, 1u << Rule::LENGTH> table{};
+        for (unsigned bits = 0; bits < table.size(); ++bits) {
+            unsigned value = 0, power = 1;
+            for (int k = 0; k < Rule::LENGTH; ++k, power *= 3) {
+                if (bits & (1u << k)) value += power;
+            }
+            table[bits] = static_cast<std::uint16_t>(value);
+        }
+        return table;
+    }();
+
+    inline constexpr int powerOfThree(int k) {
+        int value = 1;
+        while (k-- > 0) value *= 3;
+        return value;
+    }
+
+    // Code of the window starting at strip position `start` (masks: friendly = the viewer)
+    template <typename Rule>
+    inline int windowCode(const LineMasks& masks, int start) {
+        return TERNARY<Rule>[(masks.friendly >> start) & Rule::WINDOW_MASK] +
+               2 * TERNARY<Rule>[(masks.opponent >> start) & Rule::WINDOW_MASK];
+    }
+
+    // Visit every window holding a stone once, as fn(codeFromX, codeFromO)
+    template <typename Rule, typename Fn>
+    void forEachWindow(const ScratchBoard& board, Fn fn) {
+        LineStrips strips;
+        LineMasks masks[4];
+        board.forEachStone([&](int x, int y, char) {
+            board.gatherStrips<Rule>(board.index(x, y), strips);
+            LineClassifier::classify(strips, 'X', 'O', masks);
+            for (int d = 0; d < 4; ++d) {
+                const std::uint16_t stones = masks[d].friendly | masks[d].opponent;
+                for (int offset = 0; offset < Rule::LENGTH; ++offset) {
+                    const int start = Rule::STRIP_CENTER - offset;
+                    // Counted from its first stone only
+                    if ((stones >> start) & ((1u << offset) - 1)) continue;
+                    const LineMasks fromO{masks[d].opponent, masks[d].friendly, masks[d].empty};
+                    fn(windowCode<Rule>(masks[d], start), windowCode<Rule>(fromO, start));
+                }
+            }
+        });
+    }
+}
+
+// First-layer outputs for the position on a ScratchBoard, one frame per search ply: push()
+// after a stone is placed copies the top frame and applies the changed windows, pop() after
+// it is removed restores the previous one.
+class NnueAccumulator {
+public:
+    struct Frame {
+        alignas(32) std::int16_t values[2][NnueNetwork::HIDDEN];  // From X's side, from O's side
+    };
+
+    const Frame& top() const { return stack.back(); }
+    void pop() { stack.pop_back(); }
+
+    // Recompute from scratch (start of a search)
+    template <typename Rule>
+    void refresh(const ScratchBoard& board, const NnueNetwork& network) {
+        stack.clear();
+        Frame& frame = stack.emplace_back();
+        for (int side = 0; side < 2; ++side) {
+            for (int j = 0; j < NnueNetwork::HIDDEN; ++j) frame.values[side][j] = network.inputBias()[j];
+        }
+        Nnue::forEachWindow<Rule>(board, [&](int codeX, int codeO) {
+            add(frame.values[0], network.featureRow(codeX));
+            add(frame.values[1], network.featureRow(codeO));
+        });
+    }
+
+    // A stone was just placed at (x, y): push a frame with the 4N windows through it updated
+    template <typename Rule>
+    void push(const ScratchBoard& board, int x, int y, const NnueNetwork& network) {
+        stack.push_back(stack.back());
+        Frame& frame = stack.back();
+        const int center = board.index(x, y);
+        const bool placedX = board.at(center) == 'X';
+
+        LineStrips strips;
+        LineMasks masks[4];
+        board.gatherStrips<Rule>(center, strips);
+        LineClassifier::classify(strips, 'X', 'O', masks);
+
+        for (int d = 0; d < 4; ++d) {
+            const LineMasks fromO{masks[d].opponent, masks[d].friendly, masks[d].empty};
+            for (int offset = 0; offset < Rule::LENGTH; ++offset) {
+                const int start = Rule::STRIP_CENTER - offset;
+                const int placed = Nnue::powerOfThree(offset);
+                const int codeX = Nnue::windowCode<Rule>(masks[d], start);
+                const int codeO = Nnue::windowCode<Rule>(fromO, start);
+                // Before the stone its digit was 0; a window that was empty had no feature
+                const int oldX = codeX - (placedX ? 1 : 2) * placed;
+                const int oldO = codeO - (placedX ? 2 : 1) * placed;
+                if (oldX != 0) subtract(frame.values[0], network.featureRow(oldX));
+                if (oldO != 0) subtract(frame.values[1], network.featureRow(oldO));
+                add(frame.values[0], network.featureRow(codeX));
+                add(frame.values[1], network.featureRow(codeO));
+            }
+        }
+    }
+
+private:
+    std::vector<Frame> stack;
+
+    // Plain loops over 32 int16 lanes; the compiler turns each into a few vector adds
+    static void add(std::int16_t* values, const std::int16_t* row) {
+        for (int j = 0; j < NnueNetwork::HIDDEN; ++j) values[j] = static_cast<std::int16_t>(values[j] + row[j]);
+    }
+    static void subtract(std::int16_t* values, const std::int16_t* row) {
+        for (int j = 0; j < NnueNetwork::HIDDEN; ++j) values[j] = static_cast<std::int16_t>(values[j] - row[j]);
+    }
+};
@@ -0,0 +1,223 @@
+// Playout Kernel - Fast random games on a local bitboard for rollout evaluation
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "playout_kernel.h"
+#include "tictactoeboard.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+constexpr int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+constexpr char MARKS[2] = {'X', 'O'};
+
+}  // namespace
+
+double PlayoutKernel::Tally::score(char mark) const {
+    if (games == 0) return 0.5;
+    return (wins[mark == 'X' ? 0 : 1] + 0.5 * draws) / games;
+}
+
+PlayoutKernel::PlayoutKernel(std::uint64_t seedValue) {
+    seed(seedValue);
+    // Each move removes one frontier cell and adds at most 8
+    movesPlayed.reserve(PLAYABLE * PLAYABLE);
+    frontierLog.reserve(9 * PLAYABLE * PLAYABLE);
+}
+
+template <typename Rule>
+bool PlayoutKernel::load(const TicTacToeBoard& board) {
+    const auto& positions = board.getOccupiedPositions();
+    loaded = false;
+
+    // Centre the stones' bounding box (or the origin, on an empty board) in the playable region
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    if (!positions.empty()) {
+        minX = maxX = positions.begin()->first.x();
+        minY = maxY = positions.begin()->first.y();
+        for (const auto& [cell, mark] : positions) {
+            minX = std::min(minX, cell.x()); maxX = std::max(maxX, cell.x());
+            minY = std::min(minY, cell.y()); maxY = std::max(maxY, cell.y());
+        }
+    }
+    if (maxX - minX >= PLAYABLE || maxY - minY >= PLAYABLE) return false;
+    const int shiftX = MARGIN + (PLAYABLE - (maxX - minX + 1)) / 2 - minX;
+    const int shiftY = MARGIN + (PLAYABLE - (maxY - minY + 1)) / 2 - minY;
+
+    stones[0].fill(0);
+    stones[1].fill(0);
+    slot.fill(NO_SLOT);
+    frontierCount = 0;
+    for (const auto& [cell, mark] : positions) {
+        place((cell.y() + shiftY) * SIZE + cell.x() + shiftX, mark == 'X' ? 0 : 1, false);
+    }
+    if (positions.empty()) addToFrontier(shiftY * SIZE + shiftX, false);
+
+    rootWins[0].count = rootWins[1].count = 0;
+    for (const auto& [cell, mark] : positions) {
+        const int colour = mark == 'X' ? 0 : 1;
+        addWinCells<Rule>(cell.x() + shiftX, cell.y() + shiftY, colour, rootWins[colour]);
+    }
+    loaded = true;
+    return true;
+}
+
+// Add the winning cells of `colour` in the windows through its stone at (x, y): windows with
+// N - 1 of its stones, no opponent stone and no cell outside the playable region
+template <typename Rule>
+void PlayoutKernel::addWinCells(int x, int y, int colour, WinCells& list) const {
+    constexpr int N = Rule::LENGTH;
+    constexpr std::uint32_t WINDOW = (1u << N) - 1;
+    const auto& own = stones[colour];
+    const auto& other = stones[1 - colour];
+
+    for (const auto& d : DIRECTIONS) {
+        // Bit i stands for the cell i - (N - 1) steps along the direction
+        std::uint32_t ownBits = 0, blockedBits = 0;
+        for (int i = 0; i < 2 * N - 1; ++i) {
+            const int cx = x + (i - (N - 1)) * d[0];
+            const int cy = y + (i - (N - 1)) * d[1];
+            if (!playable(cx, cy) || ((other[cy] >> cx) & 1)) blockedBits |= 1u << i;
+            else if ((own[cy] >> cx) & 1) ownBits |= 1u << i;
+        }
+        for (int start = 0; start < N; ++start) {
+            const std::uint32_t window = WINDOW << start;
+            if ((blockedBits & window) || std::popcount(ownBits & window) != N - 1) continue;
+            const int i = std::countr_zero(window & ~ownBits);
+            const int cell = (y + (i - (N - 1)) * d[1]) * SIZE + x + (i - (N - 1)) * d[0];
+            const auto end = list.cells.begin() + list.count;
+            if (list.count < WIN_CAPACITY && std::find(list.cells.begin(), end, cell) == end) {
+                list.cells[list.count++] = static_cast<std::uint16_t>(cell);
+            }
+        }
+    }
+}
+
+void PlayoutKernel::addToFrontier(int cell, bool logged) {
+    slot[cell] = static_cast<std::uint16_t>(frontierCount);
+    frontier[frontierCount++] = static_cast<std::uint16_t>(cell);
+    if (logged) frontierLog.push_back({static_cast<std::uint16_t>(cell), 0, true});
+}
+
+// Swap-remove: the last cell takes the removed cell's slot
+void PlayoutKernel::removeFromFrontier(int cell, bool logged) {
+    const std::uint16_t position = slot[cell];
+    const std::uint16_t last = frontier[--frontierCount];
+    frontier[position] = last;
+    slot[last] = position;
+    slot[cell] = NO_SLOT;
+    if (logged) frontierLog.push_back({static_cast<std::uint16_t>(cell), position, false});
+}
+
+void PlayoutKernel::place(int cell, int colour, bool logged) {
+    const int x = cellX(cell), y = cellY(cell);
+    stones[colour][y] |= std::uint64_t{1} << x;
+    if (slot[cell] != NO_SLOT) removeFromFrontier(cell, logged);
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            const int nx = x + dx, ny = y + dy;
+            const int neighbour = ny * SIZE + nx;
+            if (playable(nx, ny) && !occupied(nx, ny) && slot[neighbour] == NO_SLOT) {
+                addToFrontier(neighbour, logged);
+            }
+        }
+    }
+    if (logged) movesPlayed.push_back(static_cast<std::uint16_t>(cell));
+}
+
+// Replay the frontier log backwards, then lift the playout's stones
+void PlayoutKernel::undoPlayout() {
+    for (auto it = frontierLog.rbegin(); it != frontierLog.rend(); ++it) {
+        if (it->added) {
+            --frontierCount;
+            slot[it->cell] = NO_SLOT;
+        } else {
+            // The cell that filled the slot goes back to the end (unless the slot was the end)
+            if (it->slot < frontierCount) {
+                const std::uint16_t moved = frontier[it->slot];
+                frontier[frontierCount] = moved;
+                slot[moved] = static_cast<std::uint16_t>(frontierCount);
+            }
+            ++frontierCount;
+            frontier[it->slot] = it->cell;
+            slot[it->cell] = it->slot;
+        }
+    }
+    for (std::uint16_t cell : movesPlayed) {
+        const std::uint64_t bit = ~(std::uint64_t{1} << cellX(cell));
+        stones[0][cellY(cell)] &= bit;
+        stones[1][cellY(cell)] &= bit;
+    }
+    frontierLog.clear();
+    movesPlayed.clear();
+}
+
+int PlayoutKernel::liveWinCount(WinCells& list) const {
+    int kept = 0;
+    for (int i = 0; i < list.count; ++i) {
+        if (!occupied(cellX(list.cells[i]), cellY(list.cells[i]))) list.cells[kept++] = list.cells[i];
+    }
+    list.count = kept;
+    return kept;
+}
+
+template <typename Rule>
+char PlayoutKernel::playout(char toMove, int maxMoves) {
+    lastMoves = 0;
+    if (!loaded) return '\0';
+
+    wins[0] = rootWins[0];
+    wins[1] = rootWins[1];
+    int side = toMove == 'X' ? 0 : 1;
+    char winner = '\0';
+    for (int moves = 0; moves < maxMoves; ++moves) {
+        // Level 1: a winning cell ends the game
+        if (liveWinCount(wins[side]) > 0) {
+            winner = MARKS[side];
+            ++lastMoves;
+            break;
+        }
+
+        // Level 2: block a winning cell of the opponent, otherwise play next to a stone
+        int cell;
+        if (const int threats = liveWinCount(wins[1 - side]); threats > 0) {
+            cell = wins[1 - side].cells[randomIndex(threats)];
+        } else if (frontierCount > 0) {
+            cell = frontier[randomIndex(frontierCount)];
+        } else {
+            break;
+        }
+
+        place(cell, side, true);
+        addWinCells<Rule>(cellX(cell), cellY(cell), side, wins[side]);
+        ++lastMoves;
+        side = 1 - side;
+    }
+
+    undoPlayout();
+    return winner;
+}
+
+template <typename Rule>
+PlayoutKernel::Tally PlayoutKernel::run(char toMove, int games, int maxMoves) {
+    Tally tally;
+    for (int game = 0; game < games; ++game) {
+        const char winner = playout<Rule>(toMove, maxMoves);
+        ++tally.games;
+        tally.moves += lastMoves;
+        if (winner == '\0') ++tally.draws;
+        else ++tally.wins[winner == 'X' ? 0 : 1];
+    }
+    return tally;
+}
+
+#define PLAYOUT_KERNEL_INSTANTIATE(N) \
+    template bool PlayoutKernel::load<WinRule<N>>(const TicTacToeBoard&); \
+    template char PlayoutKernel::playout<WinRule<N>>(char, int); \
+    template PlayoutKernel::Tally PlayoutKernel::run<WinRule<N>>(char, int, int);
+PLAYOUT_KERNEL_INSTANTIATE(4)
+PLAYOUT_KERNEL_INSTANTIATE(5)
+PLAYOUT_KERNEL_INSTANTIATE(6)
+PLAYOUT_KERNEL_INSTANTIATE(7)
+#undef PLAYOUT_KERNEL_INSTANTIATE
@@ -0,0 +1,124 @@
+// Playout Kernel - Fast random games on a local bitboard for rollout evaluation
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "winrule.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class TicTacToeBoard;
+
+// Plays complete games from a position with the SmartRandomAI level 2 rules: take a win, else
+// block an opponent win, else play a random cell next to a stone. It is meant for rollouts
+// (Monte Carlo evaluation, MCTS), where millions of such moves are needed per second.
+//
+// The position is copied once into a SIZE x SIZE bitboard, one 64-bit word per row and
+// colour, centred on the stones. The playout state is updated incrementally:
+//   - the frontier (empty cells next to a stone) is an array with each cell's slot in it, so
+//     adding, removing and picking a random cell are O(1)
+//   - each side's winning cells (empty cells completing N in a row) are found when a stone is
+//     placed, by checking only the N-cell windows through it
+// Every change is logged and undone after the game, so a playout allocates nothing and costs
+// no copy of the board (the logs are sized once, by the constructor).
+//
+// Stones stay MARGIN cells away from the edges, so window reads never leave the array: a
+// playout is confined to the PLAYABLE x PLAYABLE region around the position, and windows
+// reaching past it do not count. load() refuses positions whose stones do not fit.
+class PlayoutKernel {
+public:
+    static constexpr int SIZE = 64;                        // Columns per row word
+    static constexpr int MARGIN = WinRule<7>::LENGTH - 1;  // Longest half-window read from a stone
+    static constexpr int PLAYABLE = SIZE - 2 * MARGIN;
+    static constexpr int DEFAULT_MAX_MOVES = 1000;         // Moves before a playout is a draw
+    static constexpr std::uint64_t DEFAULT_SEED = 0x9E3779B97F4A7C15ull;
+
+    // Results of a batch of playouts
+    struct Tally {
+        long long games = 0;
+        long long wins[2] = {};  // X, O
+        long long draws = 0;
+        long long moves = 0;
+
+        // (wins + 0.5 * draws) / games for `mark`
+        double score(char mark) const;
+    };
+
+    explicit PlayoutKernel(std::uint64_t seedValue = DEFAULT_SEED);
+
+    // Load the position to play out from. Returns false when its stones span more than
+    // PLAYABLE cells in either direction. Instantiated for WinRule<4> to WinRule<7>; playouts
+    // must use the same Rule.
+    template <typename Rule>
+    bool load(const TicTacToeBoard& board);
+
+    // Play one game with `toMove` moving first and return the winner's mark, or '\0' for a
+    // draw (frontier exhausted, or maxMoves played). The loaded position is left unchanged.
+    template <typename Rule>
+    char playout(char toMove, int maxMoves = DEFAULT_MAX_MOVES);
+
+    // Play `games` playouts and add them up
+    template <typename Rule>
+    Tally run(char toMove, int games, int maxMoves = DEFAULT_MAX_MOVES);
+
+    // Moves of the last playout, the winning move included
+    int getLastMoves() const { return lastMoves; }
+
+    // Reseed the random moves (xorshift state; 0 is replaced by DEFAULT_SEED)
+    void seed(std::uint64_t value) { rngState = value ? value : DEFAULT_SEED; }
+
+private:
+    static constexpr int CELLS = SIZE * SIZE;
+    static constexpr std::uint16_t NO_SLOT = 0xFFFF;
+    static constexpr int WIN_CAPACITY = 64;  // Winning cells kept per side
+
+    struct FrontierChange {
+        std::uint16_t cell;
+        std::uint16_t slot;  // Slot the cell was removed from (removals only)
+        bool added;
+    };
+
+    struct WinCells {
+        std::array<std::uint16_t, WIN_CAPACITY> cells;
+        int count = 0;
+    };
+
+    std::array<std::uint64_t, SIZE> stones[2] = {};  // Row words of X and O
+    std::array<std::uint16_t, CELLS> slot;           // Position in `frontier`, or NO_SLOT
+    std::array<std::uint16_t, CELLS> frontier;
+    int frontierCount = 0;
+    WinCells rootWins[2];                            // Winning cells of the loaded position
+    WinCells wins[2];                                // ... and during a playout
+    bool loaded = false;
+    int lastMoves = 0;
+
+    std::vector<std::uint16_t> movesPlayed;          // Undo logs of the current playout
+    std::vector<FrontierChange> frontierLog;
+
+    std::uint64_t rngState = DEFAULT_SEED;
+
+    static int cellX(int cell) { return cell % SIZE; }
+    static int cellY(int cell) { return cell / SIZE; }
+    static bool playable(int x, int y) {
+        return x >= MARGIN && x < SIZE - MARGIN && y >= MARGIN && y < SIZE - MARGIN;
+    }
+    bool occupied(int x, int y) const { return ((stones[0][y] | stones[1][y]) >> x) & 1; }
+
+    template <typename Rule> void addWinCells(int x, int y, int colour, WinCells& list) const;
+    void place(int cell, int colour, bool logged);
+    void addToFrontier(int cell, bool logged);
+    void removeFromFrontier(int cell, bool logged);
+    void undoPlayout();
+    int liveWinCount(WinCells& list) const;  // Drops occupied cells, returns what is left
+
+    // xorshift64*, and a uniform index in [0, n)
+    std::uint64_t nextRandom() {
+        rngState ^= rngState >> 12;
+        rngState ^= rngState << 25;
+        rngState ^= rngState >> 27;
+        return rngState * 0x2545F4914F6CDD1Dull;
+    }
+    int randomIndex(int n) { return static_cast<int>(((nextRandom() >> 32) * static_cast<std::uint64_t>(n)) >> 32); }
+};
@@ -0,0 +1,197 @@
+// Scratch Board - Dense search-local board used by the minimax AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "scratch_board.h"
+#include "tictactoeboard.h"
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+namespace {
+
+// Window of MAX_WINDOW cells on one axis around `centre`, kept inside the int range
+void windowAround(int centre, long long& low, long long& high) {
+    low = std::max<long long>(INT_MIN, static_cast<long long>(centre) - ScratchBoard::MAX_WINDOW / 2);
+    low = std::min<long long>(low, static_cast<long long>(INT_MAX) - (ScratchBoard::MAX_WINDOW - 1));
+    high = low + (ScratchBoard::MAX_WINDOW - 1);
+}
+
+} // namespace
+
+bool ScratchBoard::layOut(std::vector<int>& values, int focus, std::vector<Span>& spans) {
+    spans.clear();
+    if (values.empty()) {
+        spans.push_back({INT_MIN, INT_MAX, 0});
+        return false;
+    }
+    std::sort(values.begin(), values.end());
+
+    // Groups of stone coordinates without a gap wider than PACKED_DISTANCE, and where their
+    // first stone lands once packed (relative to the first group's)
+    struct Group {
+        int first, last;
+        long long packed;
+    };
+    std::vector<Group> groups;
+    for (const int v : values) {
+        if (groups.empty()) {
+            groups.push_back({v, v, 0});
+        } else if (static_cast<long long>(v) - groups.back().last > PACKED_DISTANCE) {
+            const Group& previous = groups.back();
+            groups.push_back({v, v, previous.packed + (static_cast<long long>(previous.last) - previous.first) + PACKED_DISTANCE});
+        } else {
+            groups.back().last = v;
+        }
+    }
+    auto width = [&](std::size_t i, std::size_t j) {
+        return groups[j].packed + (static_cast<long long>(groups[j].last) - groups[j].first) - groups[i].packed + 1;
+    };
+
+    // Keep every group if they fit, else the ones nearest the focus's group
+    std::size_t i = 0, j = groups.size() - 1;
+    if (width(i, j) > MAX_WINDOW) {
+        i = 0;
+        while (i + 1 < groups.size() && focus > groups[i].last) ++i;
+        j = i;
+        if (width(i, i) > MAX_WINDOW) {
+            // A single group wider than the array: a window around the focus
+            long long low, high;
+            windowAround(focus, low, high);
+            spans.push_back({low, high, 0});
+            return false;
+        }
+        for (;;) {
+            const long long before = i > 0 ? static_cast<long long>(groups[i].first) - groups[i - 1].last : LLONG_MAX;
+            const long long after = j + 1 < groups.size() ? static_cast<long long>(groups[j + 1].first) - groups[j].last : LLONG_MAX;
+            if (before <= after && before != LLONG_MAX && width(i - 1, j) <= MAX_WINDOW) --i;
+            else if (after != LLONG_MAX && width(i, j + 1) <= MAX_WINDOW) ++j;
+            else if (before != LLONG_MAX && width(i - 1, j) <= MAX_WINDOW) --i;
+            else break;
+        }
+    }
+
+    // The first span keeps board coordinates; each next one starts SEPARATION cells after the
+    // previous one ends. The outer ends stay open unless groups beyond them were left out.
+    for (std::size_t g = i; g <= j; ++g) {
+        Span span;
+        span.low = g == 0 ? INT_MIN : static_cast<long long>(groups[g].first) - CLUSTER_REACH;
+        span.high = g + 1 == groups.size() ? INT_MAX : static_cast<long long>(groups[g].last) + CLUSTER_REACH;
+        span.shift = g == i ? 0 : static_cast<int>(span.low - (spans.back().high - spans.back().shift + SEPARATION + 1));
+        spans.push_back(span);
+    }
+    return spans.size() > 1;
+}
+
+void ScratchBoard::loadFrom(const TicTacToeBoard& board, Cell focus) {
+    const auto& occupied = board.getOccupiedPositions();
+    if ((focus.isNone() || !board.isPositionOccupied(focus)) && !occupied.empty()) {
+        focus = std::next(occupied.begin(), occupied.size() / 2)->first;
+    }
+
+    coordinates.clear();
+    for (const auto& [pos, mark] : occupied) coordinates.push_back(pos.x());
+    packedX = layOut(coordinates, focus.x(), spansX);
+    coordinates.clear();
+    for (const auto& [pos, mark] : occupied) coordinates.push_back(pos.y());
+    packedY = layOut(coordinates, focus.y(), spansY);
+
+    // Box of the stones kept, in array coordinates
+    int boxMinX = 0, boxMaxX = 0, boxMinY = 0, boxMaxY = 0;
+    bool first = true;
+    for (const auto& [pos, mark] : occupied) {
+        if (!reaches(pos.x(), pos.y())) continue;
+        const int col = column(pos.x()), line = row(pos.y());
+        boxMinX = first ? col : std::min(boxMinX, col);
+        boxMaxX = first ? col : std::max(boxMaxX, col);
+        boxMinY = first ? line : std::min(boxMinY, line);
+        boxMaxY = first ? line : std::max(boxMaxY, line);
+        first = false;
+    }
+
+    // Leave room for the search to grow before a regrow is needed
+    originX = boxMinX - 2 * GUARD;
+    originY = boxMinY - 2 * GUARD;
+    stride = (boxMaxX - boxMinX + 1) + 4 * GUARD;
+    rows = (boxMaxY - boxMinY + 1) + 4 * GUARD;
+    const size_t needed = static_cast<size_t>(stride) * rows;
+    if (needed > cells.capacity()) cells.reserve(2 * needed);  // Room for the game to grow between moves
+    cells.assign(needed, EMPTY);
+    updateLineSteps();
+
+    minX = 0; maxX = -1; minY = 0; maxY = -1;
+    stoneCount = 0;
+    droppedStones = 0;
+    for (const auto& [pos, mark] : occupied) {
+        if (reaches(pos.x(), pos.y())) placeMarkDirect(pos.x(), pos.y(), mark);
+        else droppedStones++;
+    }
+}
+
+void ScratchBoard::regrow(int boxMinX, int boxMinY, int boxMaxX, int boxMaxY) {
+    std::vector<char> oldCells = std::move(cells);
+    int oldOriginX = originX, oldOriginY = originY, oldStride = stride, oldRows = rows;
+
+    originX = boxMinX - 2 * GUARD;
+    originY = boxMinY - 2 * GUARD;
+    stride = (boxMaxX - boxMinX + 1) + 4 * GUARD;
+    rows = (boxMaxY - boxMinY + 1) + 4 * GUARD;
+    cells.assign(static_cast<size_t>(stride) * rows, EMPTY);
+    updateLineSteps();
+
+    for (int line = 0; line < oldRows; ++line) {
+        for (int col = 0; col < oldStride; ++col) {
+            char mark = oldCells[static_cast<size_t>(line) * oldStride + col];
+            if (mark != EMPTY) cells[arrayIndex(oldOriginX + col, oldOriginY + line)] = mark;
+        }
+    }
+}
+
+void ScratchBoard::placeMarkDirect(int boardX, int boardY, char mark) {
+    const int x = column(boardX), y = row(boardY);
+    if (!insideGuard(x, y)) {
+        int boxMinX = stoneCount ? std::min(minX, x) : x;
+        int boxMaxX = stoneCount ? std::max(maxX, x) : x;
+        int boxMinY = stoneCount ? std::min(minY, y) : y;
+        int boxMaxY = stoneCount ? std::max(maxY, y) : y;
+        regrow(boxMinX, boxMinY, boxMaxX, boxMaxY);
+    }
+
+    char& cell = cells[arrayIndex(x, y)];
+    if (cell == EMPTY) stoneCount++;
+    cell = mark;
+
+    if (stoneCount == 1 && maxX < minX) {
+        minX = maxX = x;
+        minY = maxY = y;
+    } else {
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+    }
+}
+
+void ScratchBoard::removeMarkDirect(int x, int y) {
+    char& cell = cells[index(x, y)];
+    if (cell != EMPTY) stoneCount--;
+    cell = EMPTY;
+}
+
+// Same rule as TicTacToeBoard::checkWinQuiet, walking the dense array by index steps
+bool ScratchBoard::checkWinQuiet(int x, int y, int length) const {
+    const int center = index(x, y);
+    const char mark = cells[center];
+    if (mark == EMPTY) return false;
+    if (isSupportedWinLength(length)) {
+        return withWinRule(length, [&](auto rule) { return checkWinQuiet<decltype(rule)>(x, y); });
+    }
+
+    const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    for (const auto& dir : directions) {
+        const int s = step(dir[0], dir[1]);
+        int count = 1;
+        for (int idx = center + s; cells[idx] == mark; idx += s) count++;
+        for (int idx = center - s; cells[idx] == mark; idx -= s) count++;
+        if (count >= length) return true;
+    }
+    return false;
+}
@@ -0,0 +1,170 @@
+// Scratch Board - Dense search-local board used by the minimax AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "line_classifier.h"
+#include "move_frontier.h"
+#include <climits>
+#include <vector>
+
+class TicTacToeBoard;
+
+// Dense copy of the stones' bounding box plus a margin, built at the start of findBestMove.
+// Cells are addressed with plain index arithmetic (index = row * stride + column), and the
+// margin guarantees that every window read around a candidate move stays inside the array,
+// so lookups need no bounds checks or hashing. Placing a stone closer than GUARD cells to the
+// edge regrows the array; in practice that only happens when the search wanders far away.
+//
+// The array is at most about MAX_SPAN cells on a side. Groups of stones far apart are packed
+// closer together: on each axis, a run of more than PACKED_DISTANCE coordinates without a
+// stone is cut out, leaving every group CLUSTER_REACH cells on either side and SEPARATION
+// empty cells between the groups. No line strip reaches from one group into the next, so the
+// array reads exactly what the game board holds, and reaches() tells the search which cells it
+// may place stones on (those within CLUSTER_REACH of a group). Only stones that still do not
+// fit (scattered over more than MAX_WINDOW packed cells) are loaded as a window around a focus
+// cell, usually the last move: the groups nearest it are kept and isWindowed() reports that the
+// others were left out, so callers can read them from the game board instead.
+class ScratchBoard {
+public:
+    static constexpr char EMPTY = '\0';
+    static constexpr int GUARD = 9;  // Minimum number of cells kept between any stone and the edge
+    static constexpr int MAX_SPAN = 1024;  // Largest array side at load (1 MB of cells)
+    static constexpr int MAX_WINDOW = MAX_SPAN - 4 * GUARD;  // Widest stone box kept per axis
+    // Cells kept around a packed group: more than a default search (a threat line of five
+    // threats, or a few minimax plies) ever walks away from the stones
+    static constexpr int CLUSTER_REACH = 48;
+    static constexpr int SEPARATION = 2 * GUARD;  // Empty cells between packed groups
+    static constexpr int PACKED_DISTANCE = 2 * CLUSTER_REACH + SEPARATION + 1;  // Between their stones
+    static_assert(SEPARATION > WinRule<7>::STRIP_CENTER, "Line strips must not reach the next group");
+    // Strips are gathered around candidate cells up to CANDIDATE_REACH from a stone (two cells for
+    // LINES_2 and RADIUS_2), so the longest strip through the furthest one must fit inside the guard
+    static_assert(GUARD - CANDIDATE_REACH >= WinRule<7>::STRIP_CENTER,
+                  "GUARD too small for the longest line strip around the widest candidate shape");
+
+    // Rebuild from the game board (reuses the existing allocation when large enough). Stones
+    // too scattered to pack are windowed around `focus` (none: the middle stone in Cell order).
+    void loadFrom(const TicTacToeBoard& board, Cell focus = Cell::none());
+
+    // Whether the last load left stones out, and whether a cell is held by the array (only
+    // those may be indexed, read or played)
+    bool isWindowed() const { return droppedStones > 0; }
+    bool reaches(int x, int y) const { return holds(spansX, x) && holds(spansY, y); }
+
+    // Direct index arithmetic
+    int index(int x, int y) const { return arrayIndex(column(x), row(y)); }
+    int step(int dx, int dy) const { return dy * stride + dx; }
+    char at(int idx) const { return cells[idx]; }
+
+    // Whether the line strips through a cell lie inside the array (a check for tests: gatherStrips
+    // itself never checks)
+    template <typename Rule>
+    bool stripsInside(int center) const {
+        const int reach = Rule::STRIP_CENTER * (stride + 1);
+        return center - reach >= 0 && center + reach < static_cast<int>(cells.size());
+    }
+
+    // Copy the four line strips through a cell for LineClassifier
+    template <typename Rule>
+    void gatherStrips(int center, LineStrips& strips) const {
+        LineClassifier::gather<Rule>(cells.data(), center, lineSteps, strips);
+    }
+
+    // Same surface as TicTacToeBoard for the operations the AIs use during search
+    bool isPositionOccupied(int x, int y) const { return cells[index(x, y)] != EMPTY; }
+    char getMark(int x, int y) const { return cells[index(x, y)]; }
+    void placeMarkDirect(int x, int y, char mark);
+    void removeMarkDirect(int x, int y);
+    bool checkWinQuiet(int x, int y, int length) const;
+
+    // Win check with the length fixed at compile time; each half-line stops after N - 1 cells
+    template <typename Rule>
+    bool checkWinQuiet(int x, int y) const {
+        const int center = index(x, y);
+        const char mark = cells[center];
+        if (mark == EMPTY) return false;
+        for (int s : lineSteps) {
+            int count = 1;
+            for (int i = 1; i < Rule::LENGTH && cells[center + i * s] == mark; ++i) count++;
+            for (int i = 1; i < Rule::LENGTH && cells[center - i * s] == mark; ++i) count++;
+            if (count >= Rule::LENGTH) return true;
+        }
+        return false;
+    }
+
+    bool empty() const { return stoneCount == 0; }
+
+    // Visit every stone as fn(x, y, mark)
+    template <typename Fn>
+    void forEachStone(Fn fn) const {
+        if (stoneCount == 0) return;
+        for (int y = minY; y <= maxY; ++y) {
+            int idx = arrayIndex(minX, y);
+            for (int x = minX; x <= maxX; ++x, ++idx) {
+                if (cells[idx] != EMPTY) {
+                    fn(packedX ? toBoard(spansX, x) : x, packedY ? toBoard(spansY, y) : y, cells[idx]);
+                }
+            }
+        }
+    }
+
+private:
+    // A run of board coordinates on one axis, stored contiguously in the array
+    struct Span {
+        long long low, high;  // Board coordinates it holds (inclusive)
+        int shift;            // Array coordinate = board coordinate - shift
+    };
+
+    std::vector<char> cells;
+    int originX = 0, originY = 0;  // Array coordinate of cells[0]
+    int stride = 0, rows = 0;
+    int lineSteps[4] = {};  // Index step of the 4 line directions, kept in sync with stride
+    int minX = 0, maxX = -1, minY = 0, maxY = -1;  // Bounding box of stones since load (array coordinates)
+    int stoneCount = 0;
+    // Spans of each axis in board order. Unpacked, an axis is one span with shift 0, so array
+    // and board coordinates are the same and index() costs nothing extra.
+    std::vector<Span> spansX{{INT_MIN, INT_MAX, 0}}, spansY{{INT_MIN, INT_MAX, 0}};
+    bool packedX = false, packedY = false;  // More than one span
+    std::size_t droppedStones = 0;  // Stones of the last load outside the spans
+    std::vector<int> coordinates;   // Reused by loadFrom
+
+    static bool holds(const std::vector<Span>& spans, int v) {
+        for (const Span& span : spans) {
+            if (v >= span.low && v <= span.high) return true;
+        }
+        return false;
+    }
+    static int toArray(const std::vector<Span>& spans, int v) {
+        for (const Span& span : spans) {
+            if (v <= span.high) return v - span.shift;
+        }
+        return v - spans.back().shift;
+    }
+    static int toBoard(const std::vector<Span>& spans, int a) {
+        for (const Span& span : spans) {
+            if (a <= span.high - span.shift) return a + span.shift;
+        }
+        return a + spans.back().shift;
+    }
+    int column(int x) const { return packedX ? toArray(spansX, x) : x; }
+    int row(int y) const { return packedY ? toArray(spansY, y) : y; }
+    int arrayIndex(int col, int row) const { return (row - originY) * stride + (col - originX); }
+
+    // Spans of one axis for the stones' coordinates `values` (sorted in place); true if packed
+    static bool layOut(std::vector<int>& values, int focus, std::vector<Span>& spans);
+
+    void updateLineSteps() {
+        lineSteps[0] = step(1, 0); lineSteps[1] = step(0, 1);
+        lineSteps[2] = step(1, 1); lineSteps[3] = step(1, -1);
+    }
+
+    // Reallocate so that the given box plus GUARD fits, preserving current contents (both
+    // functions take array coordinates)
+    void regrow(int boxMinX, int boxMinY, int boxMaxX, int boxMaxY);
+    bool insideGuard(int x, int y) const {
+        return x >= originX + GUARD && x < originX + stride - GUARD &&
+               y >= originY + GUARD && y < originY + rows - GUARD;
+    }
+};
@@ -0,0 +1,42 @@
+// Search Arena - Per-search memory for the transient containers of the minimax AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "search_arena.h"
+
+void* SearchArena::CountingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    bytesSinceReset += bytes;
+    totalBytes += bytes;
+    totalCalls++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void SearchArena::CountingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+SearchArena::SearchArena(std::size_t initialBytes)
+    : buffer(new std::byte[initialBytes]), bufferSize(initialBytes) {
+    rebuild();
+}
+
+void SearchArena::rebuild() {
+    // Destroy in reverse order of construction: the pool draws from the monotonic resource
+    pool.reset();
+    monotonic.reset();
+    monotonic.emplace(buffer.get(), bufferSize, &upstream);
+    pool.emplace(&*monotonic);
+}
+
+void SearchArena::reset() {
+    if (upstream.bytesSinceReset > 0) {
+        // Grow to the high-water mark of the last search so the next one fits
+        std::size_t grown = bufferSize + upstream.bytesSinceReset;
+        pool.reset();
+        monotonic.reset();  // Returns the spilled blocks to the heap
+        buffer.reset(new std::byte[grown]);
+        bufferSize = grown;
+        upstream.bytesSinceReset = 0;
+    }
+    rebuild();
+}
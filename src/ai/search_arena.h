@@ -0,0 +1,58 @@
+// Search Arena - Per-search memory for the transient containers of the minimax AIs
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Owns one buffer that all std::pmr containers of a single findBestMove call allocate from.
+// A pool sits on top of a monotonic buffer so that nodes erased and re-inserted during the
+// search (move sets, undo lists) are recycled instead of piling up. reset() frees everything
+// at once; if the previous search spilled past the buffer, the buffer is grown to cover it,
+// so after a few searches a steady-state search makes no calls to the global allocator.
+// Not thread-safe: each AI instance owns its own arena.
+class SearchArena {
+public:
+    explicit SearchArena(std::size_t initialBytes = 64 * 1024);
+    SearchArena(const SearchArena&) = delete;
+    SearchArena& operator=(const SearchArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*pool; }
+
+    // Release everything allocated since the last reset (call at the start of each search)
+    void reset();
+
+    std::size_t capacity() const { return bufferSize; }
+    // Bytes taken from the global heap because the buffer was too small (since construction)
+    std::size_t overflowBytes() const { return upstream.totalBytes; }
+    // Number of global heap allocations made on behalf of the arena (since construction)
+    std::size_t overflowAllocations() const { return upstream.totalCalls; }
+
+private:
+    // Forwards to the global heap and records what the arena had to borrow
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        std::size_t bytesSinceReset = 0;
+        std::size_t totalBytes = 0;
+        std::size_t totalCalls = 0;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t bufferSize;
+    CountingResource upstream;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+    std::optional<std::pmr::unsynchronized_pool_resource> pool;
+
+    void rebuild();
+};
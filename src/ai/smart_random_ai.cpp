@@ -34,11 +34,11 @@ bool SmartRandomAI::isWinningMoveInPlace(TicTacToeBoard& board, int x, int y, ch
 // new sequence may lie adjacent to the hypothetical position and not yet be in
 // the maintained availableMoves set.
 int SmartRandomAI::countWinningFollowUps(TicTacToeBoard& board, int x, int y, char playerMark,
-                                         const std::set<std::pair<int, int>>& candidates) const {
+                                         const std::set<Cell>& candidates) const {
     board.placeMarkDirect(x, y, playerMark);
 
     // Expand candidate set with the 8 neighbors of (x, y)
-    std::set<std::pair<int, int>> expanded = candidates;
+    std::set<Cell> expanded = candidates;
     for (int dx = -1; dx <= 1; ++dx) {
         for (int dy = -1; dy <= 1; ++dy) {
             if (dx == 0 && dy == 0) continue;
@@ -48,11 +48,11 @@ int SmartRandomAI::countWinningFollowUps(TicTacToeBoard& board, int x, int y, ch
 
     int count = 0;
     for (const auto& candidate : expanded) {
-        if (candidate.first == x && candidate.second == y) continue;
-        if (board.isPositionOccupied(candidate.first, candidate.second)) continue;
-        board.placeMarkDirect(candidate.first, candidate.second, playerMark);
-        bool wins = board.checkWinQuiet(candidate.first, candidate.second, 5);
-        board.removeMarkDirect(candidate.first, candidate.second);
+        if (candidate.x() == x && candidate.y() == y) continue;
+        if (board.isPositionOccupied(candidate.x(), candidate.y())) continue;
+        board.placeMarkDirect(candidate.x(), candidate.y(), playerMark);
+        bool wins = board.checkWinQuiet(candidate.x(), candidate.y(), 5);
+        board.removeMarkDirect(candidate.x(), candidate.y());
         if (wins) ++count;
     }
     board.removeMarkDirect(x, y);
@@ -60,8 +60,8 @@ int SmartRandomAI::countWinningFollowUps(TicTacToeBoard& board, int x, int y, ch
 }
 
 // SmartRandomAI implementation - Optimized random player with stepwise improvements
-std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, char playerMark,
-                                                 std::pair<int, int> lastMove) {
+Cell SmartRandomAI::findBestMove(const TicTacToeBoard& board, char playerMark,
+                                 Cell lastMove) {
     // If board is empty, initialize available moves with origin and return it
     if (board.getOccupiedPositions().empty()) {
         availableMoves.clear();
@@ -70,8 +70,8 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     }
 
     // Update internal available moves based on lastMove
-    if (lastMove.first != INT_MIN && lastMove.second != INT_MIN) {
-        AIUtils::updateAvailableMoves(availableMoves, board, lastMove.first, lastMove.second);
+    if (!lastMove.isNone()) {
+        AIUtils::updateAvailableMoves(availableMoves, board, lastMove.x(), lastMove.y());
     } else if (availableMoves.empty()) {
         // First call - compute from board
         auto tempMoves = AIUtils::computeAdjacentMoves(board);
@@ -81,7 +81,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // Filter out any occupied positions that may have accumulated
     auto it = availableMoves.begin();
     while (it != availableMoves.end()) {
-        if (board.isPositionOccupied(it->first, it->second)) {
+        if (board.isPositionOccupied(it->x(), it->y())) {
             it = availableMoves.erase(it);
         } else {
             ++it;
@@ -97,10 +97,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
 
     // OPTIMIZATION LEVEL 1: Check for winning moves
     if (optimizationLevel >= 1) {
-        std::vector<std::pair<int, int>> winningMoves;
+        std::vector<Cell> winningMoves;
 
         for (const auto& move : availableMoves) {
-            if (isWinningMoveInPlace(boardCopy, move.first, move.second, playerMark)) {
+            if (isWinningMoveInPlace(boardCopy, move.x(), move.y(), playerMark)) {
                 winningMoves.push_back(move);
             }
         }
@@ -113,7 +113,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Winning moves found: " + std::to_string(winningMoves.size()) + "\n";
                 for (const auto& move : winningMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -123,16 +123,16 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, winningMoves.size() - 1);
             auto winningMove = winningMoves[dis(gen)];
 
-            log("\nSelected winning move: (" + std::to_string(winningMove.first) + ", " + std::to_string(winningMove.second) + ")\n"
+            log("\nSelected winning move: (" + std::to_string(winningMove.x()) + ", " + std::to_string(winningMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             // Update internal available moves with our chosen move
             availableMoves.erase(winningMove);
 
             // Add adjacent positions
-            for (int i = winningMove.first - 1; i <= winningMove.first + 1; ++i) {
-                for (int j = winningMove.second - 1; j <= winningMove.second + 1; ++j) {
-                    if (i == winningMove.first && j == winningMove.second) continue;
+            for (int i = winningMove.x() - 1; i <= winningMove.x() + 1; ++i) {
+                for (int j = winningMove.y() - 1; j <= winningMove.y() + 1; ++j) {
+                    if (i == winningMove.x() && j == winningMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -144,10 +144,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // OPTIMIZATION LEVEL 2: Block opponent winning moves
     if (optimizationLevel >= 2) {
         char opponentMark = (playerMark == 'X') ? 'O' : 'X';
-        std::vector<std::pair<int, int>> blockingMoves;
+        std::vector<Cell> blockingMoves;
 
         for (const auto& move : availableMoves) {
-            if (isWinningMoveInPlace(boardCopy, move.first, move.second, opponentMark)) {
+            if (isWinningMoveInPlace(boardCopy, move.x(), move.y(), opponentMark)) {
                 blockingMoves.push_back(move);
             }
         }
@@ -160,7 +160,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Opponent threatening moves found: " + std::to_string(blockingMoves.size()) + "\n";
                 for (const auto& move : blockingMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -170,16 +170,16 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, blockingMoves.size() - 1);
             auto blockingMove = blockingMoves[dis(gen)];
 
-            log("\nSelected blocking move: (" + std::to_string(blockingMove.first) + ", " + std::to_string(blockingMove.second) + ")\n"
+            log("\nSelected blocking move: (" + std::to_string(blockingMove.x()) + ", " + std::to_string(blockingMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             // Update internal available moves with our chosen move
             availableMoves.erase(blockingMove);
 
             // Add adjacent positions
-            for (int i = blockingMove.first - 1; i <= blockingMove.first + 1; ++i) {
-                for (int j = blockingMove.second - 1; j <= blockingMove.second + 1; ++j) {
-                    if (i == blockingMove.first && j == blockingMove.second) continue;
+            for (int i = blockingMove.x() - 1; i <= blockingMove.x() + 1; ++i) {
+                for (int j = blockingMove.y() - 1; j <= blockingMove.y() + 1; ++j) {
+                    if (i == blockingMove.x() && j == blockingMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -191,10 +191,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // OPTIMIZATION LEVEL 3: Create a double threat (fork)
     // A double threat move leaves >= 2 winning follow-up positions, e.g. an open triplet _xxx_
     if (optimizationLevel >= 3) {
-        std::vector<std::pair<int, int>> doubleThreatMoves;
+        std::vector<Cell> doubleThreatMoves;
 
         for (const auto& move : availableMoves) {
-            if (countWinningFollowUps(boardCopy, move.first, move.second, playerMark, availableMoves) >= 2) {
+            if (countWinningFollowUps(boardCopy, move.x(), move.y(), playerMark, availableMoves) >= 2) {
                 doubleThreatMoves.push_back(move);
             }
         }
@@ -207,7 +207,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Double-threat moves found: " + std::to_string(doubleThreatMoves.size()) + "\n";
                 for (const auto& move : doubleThreatMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -216,13 +216,13 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, doubleThreatMoves.size() - 1);
             auto chosenMove = doubleThreatMoves[dis(gen)];
 
-            log("\nSelected double-threat move: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n"
+            log("\nSelected double-threat move: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -234,10 +234,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // OPTIMIZATION LEVEL 4: Block opponent double threats (fork prevention)
     if (optimizationLevel >= 4) {
         char opponentMark = (playerMark == 'X') ? 'O' : 'X';
-        std::vector<std::pair<int, int>> blockForkMoves;
+        std::vector<Cell> blockForkMoves;
 
         for (const auto& move : availableMoves) {
-            if (countWinningFollowUps(boardCopy, move.first, move.second, opponentMark, availableMoves) >= 2) {
+            if (countWinningFollowUps(boardCopy, move.x(), move.y(), opponentMark, availableMoves) >= 2) {
                 blockForkMoves.push_back(move);
             }
         }
@@ -250,7 +250,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Opponent fork-blocking moves found: " + std::to_string(blockForkMoves.size()) + "\n";
                 for (const auto& move : blockForkMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -259,13 +259,13 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, blockForkMoves.size() - 1);
             auto chosenMove = blockForkMoves[dis(gen)];
 
-            log("\nSelected fork-blocking move: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n"
+            log("\nSelected fork-blocking move: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -278,10 +278,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // A second-order double threat creates >= 2 open-3 sequences simultaneously.
     // The opponent can block at most one, so the other becomes a first-order double threat.
     if (optimizationLevel >= 5) {
-        std::vector<std::pair<int, int>> doubleOpenThreeMoves;
+        std::vector<Cell> doubleOpenThreeMoves;
 
         for (const auto& move : availableMoves) {
-            if (AIUtils::countOpenThreesAtPosition(boardCopy, move.first, move.second, playerMark) >= 2) {
+            if (AIUtils::countOpenThreesAtPosition(boardCopy, move.x(), move.y(), playerMark) >= 2) {
                 doubleOpenThreeMoves.push_back(move);
             }
         }
@@ -294,7 +294,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Second-order double-threat moves found: " + std::to_string(doubleOpenThreeMoves.size()) + "\n";
                 for (const auto& move : doubleOpenThreeMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -303,13 +303,13 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, doubleOpenThreeMoves.size() - 1);
             auto chosenMove = doubleOpenThreeMoves[dis(gen)];
 
-            log("\nSelected second-order double-threat move: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n"
+            log("\nSelected second-order double-threat move: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -321,10 +321,10 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     // OPTIMIZATION LEVEL 6: Block opponent second-order double threats
     if (optimizationLevel >= 6) {
         char opponentMark = (playerMark == 'X') ? 'O' : 'X';
-        std::vector<std::pair<int, int>> blockDoubleOpenThreeMoves;
+        std::vector<Cell> blockDoubleOpenThreeMoves;
 
         for (const auto& move : availableMoves) {
-            if (AIUtils::countOpenThreesAtPosition(boardCopy, move.first, move.second, opponentMark) >= 2) {
+            if (AIUtils::countOpenThreesAtPosition(boardCopy, move.x(), move.y(), opponentMark) >= 2) {
                 blockDoubleOpenThreeMoves.push_back(move);
             }
         }
@@ -337,7 +337,7 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
                 msg += "Checked " + std::to_string(availableMoves.size()) + " available moves\n";
                 msg += "Opponent second-order double-threat blocking moves found: " + std::to_string(blockDoubleOpenThreeMoves.size()) + "\n";
                 for (const auto& move : blockDoubleOpenThreeMoves)
-                    msg += "  - (" + std::to_string(move.first) + ", " + std::to_string(move.second) + ")\n";
+                    msg += "  - (" + std::to_string(move.x()) + ", " + std::to_string(move.y()) + ")\n";
                 log(msg);
             }
 
@@ -346,13 +346,13 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
             std::uniform_int_distribution<> dis(0, blockDoubleOpenThreeMoves.size() - 1);
             auto chosenMove = blockDoubleOpenThreeMoves[dis(gen)];
 
-            log("\nSelected second-order double-threat block: (" + std::to_string(chosenMove.first) + ", " + std::to_string(chosenMove.second) + ")\n"
+            log("\nSelected second-order double-threat block: (" + std::to_string(chosenMove.x()) + ", " + std::to_string(chosenMove.y()) + ")\n"
                 "══════════════════════════════════════════════════════\n\n");
 
             availableMoves.erase(chosenMove);
-            for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-                for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-                    if (i == chosenMove.first && j == chosenMove.second) continue;
+            for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+                for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+                    if (i == chosenMove.x() && j == chosenMove.y()) continue;
                     availableMoves.insert({i, j});
                 }
             }
@@ -374,9 +374,9 @@ std::pair<int, int> SmartRandomAI::findBestMove(const TicTacToeBoard& board, cha
     availableMoves.erase(chosenMove);
 
     // Add adjacent positions
-    for (int i = chosenMove.first - 1; i <= chosenMove.first + 1; ++i) {
-        for (int j = chosenMove.second - 1; j <= chosenMove.second + 1; ++j) {
-            if (i == chosenMove.first && j == chosenMove.second) continue;
+    for (int i = chosenMove.x() - 1; i <= chosenMove.x() + 1; ++i) {
+        for (int j = chosenMove.y() - 1; j <= chosenMove.y() + 1; ++j) {
+            if (i == chosenMove.x() && j == chosenMove.y()) continue;
             availableMoves.insert({i, j});
         }
     }
@@ -18,7 +18,7 @@ class TicTacToeBoard;
 // Level 6: Block opponent second-order double threats
 class SmartRandomAI : public AIPlayer {
 private:
-    std::set<std::pair<int, int>> availableMoves;  // Maintained internally by AI
+    std::set<Cell> availableMoves;  // Maintained internally by AI
     int optimizationLevel;  // 0 = pure random, 1 = check wins, 2 = block opponent, etc.
 
     // Helper method to check if a move results in a win
@@ -29,12 +29,12 @@ private:
 
     // Returns the number of winning follow-up moves after placing at (x, y)
     int countWinningFollowUps(TicTacToeBoard& board, int x, int y, char playerMark,
-                              const std::set<std::pair<int, int>>& candidates) const;
+                              const std::set<Cell>& candidates) const;
 
 public:
     SmartRandomAI(int level = 1, bool verbose = false)
         : AIPlayer(verbose), optimizationLevel(level) {}
 
-    std::pair<int, int> findBestMove(const TicTacToeBoard& board, char playerMark,
-                                      std::pair<int, int> lastMove = {INT_MIN, INT_MIN}) override;
+    Cell findBestMove(const TicTacToeBoard& board, char playerMark,
+                      Cell lastMove = Cell::none()) override;
 };
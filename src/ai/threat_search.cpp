@@ -0,0 +1,336 @@
+// Threat Search - Victory by continuous threats (fours and open threes) for the v3 AI
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "threat_search.h"
+#include "line_classifier.h"
+#include <algorithm>
+
+namespace {
+
+// Directions of ScratchBoard's line strips, in strip order
+constexpr int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+struct Threats {
+    int wins = 0;            // Winning cells created
+    bool openThree = false;  // Stands in an open three
+};
+
+// Threats made by the stone at (x, y), read from the classified strips through it.
+// Appends the winning cells the board holds to `wins` when given. Every N-cell window through (x, y) with
+// N - 1 friendly stones and no opponent has its one empty cell as a winning cell; windows in
+// one direction can share that cell, so cells are collected as a mask per direction.
+template <typename Rule>
+Threats threatsAt(const ScratchBoard& board, int x, int y, std::vector<Cell>* wins) {
+    constexpr int N = Rule::LENGTH;
+    constexpr int C = Rule::STRIP_CENTER;
+    const char mark = board.getMark(x, y);
+    LineStrips strips;
+    LineMasks masks[4];
+    board.gatherStrips<Rule>(board.index(x, y), strips);
+    LineClassifier::classify(strips, mark, mark == 'X' ? 'O' : 'X', masks);
+
+    Threats threats;
+    for (int d = 0; d < 4; ++d) {
+        const LineMasks& m = masks[d];
+        unsigned winMask = 0;
+        for (int offset = 0; offset < N; ++offset) {
+            const int start = C - offset;
+            if (LineClassifier::windowCount<Rule>(m.opponent, start) != 0) continue;
+            const int friendly = LineClassifier::windowCount<Rule>(m.friendly, start);
+            if (friendly == N - 1) {
+                winMask |= m.empty & (static_cast<unsigned>(Rule::WINDOW_MASK) << start);
+            } else if (friendly == N - 2 && !LineClassifier::bitSet(m.opponent, start - 1) &&
+                       !LineClassifier::bitSet(m.opponent, start + N)) {
+                threats.openThree = true;
+            }
+        }
+        threats.wins += std::popcount(winMask);
+        for (; wins && winMask; winMask &= winMask - 1) {
+            const int i = std::countr_zero(winMask) - C;
+            const Cell cell(x + i * DIRECTIONS[d][0], y + i * DIRECTIONS[d][1]);
+            if (board.reaches(cell.x(), cell.y())) wins->push_back(cell);
+        }
+    }
+    return threats;
+}
+
+// Threats `mark` would make at the empty cell (x, y)
+template <typename Rule>
+Threats threatsIf(ScratchBoard& board, Cell cell, char mark) {
+    board.placeMarkDirect(cell.x(), cell.y(), mark);
+    const Threats threats = threatsAt<Rule>(board, cell.x(), cell.y(), nullptr);
+    board.removeMarkDirect(cell.x(), cell.y());
+    return threats;
+}
+
+// Hash of a stone, XORed into the line hash (splitmix64 finaliser)
+std::uint64_t stoneHash(Cell cell, bool attacker) {
+    std::uint64_t h = cell.packed() + (attacker ? 0x9E3779B97F4A7C15ull : 0);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+void sortUnique(std::pmr::vector<Cell>& cells) {
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+}
+
+} // namespace
+
+template <typename Rule>
+ThreatSearch::Result ThreatSearch::search(ScratchBoard& scratch, char attackerMark,
+                                          const std::pmr::set<Cell>& candidates,
+                                          std::pmr::memory_resource* resource) {
+    board = &scratch;
+    rootMoves = &candidates;
+    memory = resource;
+    attacker = attackerMark;
+    defender = attackerMark == 'X' ? 'O' : 'X';
+    nodes = 0;
+    exhausted = false;
+    attackerStones.clear();
+    defenderStones.clear();
+    attackerWins.clear();
+    defenderWins.clear();
+    undoSizes.clear();
+    line.clear();
+    lineHash = 0;
+    std::pmr::unordered_map<std::uint64_t, int> refutedNodes(memory);
+    refuted = &refutedNodes;
+    pv.resize(2 * maxThreats + 2);
+
+    // The defender's fours are counter-threats wherever they are, so the ones available at the
+    // root are found once by scanning the lines of every defender stone
+    std::pmr::vector<Cell> stones(memory);
+    board->forEachStone([&](int x, int y, char mark) {
+        if (mark == defender) stones.emplace_back(x, y);
+    });
+    rootCounters.clear();
+    for (const Cell& cell : lineCells(stones, Rule::LENGTH - 1)) {
+        if (threatsIf<Rule>(*board, cell, defender).wins > 0) rootCounters.push_back(cell);
+    }
+
+    // A line found on an earlier move is usually still winning after the expected reply, so
+    // its threats are tried first at the root
+    std::vector<Cell>& previous = previousLines[attacker == 'X' ? 0 : 1];
+
+    // Deepen one threat at a time, so that the shortest win is found (and, on the next move,
+    // found again) before the budget goes into long lines that fail
+    Result result;
+    result.outcome = Outcome::NONE;
+    for (int threats = 1; threats <= maxThreats && !exhausted; ++threats) {
+        if (attack<Rule>(0, threats)) {
+            result.outcome = Outcome::WIN;
+            result.move = pv[0].front();
+            line = pv[0];
+            break;
+        }
+    }
+    if (exhausted && result.outcome != Outcome::WIN) result.outcome = Outcome::UNKNOWN;
+    previous = line;
+    refuted = nullptr;
+    result.nodes = nodes;
+    return result;
+}
+
+// Attacker to move: a threat that wins against every defence
+template <typename Rule>
+bool ThreatSearch::attack(int ply, int threatsLeft) {
+    if (nodes >= nodeLimit) {
+        exhausted = true;
+        return false;
+    }
+
+    const auto defenderThreats = liveCells(defenderWins);
+    if (defenderThreats.size() >= 2 || threatsLeft == 0) return false;
+    if (ply > 0) {
+        const auto known = refuted->find(nodeKey());
+        if (known != refuted->end() && known->second >= threatsLeft) return false;
+    }
+
+    std::pmr::vector<Cell> moves(memory);
+    if (defenderThreats.size() == 1) {
+        // A four has to be blocked, whether or not the block is a threat itself
+        moves.push_back(defenderThreats[0]);
+    } else {
+        std::pmr::vector<Cell> cells = ply == 0
+            ? std::pmr::vector<Cell>(rootMoves->begin(), rootMoves->end(), memory)
+            : lineCells(recentThreats(), Rule::LENGTH - 1);
+
+        // Fours before threes: they leave the defender a single answer. At the root the
+        // threats of the previous winning line come first.
+        const std::vector<Cell>& previous = previousLines[attacker == 'X' ? 0 : 1];
+        std::pmr::vector<std::pair<int, Cell>> ranked(memory);
+        for (const Cell& cell : cells) {
+            const Threats threats = threatsIf<Rule>(*board, cell, attacker);
+            if (threats.wins == 0 && !threats.openThree) continue;
+            const bool hinted = ply == 0 && std::find(previous.begin(), previous.end(), cell) != previous.end();
+            ranked.emplace_back(hinted ? -Rule::LENGTH * 2 : -threats.wins, cell);
+        }
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [order, cell] : ranked) moves.push_back(cell);
+    }
+
+    for (const Cell& move : moves) {
+        play<Rule>(move, attacker);
+        const bool wins = defend<Rule>(ply + 1, threatsLeft - 1);
+        undo(attacker);
+        if (wins) {
+            recordPv(ply, move);
+            return true;
+        }
+        if (exhausted) return false;
+    }
+    if (ply > 0) {
+        int& known = (*refuted)[nodeKey()];
+        known = std::max(known, threatsLeft);
+    }
+    return false;
+}
+
+// Defender to move: true if every defence loses
+template <typename Rule>
+bool ThreatSearch::defend(int ply, int threatsLeft) {
+    if (nodes >= nodeLimit) {
+        exhausted = true;
+        return false;
+    }
+    if (!liveCells(defenderWins).empty()) return false;  // The defender wins first
+
+    const auto attackerThreats = liveCells(attackerWins);
+    if (attackerThreats.size() >= 2) {
+        pv[ply].clear();
+        return true;
+    }
+
+    std::pmr::vector<Cell> replies(memory);
+    if (attackerThreats.size() == 1) {
+        replies.push_back(attackerThreats[0]);
+    } else {
+        if (threatsLeft == 0) return false;
+
+        // The three's threat: attacker moves that would make two winning cells. Only taking
+        // such a cell or one of the winning cells it would make can stop it.
+        std::pmr::vector<Cell> decisive(memory);
+        std::pmr::vector<Cell> costCells(memory);
+        for (const Cell& cell : lineCells(recentThreats(), Rule::LENGTH - 1)) {
+            board->placeMarkDirect(cell.x(), cell.y(), attacker);
+            scratchWins.clear();
+            if (threatsAt<Rule>(*board, cell.x(), cell.y(), &scratchWins).wins >= 2) {
+                decisive.push_back(cell);
+                costCells.push_back(cell);
+                costCells.insert(costCells.end(), scratchWins.begin(), scratchWins.end());
+            }
+            board->removeMarkDirect(cell.x(), cell.y());
+        }
+        if (decisive.empty()) return false;  // Not forcing
+
+        // Defence set: the cost cells that leave none of them decisive
+        sortUnique(costCells);
+        for (const Cell& cell : costCells) {
+            board->placeMarkDirect(cell.x(), cell.y(), defender);
+            const bool defends = std::none_of(decisive.begin(), decisive.end(), [&](const Cell& threat) {
+                return threat != cell && threatsIf<Rule>(*board, threat, attacker).wins >= 2;
+            });
+            board->removeMarkDirect(cell.x(), cell.y());
+            if (defends) replies.push_back(cell);
+        }
+
+        // Counter-threats: every four the defender can make
+        for (const Cell& cell : rootCounters) {
+            if (!board->isPositionOccupied(cell.x(), cell.y()) &&
+                threatsIf<Rule>(*board, cell, defender).wins > 0) {
+                replies.push_back(cell);
+            }
+        }
+        for (const Cell& cell : lineCells(defenderStones, Rule::LENGTH - 1)) {
+            if (threatsIf<Rule>(*board, cell, defender).wins > 0) replies.push_back(cell);
+        }
+        sortUnique(replies);
+    }
+
+    for (std::size_t i = 0; i < replies.size(); ++i) {
+        play<Rule>(replies[i], defender);
+        const bool lost = attack<Rule>(ply + 1, threatsLeft);
+        undo(defender);
+        if (!lost) return false;
+        if (i == 0) recordPv(ply, replies[0]);
+    }
+    if (replies.empty()) pv[ply].clear();
+    return true;
+}
+
+template <typename Rule>
+void ThreatSearch::play(Cell cell, char mark) {
+    std::vector<Cell>& wins = mark == attacker ? attackerWins : defenderWins;
+    undoSizes.push_back(wins.size());
+    (mark == attacker ? attackerStones : defenderStones).push_back(cell);
+    board->placeMarkDirect(cell.x(), cell.y(), mark);
+    threatsAt<Rule>(*board, cell.x(), cell.y(), &wins);
+    lineHash ^= stoneHash(cell, mark == attacker);
+    nodes++;
+}
+
+void ThreatSearch::undo(char mark) {
+    std::vector<Cell>& stones = mark == attacker ? attackerStones : defenderStones;
+    (mark == attacker ? attackerWins : defenderWins).resize(undoSizes.back());
+    undoSizes.pop_back();
+    lineHash ^= stoneHash(stones.back(), mark == attacker);
+    board->removeMarkDirect(stones.back().x(), stones.back().y());
+    stones.pop_back();
+}
+
+std::span<const Cell> ThreatSearch::recentThreats() const {
+    const std::size_t count = std::min<std::size_t>(attackerStones.size(), RECENT_THREATS);
+    return {attackerStones.data() + attackerStones.size() - count, count};
+}
+
+std::uint64_t ThreatSearch::nodeKey() const {
+    std::uint64_t key = lineHash;
+    for (const Cell& anchor : recentThreats()) key += stoneHash(anchor, true) * 0x2545F4914F6CDD1Dull;
+    return key;
+}
+
+std::pmr::vector<Cell> ThreatSearch::liveCells(const std::vector<Cell>& wins) const {
+    std::pmr::vector<Cell> live(memory);
+    for (const Cell& cell : wins) {
+        if (!board->isPositionOccupied(cell.x(), cell.y())) live.push_back(cell);
+    }
+    sortUnique(live);
+    return live;
+}
+
+template <typename Anchors>
+std::pmr::vector<Cell> ThreatSearch::lineCells(const Anchors& anchors, int radius) const {
+    std::pmr::vector<Cell> cells(memory);
+    for (const Cell& anchor : anchors) {
+        for (const auto& direction : DIRECTIONS) {
+            for (int i = -radius; i <= radius; ++i) {
+                const Cell cell = anchor.offset(i * direction[0], i * direction[1]);
+                if (i != 0 && board->reaches(cell.x(), cell.y()) && !board->isPositionOccupied(cell.x(), cell.y())) {
+                    cells.push_back(cell);
+                }
+            }
+        }
+    }
+    sortUnique(cells);
+    return cells;
+}
+
+// Row `ply` of the PV becomes `move` followed by the line below it
+void ThreatSearch::recordPv(int ply, Cell move) {
+    pv[ply].assign(1, move);
+    pv[ply].insert(pv[ply].end(), pv[ply + 1].begin(), pv[ply + 1].end());
+}
+
+#define THREAT_SEARCH_INSTANTIATE(N) \
+    template ThreatSearch::Result ThreatSearch::search<WinRule<N>>( \
+        ScratchBoard&, char, const std::pmr::set<Cell>&, std::pmr::memory_resource*);
+THREAT_SEARCH_INSTANTIATE(4)
+THREAT_SEARCH_INSTANTIATE(5)
+THREAT_SEARCH_INSTANTIATE(6)
+THREAT_SEARCH_INSTANTIATE(7)
+#undef THREAT_SEARCH_INSTANTIATE
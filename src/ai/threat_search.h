@@ -0,0 +1,103 @@
+// Threat Search - Victory by continuous threats (fours and open threes) for the v3 AI
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "scratch_board.h"
+#include <memory_resource>
+#include <cstdint>
+#include <set>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Threat-space search for a VCT: a line of attacker moves, each a four or an open three, that
+// wins whatever the defender answers. It runs as an AND/OR tree on the scratch board:
+//   - Attacker nodes only try threat moves (a four, or an open three as in AIUtils). After the
+//     first threat a move must lie on a line through one of the attacker's last
+//     RECENT_THREATS stones, so every threat depends on the ones just before it and the tree
+//     stays narrow. The threat a defender faces is looked for on the same lines.
+//   - Defender nodes only try the defence set: the cell of a four, or against a three every
+//     cell after which the attacker has no move left that makes two winning cells; plus the
+//     defender's own fours, which the attacker has to answer before going on.
+//   - Independent threats are often played in another order, so attacker nodes that failed are
+//     remembered by the stones of their line (and the recent threats) and not searched twice.
+// Threats are judged by actual winning cells (empty cells completing N in a row), not by
+// pattern shapes, and a win is reported only once every defence has been refuted. Limiting
+// the attacker's moves can miss a win but never reports a false one.
+//
+// The search expects neither side to have a winning cell at the root (priorities 1 and 2 run
+// first). It deepens by one threat at a time, up to a maximum number of threats in a line,
+// within a node budget; a search that runs out of budget answers UNKNOWN rather than NONE.
+class ThreatSearch {
+public:
+    static constexpr int DEFAULT_MAX_THREATS = 5;       // Attacker moves in a line
+    static constexpr int RECENT_THREATS = 2;             // Attacker stones the next threat depends on
+    static constexpr long long DEFAULT_NODE_LIMIT = 1000;  // Moves made in the tree per search
+
+    enum class Outcome {
+        NONE,     // No VCT within the threat limit (the search was complete)
+        WIN,      // The attacker wins by continuous threats
+        UNKNOWN   // Node budget exhausted before an answer
+    };
+
+    struct Result {
+        Outcome outcome = Outcome::NONE;
+        Cell move = Cell::none();  // First threat of the winning line
+        long long nodes = 0;
+    };
+
+    void setLimits(int threats, long long nodes) { maxThreats = threats; nodeLimit = nodes; }
+
+    // Search for a VCT by `attacker` on `board` (left as it was found). rootMoves are the
+    // candidate cells for the first threat; transient containers come from `memory`.
+    // Instantiated for WinRule<4> to WinRule<7>.
+    template <typename Rule>
+    Result search(ScratchBoard& board, char attacker, const std::pmr::set<Cell>& rootMoves,
+                  std::pmr::memory_resource* memory);
+
+    // The winning line of the last search: attacker and defender moves alternating
+    const std::vector<Cell>& getLine() const { return line; }
+
+private:
+    int maxThreats = DEFAULT_MAX_THREATS;
+    long long nodeLimit = DEFAULT_NODE_LIMIT;
+
+    // State of one search
+    ScratchBoard* board = nullptr;
+    const std::pmr::set<Cell>* rootMoves = nullptr;
+    std::pmr::memory_resource* memory = nullptr;
+    char attacker = 'X', defender = 'O';
+    long long nodes = 0;
+    bool exhausted = false;
+    std::vector<Cell> attackerStones;  // Stones played by each side in the current line
+    std::vector<Cell> defenderStones;
+    std::vector<Cell> attackerWins;    // Winning cells those stones created (stale once occupied)
+    std::vector<Cell> defenderWins;
+    std::vector<Cell> rootCounters;    // Cells where the defender could make a four at the root
+    std::vector<std::size_t> undoSizes;  // Size of the mover's win list before each move
+    std::vector<Cell> scratchWins;
+    std::vector<std::vector<Cell>> pv;  // Row p: the winning line from ply p
+    std::vector<Cell> line;
+    std::vector<Cell> previousLines[2];  // Last winning line of X and O, tried first next time
+    std::uint64_t lineHash = 0;          // Hash of the stones played in the current line
+    // Attacker nodes without a win, by line hash: the most threats that were not enough
+    std::pmr::unordered_map<std::uint64_t, int>* refuted = nullptr;
+
+    template <typename Rule> bool attack(int ply, int threatsLeft);
+    template <typename Rule> bool defend(int ply, int threatsLeft);
+    template <typename Rule> void play(Cell cell, char mark);
+    void undo(char mark);
+    // Unoccupied cells of `wins`, without duplicates
+    std::pmr::vector<Cell> liveCells(const std::vector<Cell>& wins) const;
+    // Empty cells within `radius` of `anchors` along the four lines that the board holds,
+    // without duplicates
+    template <typename Anchors>
+    std::pmr::vector<Cell> lineCells(const Anchors& anchors, int radius) const;
+    // The attacker's last RECENT_THREATS stones in the line, and the key of the node
+    std::span<const Cell> recentThreats() const;
+    std::uint64_t nodeKey() const;
+    void recordPv(int ply, Cell move);
+};
@@ -0,0 +1,66 @@
+// Time Manager - Per-move time allocation and iterative deepening for timed games
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "time_manager.h"
+#include <algorithm>
+#include <cstring>
+
+TimeManager::Limits TimeManager::forClock(const GameClock& clock) {
+    const double remaining = std::max(0.0, clock.remainingMs);
+    Limits result;
+    result.maxMs = remaining * MAX_SHARE;
+    result.targetMs = std::min(result.maxMs, remaining / MOVES_TO_GO + clock.incrementMs * 0.75);
+    result.maxMs = std::min(result.maxMs, result.targetMs * MAX_STRETCH);
+    return result;
+}
+
+TimeManager::Limits TimeManager::forBudget(double budgetMs) {
+    return {budgetMs * BUDGET_TARGET, budgetMs};
+}
+
+double TimeManager::getElapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TimeManager::begin(const Limits& moveLimits) {
+    limits = moveLimits;
+    start = std::chrono::steady_clock::now();
+    softMs = limits.targetMs;
+    lastIterationMs = 0.0;
+    depthReached = 0;
+    bestMove = Cell::none();
+    bestScore = 0;
+    stableIterations = 0;
+    finished = false;
+}
+
+void TimeManager::iterationDone(Cell move, const SearchAnalysis& analysis, double iterationMs) {
+    lastIterationMs = iterationMs;
+
+    // Stages before minimax do not depend on the depth
+    const bool searched = std::strcmp(analysis.stage, "minimax") == 0 || std::strcmp(analysis.stage, "cache") == 0;
+    if (!searched || analysis.score >= WIN_SCORE) {
+        finished = true;
+        return;
+    }
+
+    double scale = 1.0;
+    if (!bestMove.isNone() && move != bestMove) {
+        stableIterations = 0;
+        scale = 1.6;
+    } else if (++stableIterations >= 2) {
+        scale = 0.6;
+    }
+    if (!bestMove.isNone() && analysis.score < bestScore - SCORE_DROP) scale *= 1.5;
+
+    softMs = std::min(limits.maxMs, limits.targetMs * scale);
+    bestMove = move;
+    bestScore = analysis.score;
+}
+
+bool TimeManager::shouldDeepen() const {
+    if (finished) return false;
+    const double projected = getElapsedMs() + lastIterationMs * ITERATION_GROWTH;
+    return projected <= softMs && projected <= limits.maxMs;
+}
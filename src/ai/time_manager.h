@@ -0,0 +1,98 @@
+// Time Manager - Per-move time allocation and iterative deepening for timed games
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "cell.h"
+#include "ai_utils.h"
+#include <chrono>
+
+class TicTacToeBoard;
+
+// A player's game clock: time left and the increment added after each move
+struct GameClock {
+    double remainingMs = 0.0;
+    double incrementMs = 0.0;
+
+    // Charge a move's thinking time, then add the increment (unless the flag fell)
+    void consume(double ms) {
+        remainingMs -= ms;
+        if (remainingMs >= 0.0) remainingMs += incrementMs;
+    }
+    bool flagged() const { return remainingMs < 0.0; }
+};
+
+// Decides how long a v2/v3 engine thinks about a move, by deepening it one ply at a time and
+// stopping before an iteration that would not fit.
+//
+// Each move gets a target and a hard maximum (from the game clock or a fixed budget). After
+// every iteration the target is rescaled:
+//   - a move decided by a tactical stage (win, forced block, open-4 ...) is final: deeper
+//     searches return the same move, so the search stops at once
+//   - a proven win also stops it
+//   - the best move changing between iterations, or the score dropping (a threat showed up
+//     deeper), stretches the target towards the maximum
+//   - a best move that survived the last two iterations shrinks it
+// An iteration is started only if the previous one, grown by ITERATION_GROWTH, still fits.
+class TimeManager {
+public:
+    static constexpr double ITERATION_GROWTH = 4.0;   // Assumed cost of a depth relative to the one before
+    static constexpr double MOVES_TO_GO = 25.0;       // Moves the remaining clock is spread over
+    static constexpr double MAX_SHARE = 0.25;         // Most of the remaining clock one move may take
+    static constexpr double MAX_STRETCH = 4.0;        // Maximum relative to the target
+    static constexpr double BUDGET_TARGET = 0.5;      // Target share of a fixed per-move budget
+    static constexpr int SCORE_DROP = 200;            // Score loss between iterations treated as a threat
+    static constexpr int WIN_SCORE = 1000000;         // HybridEngine's score for a win
+
+    struct Limits {
+        double targetMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    // Limits for a move played on a game clock, or under a fixed per-move budget
+    static Limits forClock(const GameClock& clock);
+    static Limits forBudget(double budgetMs);
+
+    // Deepen `engine` (HybridEvaluatorAIv2/v3) from depth 1 to maxDepth within the limits and
+    // return the move of the deepest completed iteration. The engine is left at maxDepth.
+    template <typename Engine>
+    Cell search(Engine& engine, const TicTacToeBoard& board, char playerMark, Cell lastMove,
+                int maxDepth, const Limits& limits);
+
+    // Deepest iteration completed by the last search
+    int getDepthReached() const { return depthReached; }
+    double getElapsedMs() const;
+
+private:
+    Limits limits;
+    std::chrono::steady_clock::time_point start;
+    double softMs = 0.0;          // Current target after rescaling
+    double lastIterationMs = 0.0;
+    int depthReached = 0;
+    Cell bestMove = Cell::none();
+    int bestScore = 0;
+    int stableIterations = 0;     // Iterations in a row that kept the best move
+    bool finished = false;        // Nothing deeper can change the move
+
+    void begin(const Limits& moveLimits);
+    void iterationDone(Cell move, const SearchAnalysis& analysis, double iterationMs);
+    bool shouldDeepen() const;
+};
+
+template <typename Engine>
+Cell TimeManager::search(Engine& engine, const TicTacToeBoard& board, char playerMark, Cell lastMove,
+                         int maxDepth, const Limits& moveLimits) {
+    begin(moveLimits);
+    Cell move = Cell::none();
+    for (int depth = 1; depth <= maxDepth && (depth == 1 || shouldDeepen()); ++depth) {
+        engine.setDepth(depth);
+        const auto iterationStart = std::chrono::steady_clock::now();
+        move = engine.findBestMove(board, playerMark, lastMove);
+        iterationDone(move, engine.getLastAnalysis(), std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - iterationStart).count());
+        depthReached = depth;
+    }
+    engine.setDepth(maxDepth);
+    return move;
+}
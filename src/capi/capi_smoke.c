@@ -0,0 +1,97 @@
+/* InfiniTTT C API smoke test - Drives libinfinittt from C the way an embedder would
+ * SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+#include "infinittt.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define EXPECT(condition)                                                    \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+static void testBoard(void) {
+    ittt_board* board = ittt_board_create();
+    EXPECT(board != NULL);
+
+    /* X takes four of a row, O answers elsewhere */
+    const int32_t moves[] = {0, 0, 5, 5, 1, 0, 5, 6, 2, 0, 5, 7, 3, 0, 6, 5};
+    EXPECT(ittt_board_apply(board, moves, 8) == ITTT_OK);
+    EXPECT(ittt_board_stone_count(board) == 8);
+    EXPECT(ittt_board_get(board, 2, 0) == 'X');
+    EXPECT(ittt_board_get(board, 5, 6) == 'O');
+    EXPECT(ittt_board_side_to_move(board) == 'X');
+    EXPECT(ittt_board_winner(board) == 0);
+
+    /* Rejected calls leave the board as it was */
+    const int32_t occupied[] = {9, 9, 0, 0};
+    EXPECT(ittt_board_apply(board, occupied, 2) == ITTT_ERROR_OCCUPIED);
+    const int32_t noMove[] = {ITTT_NO_MOVE, ITTT_NO_MOVE};
+    EXPECT(ittt_board_apply(board, noMove, 1) == ITTT_ERROR_ARGUMENT);
+    const int32_t farAway[] = {9, 9, ITTT_MAX_COORDINATE + 1, 0};
+    EXPECT(ittt_board_apply(board, farAway, 2) == ITTT_ERROR_ARGUMENT);
+    const int32_t edge[] = {-ITTT_MAX_COORDINATE, ITTT_MAX_COORDINATE};
+    EXPECT(ittt_board_apply(board, edge, 1) == ITTT_OK);
+    EXPECT(ittt_board_stone_count(board) == 9);
+    EXPECT(ittt_board_side_to_move(board) == 'O');
+
+    /* O blocks at one end, X completes five at the other */
+    const int32_t finish[] = {-1, 0, 4, 0};
+    EXPECT(ittt_board_apply(board, finish, 2) == ITTT_OK);
+    EXPECT(ittt_board_winner(board) == 'X');
+
+    EXPECT(ittt_board_apply(NULL, moves, 1) == ITTT_ERROR_ARGUMENT);
+    ittt_board_destroy(board);
+}
+
+static void testEngine(int model) {
+    ittt_engine* engine = ittt_engine_create(model, 2, 6);
+    EXPECT(engine != NULL);
+
+    /* X to move with four in a row must complete it */
+    ittt_board* board = ittt_board_create();
+    const int32_t moves[] = {0, 0, 0, 5, 1, 0, 1, 5, 2, 0, 2, 5, 3, 0, -1, 0};
+    EXPECT(ittt_board_apply(board, moves, 8) == ITTT_OK);
+    int32_t move[2];
+    EXPECT(ittt_engine_best_move(engine, board, move, NULL) == ITTT_OK);
+    EXPECT(move[0] == 4 && move[1] == 0);
+    ittt_board_destroy(board);
+
+    /* Batch: the same game after six and eight moves, then two invalid positions */
+    const int32_t batch[] = {0, 0, 0, 5, 1, 0, 1, 5, 2, 0, 2, 5,
+                             0, 0, 0, 5, 1, 0, 1, 5, 2, 0, 2, 5, 3, 0, -1, 0,
+                             0, 0, 0, 0,
+                             ITTT_NO_MOVE, ITTT_NO_MOVE};
+    const size_t offsets[] = {0, 6, 14, 16, 17};
+    int32_t outMoves[8];
+    int32_t outScores[4];
+    EXPECT(ittt_engine_best_moves(engine, batch, offsets, 4, outMoves, outScores) == ITTT_ERROR_POSITION);
+    EXPECT(outMoves[2] == 4 && outMoves[3] == 0);
+    EXPECT(outMoves[4] == ITTT_NO_MOVE && outMoves[5] == ITTT_NO_MOVE && outScores[2] == 0);
+    EXPECT(outMoves[6] == ITTT_NO_MOVE && outMoves[7] == ITTT_NO_MOVE && outScores[3] == 0);
+
+    ittt_engine_destroy(engine);
+}
+
+int main(void) {
+    EXPECT(ittt_api_version() == ITTT_API_VERSION);
+    EXPECT(ittt_engine_create(42, 2, 6) == NULL);
+    testBoard();
+    testEngine(ITTT_MODEL_V1);
+    testEngine(ITTT_MODEL_V2);
+    testEngine(ITTT_MODEL_V3);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("C API smoke test passed\n");
+    return 0;
+}
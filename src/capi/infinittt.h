@@ -0,0 +1,101 @@
+/* InfiniTTT C API - Embeddable boards and engines behind a stable C ABI
+ * SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+
+#ifndef INFINITTT_H
+#define INFINITTT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Exported from libinfinittt; everything else in the library is hidden */
+#if defined(_WIN32)
+#  ifdef INFINITTT_BUILDING_LIBRARY
+#    define ITTT_API __declspec(dllexport)
+#  else
+#    define ITTT_API __declspec(dllimport)
+#  endif
+#else
+#  define ITTT_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a declaration below changes incompatibly */
+#define ITTT_API_VERSION 1
+
+/* Status codes */
+#define ITTT_OK                 0
+#define ITTT_ERROR_ARGUMENT    -1  /* Null handle or buffer, or a value out of range */
+#define ITTT_ERROR_OCCUPIED    -2  /* A move lands on a stone (the call changed nothing) */
+#define ITTT_ERROR_POSITION    -3  /* Some batch positions were invalid (see ittt_engine_best_moves) */
+#define ITTT_ERROR_INTERNAL    -4  /* Out of memory or another failure inside the engine */
+
+/* Engine models, as in the CLI */
+#define ITTT_MODEL_RANDOM 0
+#define ITTT_MODEL_V1     1
+#define ITTT_MODEL_V2     2
+#define ITTT_MODEL_V3     3
+
+/* Coordinate written for "no move" */
+#define ITTT_NO_MOVE INT32_MIN
+
+/* Moves passed in must have |x| and |y| at most this (so never ITTT_NO_MOVE) */
+#define ITTT_MAX_COORDINATE 1000000000
+
+/* Coordinates are passed as interleaved arrays: x0, y0, x1, y1, ... Moves alternate X, O,
+ * X, ... from the first move of a position.
+ *
+ * Handles are not thread-safe: use one engine (and its boards) per thread. Separate handles
+ * may be used concurrently. */
+typedef struct ittt_board ittt_board;
+typedef struct ittt_engine ittt_engine;
+
+ITTT_API int ittt_api_version(void);
+
+/* Boards */
+ITTT_API ittt_board* ittt_board_create(void);
+ITTT_API void ittt_board_destroy(ittt_board* board);
+ITTT_API void ittt_board_clear(ittt_board* board);
+/* Play `count` moves, alternating from the side to move. Either all of them are played or,
+ * if one lands on a stone, none (ITTT_ERROR_OCCUPIED). A coordinate beyond
+ * ITTT_MAX_COORDINATE plays none of them (ITTT_ERROR_ARGUMENT). */
+ITTT_API int ittt_board_apply(ittt_board* board, const int32_t* moves, size_t count);
+/* 'X', 'O' or 0 for an empty cell */
+ITTT_API char ittt_board_get(const ittt_board* board, int32_t x, int32_t y);
+ITTT_API size_t ittt_board_stone_count(const ittt_board* board);
+ITTT_API char ittt_board_side_to_move(const ittt_board* board);
+/* 'X' or 'O' once a move completed five in a row, else 0 */
+ITTT_API char ittt_board_winner(const ittt_board* board);
+
+/* Engines: depth and topn apply to ITTT_MODEL_V2/V3 and are ignored by the others.
+ * Returns NULL for an unknown model or depth/topn below 1. */
+ITTT_API ittt_engine* ittt_engine_create(int model, int depth, int topn);
+ITTT_API void ittt_engine_destroy(ittt_engine* engine);
+
+/* Best move for the side to move on `board`, written to out_move[0..1]. out_score (may be
+ * NULL) receives the search score for the mover: the minimax value, +-1000000 for a forced
+ * win or loss, 0 for models without a search score. */
+ITTT_API int ittt_engine_best_move(ittt_engine* engine, const ittt_board* board,
+                                   int32_t* out_move, int32_t* out_score);
+
+/* Best move and score for each of `count` positions in one call.
+ * Position i is the moves moves[2 * offsets[i]] .. moves[2 * offsets[i + 1] - 1], so offsets
+ * holds count + 1 non-decreasing move indices starting at 0. Results go to
+ * out_moves[2 * i], out_moves[2 * i + 1] and out_scores[i] (out_scores may be NULL).
+ *
+ * A position that repeats a cell or has a coordinate beyond ITTT_MAX_COORDINATE gets
+ * ITTT_NO_MOVE and score 0, the rest are still analysed, and the call returns
+ * ITTT_ERROR_POSITION. Consecutive positions that share leading moves
+ * (the plies of one game) only replay the moves that differ. */
+ITTT_API int ittt_engine_best_moves(ittt_engine* engine, const int32_t* moves, const size_t* offsets,
+                                    size_t count, int32_t* out_moves, int32_t* out_scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFINITTT_H */
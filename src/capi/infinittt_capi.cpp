@@ -0,0 +1,232 @@
+// InfiniTTT C API - Handles and batch queries over the core library
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "infinittt.h"
+#include "tictactoeboard.h"
+#include "winrule.h"
+#include "src/ai/aiplayer.h"
+#include "src/ai/smart_random_ai.h"
+#include "src/ai/hybrid_evaluator_ai.h"
+#include "src/ai/hybrid_evaluator_ai_v2.h"
+#include "src/ai/hybrid_evaluator_ai_v3.h"
+#include <memory>
+#include <new>
+#include <vector>
+
+static_assert(ITTT_MAX_COORDINATE == Cell::MAX_COORDINATE);
+
+struct ittt_board {
+    TicTacToeBoard board;
+    Cell lastMove = Cell::none();
+    char winner = 0;
+};
+
+struct ittt_engine {
+    std::unique_ptr<AIPlayer> ai;
+    const SearchAnalysis* analysis = nullptr;  // v2/v3 only: the engine's last result
+    // Random and v1 carry their candidate moves from one call to the next, which only holds
+    // while they follow a single game; they are recreated for every query instead
+    std::unique_ptr<AIPlayer> (*restart)() = nullptr;
+
+    // Batch queries replay positions on this board; `placed` mirrors its moves in order
+    TicTacToeBoard scratch;
+    std::vector<Cell> placed;
+};
+
+namespace {
+
+char markOfPly(std::size_t ply) {
+    return ply % 2 == 0 ? 'X' : 'O';
+}
+
+// No exception may cross the C boundary
+template <typename Fn>
+int guarded(Fn&& fn) {
+    try {
+        return fn();
+    } catch (...) {
+        return ITTT_ERROR_INTERNAL;
+    }
+}
+
+int searchMove(ittt_engine& engine, const TicTacToeBoard& board, char side, Cell lastMove,
+               int32_t* outMove, int32_t* outScore) {
+    if (engine.restart) {
+        engine.ai = engine.restart();
+        lastMove = Cell::none();  // Candidates then come from the whole board
+    }
+    const Cell move = engine.ai->findBestMove(board, side, lastMove);
+    outMove[0] = move.x();
+    outMove[1] = move.y();
+    if (outScore) *outScore = engine.analysis ? engine.analysis->score : 0;
+    return ITTT_OK;
+}
+
+// Interleaved coordinates inside +-Cell::MAX_COORDINATE (so none is ITTT_NO_MOVE either)
+bool playable(const int32_t* moves, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!Cell::isPlayable(moves[2 * i], moves[2 * i + 1])) return false;
+    }
+    return true;
+}
+
+// Bring the scratch board to the given moves, undoing and replaying only past the shared prefix.
+// False if the moves repeat a cell (the board then holds the moves before the repeat).
+bool replay(ittt_engine& engine, const int32_t* moves, std::size_t count) {
+    std::size_t common = 0;
+    while (common < count && common < engine.placed.size() &&
+           engine.placed[common] == Cell(moves[2 * common], moves[2 * common + 1])) {
+        common++;
+    }
+    while (engine.placed.size() > common) {
+        const Cell cell = engine.placed.back();
+        engine.scratch.removeMarkDirect(cell.x(), cell.y());
+        engine.placed.pop_back();
+    }
+    for (std::size_t i = common; i < count; ++i) {
+        const int x = moves[2 * i], y = moves[2 * i + 1];
+        if (engine.scratch.isPositionOccupied(x, y)) return false;
+        engine.scratch.placeMarkDirect(x, y, markOfPly(i));
+        engine.placed.push_back({x, y});
+    }
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+int ittt_api_version(void) {
+    return ITTT_API_VERSION;
+}
+
+ittt_board* ittt_board_create(void) {
+    return new (std::nothrow) ittt_board();
+}
+
+void ittt_board_destroy(ittt_board* board) {
+    delete board;
+}
+
+void ittt_board_clear(ittt_board* board) {
+    if (!board) return;
+    board->board = TicTacToeBoard();
+    board->lastMove = Cell::none();
+    board->winner = 0;
+}
+
+int ittt_board_apply(ittt_board* board, const int32_t* moves, size_t count) {
+    if (!board || (!moves && count > 0) || (count > 0 && !playable(moves, count))) return ITTT_ERROR_ARGUMENT;
+    return guarded([&] {
+        TicTacToeBoard& b = board->board;
+        const char firstSide = b.getCurrentPlayer();
+        for (std::size_t i = 0; i < count; ++i) {
+            const int x = moves[2 * i], y = moves[2 * i + 1];
+            if (b.isPositionOccupied(x, y)) {
+                for (std::size_t j = i; j-- > 0;) b.removeMarkDirect(moves[2 * j], moves[2 * j + 1]);
+                b.setCurrentPlayer(firstSide);
+                return ITTT_ERROR_OCCUPIED;
+            }
+            b.placeMarkDirect(x, y, b.getCurrentPlayer());
+            b.setCurrentPlayer(b.getCurrentPlayer() == 'X' ? 'O' : 'X');
+        }
+
+        // Only a move of this call can have completed a line the board did not have before
+        for (std::size_t i = 0; i < count && !board->winner; ++i) {
+            const int x = moves[2 * i], y = moves[2 * i + 1];
+            if (b.checkWinQuiet(x, y, StandardWinRule::LENGTH)) board->winner = b.getMark(x, y);
+        }
+        if (count > 0) board->lastMove = {moves[2 * count - 2], moves[2 * count - 1]};
+        return ITTT_OK;
+    });
+}
+
+char ittt_board_get(const ittt_board* board, int32_t x, int32_t y) {
+    return board ? board->board.getMark(x, y) : 0;
+}
+
+size_t ittt_board_stone_count(const ittt_board* board) {
+    return board ? board->board.getOccupiedPositions().size() : 0;
+}
+
+char ittt_board_side_to_move(const ittt_board* board) {
+    return board ? board->board.getCurrentPlayer() : 0;
+}
+
+char ittt_board_winner(const ittt_board* board) {
+    return board ? board->winner : 0;
+}
+
+ittt_engine* ittt_engine_create(int model, int depth, int topn) {
+    if (depth < 1 || topn < 1) return nullptr;
+    try {
+        auto engine = std::make_unique<ittt_engine>();
+        switch (model) {
+            case ITTT_MODEL_RANDOM:
+                engine->restart = []() -> std::unique_ptr<AIPlayer> { return std::make_unique<SmartRandomAI>(2, false); };
+                break;
+            case ITTT_MODEL_V1:
+                engine->restart = []() -> std::unique_ptr<AIPlayer> { return std::make_unique<HybridEvaluatorAI>(nullptr, false); };
+                break;
+            case ITTT_MODEL_V2: {
+                auto ai = std::make_unique<HybridEvaluatorAIv2>(nullptr, depth, topn, true, false, false);
+                engine->analysis = &ai->getLastAnalysis();
+                engine->ai = std::move(ai);
+                break;
+            }
+            case ITTT_MODEL_V3: {
+                auto ai = std::make_unique<HybridEvaluatorAIv3>(nullptr, depth, topn, true, false, false);
+                engine->analysis = &ai->getLastAnalysis();
+                engine->ai = std::move(ai);
+                break;
+            }
+            default:
+                return nullptr;
+        }
+        return engine.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void ittt_engine_destroy(ittt_engine* engine) {
+    delete engine;
+}
+
+int ittt_engine_best_move(ittt_engine* engine, const ittt_board* board, int32_t* out_move, int32_t* out_score) {
+    if (!engine || !board || !out_move) return ITTT_ERROR_ARGUMENT;
+    return guarded([&] {
+        return searchMove(*engine, board->board, board->board.getCurrentPlayer(), board->lastMove,
+                          out_move, out_score);
+    });
+}
+
+int ittt_engine_best_moves(ittt_engine* engine, const int32_t* moves, const size_t* offsets,
+                           size_t count, int32_t* out_moves, int32_t* out_scores) {
+    if (!engine || !offsets || !out_moves || (!moves && count > 0 && offsets[count] > 0)) return ITTT_ERROR_ARGUMENT;
+    if (offsets[0] != 0) return ITTT_ERROR_ARGUMENT;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (offsets[i + 1] < offsets[i]) return ITTT_ERROR_ARGUMENT;
+    }
+
+    return guarded([&] {
+        int status = ITTT_OK;
+        for (std::size_t i = 0; i < count; ++i) {
+            const int32_t* position = moves + 2 * offsets[i];
+            const std::size_t length = offsets[i + 1] - offsets[i];
+            if (!playable(position, length) || !replay(*engine, position, length)) {
+                out_moves[2 * i] = out_moves[2 * i + 1] = ITTT_NO_MOVE;
+                if (out_scores) out_scores[i] = 0;
+                status = ITTT_ERROR_POSITION;
+                continue;
+            }
+            const Cell lastMove = length > 0 ? engine->placed.back() : Cell::none();
+            searchMove(*engine, engine->scratch, markOfPly(length), lastMove,
+                       out_moves + 2 * i, out_scores ? out_scores + i : nullptr);
+        }
+        return status;
+    });
+}
+
+} // extern "C"
@@ -7,17 +7,27 @@
 #include "hybrid_evaluator_ai.h"
 #include "hybrid_evaluator_ai_v2.h"
 #include "hybrid_evaluator_ai_v3.h"
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <QDir>
 #include <QFile>
+#include <QStandardPaths>
 
 GameController::GameController(QObject* parent)
     : QObject(parent) {
+    // Without a writable data directory the AIs simply search every position
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!dataDir.isEmpty() && QDir().mkpath(dataDir)) {
+        analysisCache_.open((dataDir + "/analysis_cache.bin").toStdString(), ANALYSIS_CACHE_BYTES);
+    }
 }
 
 GameController::~GameController() = default;
 
 void GameController::startNewGameQML(bool p1Human, int p1AIType, int p1Level,
-                                     bool p2Human, int p2AIType, int p2Level) {
+                                     bool p2Human, int p2AIType, int p2Level,
+                                     int aiClockSeconds, int aiIncrementSeconds) {
     GameConfig config;
     config.player1.isHuman = p1Human;
     config.player1.aiType = static_cast<AIType>(p1AIType);
@@ -25,6 +35,8 @@ void GameController::startNewGameQML(bool p1Human, int p1AIType, int p1Level,
     config.player2.isHuman = p2Human;
     config.player2.aiType = static_cast<AIType>(p2AIType);
     config.player2.smartRandomLevel = p2Level;
+    config.aiClockMs = aiClockSeconds * 1000;
+    config.aiIncrementMs = aiIncrementSeconds * 1000;
     startNewGame(config);
 }
 
@@ -57,18 +69,21 @@ void GameController::startNewGame(const GameConfig& config) {
     board_ = TicTacToeBoard();
     currentPlayer_ = 'X';
     gameActive_ = true;
-    lastMove_ = {INT_MIN, INT_MIN};
+    lastMove_ = Cell::none();
     moveCount_ = 0;
     moveHistory_.clear();
 
     player1AI_.reset();
     player2AI_.reset();
+    player1Timed_ = nullptr;
+    player2Timed_ = nullptr;
     weights1_.reset();
     weights2_.reset();
+    for (GameClock& clock : clocks_) clock = {double(config_.aiClockMs), double(config_.aiIncrementMs)};
 
     if (!config_.player1.isHuman) {
         weights1_ = loadWeightsForAI(config_.player1.aiType);
-        player1AI_ = createAIPlayer(config_.player1, weights1_.get());
+        player1AI_ = createAIPlayer(config_.player1, weights1_.get(), player1Timed_);
         player1AI_->setMessageCallback([this](const std::string& msg) {
             emit aiMessage('X', QString::fromStdString(msg));
         });
@@ -76,7 +91,7 @@ void GameController::startNewGame(const GameConfig& config) {
 
     if (!config_.player2.isHuman) {
         weights2_ = loadWeightsForAI(config_.player2.aiType);
-        player2AI_ = createAIPlayer(config_.player2, weights2_.get());
+        player2AI_ = createAIPlayer(config_.player2, weights2_.get(), player2Timed_);
         player2AI_->setMessageCallback([this](const std::string& msg) {
             emit aiMessage('O', QString::fromStdString(msg));
         });
@@ -135,7 +150,30 @@ void GameController::executeAIMove() {
         return;
     }
 
-    auto [moveX, moveY] = currentAI->findBestMove(board_, currentPlayer_, lastMove_);
+    const TimedSearch& timedSearch = (currentPlayer_ == 'X') ? player1Timed_ : player2Timed_;
+    Cell move;
+    if (config_.aiClockMs > 0) {
+        // Timed game: the AI's clock runs while it thinks
+        GameClock& clock = clocks_[currentPlayer_ == 'X' ? 0 : 1];
+        auto start = std::chrono::steady_clock::now();
+        move = timedSearch ? timedSearch(TimeManager::forClock(clock))
+                           : currentAI->findBestMove(board_, currentPlayer_, lastMove_);
+        clock.consume(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (timedSearch) {
+            emit aiMessage(currentPlayer_, QString("Depth %1, %2 s left on the clock\n")
+                                               .arg(timeManager_.getDepthReached())
+                                               .arg(std::max(0.0, clock.remainingMs) / 1000.0, 0, 'f', 1));
+        }
+        if (clock.flagged()) {
+            gameActive_ = false;
+            emit aiThinking(false);
+            emit gameOver(currentPlayer_ == 'X' ? 'O' : 'X');  // Lost on time
+            return;
+        }
+    } else {
+        move = currentAI->findBestMove(board_, currentPlayer_, lastMove_);
+    }
+    auto [moveX, moveY] = move;
 
     board_.placeMark(moveX, moveY);
     moveHistory_.emplace_back(moveX, moveY, currentPlayer_);
@@ -163,7 +201,7 @@ void GameController::undoMove() {
         const auto& [lx, ly, lm] = moveHistory_.back();
         lastMove_ = {lx, ly};
     } else {
-        lastMove_ = {INT_MIN, INT_MIN};
+        lastMove_ = Cell::none();
     }
 
     emit moveUndone();
@@ -199,16 +237,33 @@ void GameController::switchTurn() {
     }
 }
 
-std::unique_ptr<AIPlayer> GameController::createAIPlayer(const PlayerConfig& playerConfig, const EvaluationWeights* weights) {
+std::unique_ptr<AIPlayer> GameController::createAIPlayer(const PlayerConfig& playerConfig, const EvaluationWeights* weights,
+                                                         TimedSearch& timedSearch) {
+    // In a timed game v2/v3 deepen under the time manager instead of searching a fixed depth
+    auto timed = [this](auto* engine) -> TimedSearch {
+        if (config_.aiClockMs <= 0) return nullptr;
+        return [this, engine](const TimeManager::Limits& limits) {
+            return timeManager_.search(*engine, board_, currentPlayer_, lastMove_, TIMED_MAX_DEPTH, limits);
+        };
+    };
+
     switch (playerConfig.aiType) {
         case AIType::SMART_RANDOM:
             return std::make_unique<SmartRandomAI>(playerConfig.smartRandomLevel, false);
         case AIType::HYBRID_EVALUATOR:
             return std::make_unique<HybridEvaluatorAI>(weights, false);
-        case AIType::HYBRID_EVALUATOR_V2:
-            return std::make_unique<HybridEvaluatorAIv2>(weights, 2, 10, true, false, false);
-        case AIType::HYBRID_EVALUATOR_V3:
-            return std::make_unique<HybridEvaluatorAIv3>(weights, 2, 10, true, false, false);
+        case AIType::HYBRID_EVALUATOR_V2: {
+            auto ai = std::make_unique<HybridEvaluatorAIv2>(weights, 2, 10, true, false, false);
+            if (analysisCache_.isOpen()) ai->setAnalysisCache(&analysisCache_);
+            timedSearch = timed(ai.get());
+            return ai;
+        }
+        case AIType::HYBRID_EVALUATOR_V3: {
+            auto ai = std::make_unique<HybridEvaluatorAIv3>(weights, 2, 10, true, false, false);
+            if (analysisCache_.isOpen()) ai->setAnalysisCache(&analysisCache_);
+            timedSearch = timed(ai.get());
+            return ai;
+        }
         default:
             return std::make_unique<SmartRandomAI>(playerConfig.smartRandomLevel, false);
     }
@@ -8,6 +8,7 @@
 #include <QTimer>
 #include <QString>
 #include <QVariantList>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <tuple>
@@ -15,6 +16,8 @@
 #include "ai_types.h"
 #include "aiplayer.h"
 #include "evaluationweights.h"
+#include "analysis_cache.h"
+#include "time_manager.h"
 
 struct PlayerConfig {
     bool isHuman = true;
@@ -25,6 +28,8 @@ struct PlayerConfig {
 struct GameConfig {
     PlayerConfig player1;
     PlayerConfig player2;
+    int aiClockMs = 0;      // Game clock of each AI player (0: untimed, v2/v3 search depth 2)
+    int aiIncrementMs = 0;  // Added to an AI's clock after each of its moves
 };
 
 class GameController : public QObject {
@@ -45,7 +50,8 @@ public:
 
     // QML-friendly interface
     Q_INVOKABLE void startNewGameQML(bool p1Human, int p1AIType, int p1Level,
-                                     bool p2Human, int p2AIType, int p2Level);
+                                     bool p2Human, int p2AIType, int p2Level,
+                                     int aiClockSeconds = 0, int aiIncrementSeconds = 0);
     Q_INVOKABLE QVariantList getMoveHistoryQML() const;
 
     // Weight file configuration
@@ -72,7 +78,9 @@ private slots:
 private:
     void checkGameState(int lastX, int lastY);
     void switchTurn();
-    std::unique_ptr<AIPlayer> createAIPlayer(const PlayerConfig& playerConfig, const EvaluationWeights* weights);
+    using TimedSearch = std::function<Cell(const TimeManager::Limits&)>;
+    std::unique_ptr<AIPlayer> createAIPlayer(const PlayerConfig& playerConfig, const EvaluationWeights* weights,
+                                             TimedSearch& timedSearch);
     std::unique_ptr<EvaluationWeights> loadWeightsForAI(AIType type);
     QString getWeightFilename(AIType type) const;
 
@@ -83,14 +91,21 @@ private:
     std::unique_ptr<AIPlayer> player2AI_;
     std::unique_ptr<EvaluationWeights> weights1_;
     std::unique_ptr<EvaluationWeights> weights2_;
+    TimedSearch player1Timed_;  // v2/v3 deepening under the time manager (timed games only)
+    TimedSearch player2Timed_;
+    TimeManager timeManager_;
+    GameClock clocks_[2];       // AI clocks of X and O in a timed game
+    AnalysisCache analysisCache_;  // v2/v3 results kept across games and app runs (if it opens)
 
     std::vector<std::tuple<int,int,char>> moveHistory_;
     char currentPlayer_ = 'X';
     bool gameActive_ = false;
-    std::pair<int, int> lastMove_ = {INT_MIN, INT_MIN};
+    Cell lastMove_ = Cell::none();
     int moveCount_ = 0;
     static constexpr int WIN_LENGTH = 5;
     static constexpr int MAX_MOVES = 1000;
+    static constexpr int TIMED_MAX_DEPTH = 6;  // Deepest v2/v3 iteration in a timed game
+    static constexpr std::size_t ANALYSIS_CACHE_BYTES = std::size_t(16) << 20;
 
     // Weight files are always loaded from bundled Qt resources
     QString hybridWeightsPath_   = ":/weights/hybrid_evaluator_weights.txt";
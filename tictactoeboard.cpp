@@ -66,6 +66,70 @@ bool TicTacToeBoard::checkWinFromPosition(int x, int y, int length, char mark) c
     return false;
 }
 
+// Same check for a compile-time win length: each half-line stops after N - 1 cells,
+// so the walk is bounded and the loops unroll
+template <typename Rule>
+bool TicTacToeBoard::checkWinFromPosition(int x, int y, char mark) const
+{
+    const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+    for (const auto& dir : directions) {
+        int totalCount = 1;
+        for (int i = 1; i < Rule::LENGTH && getMark(x + i * dir[0], y + i * dir[1]) == mark; ++i) {
+            totalCount++;
+        }
+        for (int i = 1; i < Rule::LENGTH && getMark(x - i * dir[0], y - i * dir[1]) == mark; ++i) {
+            totalCount++;
+        }
+        if (totalCount >= Rule::LENGTH) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Listeners stay with the board being assigned to and are told that its contents changed
+TicTacToeBoard& TicTacToeBoard::operator=(const TicTacToeBoard& other)
+{
+    board = other.board;
+    currentPlayer = other.currentPlayer;
+    for (const auto& l : listeners) l.reset(l.listener, *this);
+    return *this;
+}
+
+TicTacToeBoard::~TicTacToeBoard()
+{
+    for (const auto& l : listeners) l.detach(l.listener);
+}
+
+void TicTacToeBoard::unsubscribe(const void* listener) const
+{
+    std::erase_if(listeners, [listener](const ListenerSlot& l) { return l.listener == listener; });
+}
+
+void TicTacToeBoard::placeMarkDirect(int x, int y, char mark)
+{
+    auto [it, inserted] = board.try_emplace({x, y}, mark);
+    if (!inserted) {
+        // Overwriting a stone: report it as a removal followed by a placement
+        char previous = it->second;
+        board.erase(it);
+        notifyRemove({x, y}, previous);
+        board.emplace(Cell(x, y), mark);
+    }
+    notifyPlace({x, y}, mark);
+}
+
+void TicTacToeBoard::removeMarkDirect(int x, int y)
+{
+    auto it = board.find({x, y});
+    if (it == board.end()) return;
+    char mark = it->second;
+    board.erase(it);
+    notifyRemove({x, y}, mark);
+}
 
     // Place a mark on the board at a given position
 bool TicTacToeBoard::placeMark ( int x, int y )
@@ -74,6 +138,7 @@ bool TicTacToeBoard::placeMark ( int x, int y )
             return false;
         }
         board[{x, y}] = currentPlayer;
+        notifyPlace({x, y}, currentPlayer);
         currentPlayer = (currentPlayer == 'X') ? 'O' : 'X';
         return true;
 }
@@ -89,10 +154,10 @@ void TicTacToeBoard::printBoard ( int range ) const
 
     int minX = 0, maxX = 0, minY = 0, maxY = 0;
     for (const auto& [pos, mark] : board) {
-        minX = std::min(minX, pos.first);
-        maxX = std::max(maxX, pos.first);
-        minY = std::min(minY, pos.second);
-        maxY = std::max(maxY, pos.second);
+        minX = std::min(minX, pos.x());
+        maxX = std::max(maxX, pos.x());
+        minY = std::min(minY, pos.y());
+        maxY = std::max(maxY, pos.y());
     }
 
     // Adjust range based on the spread of the marks
@@ -141,7 +206,10 @@ bool TicTacToeBoard::checkWin ( int x, int y, int length ) const
     char mark = board.at({x, y});
 
     // Check if the last move is part of a winning sequence
-    if (checkWinFromPosition(x, y, length, mark)) {
+    bool won = isSupportedWinLength(length)
+        ? withWinRule(length, [&](auto rule) { return checkWinFromPosition<decltype(rule)>(x, y, mark); })
+        : checkWinFromPosition(x, y, length, mark);
+    if (won) {
         std::cout << "Player " << mark << " wins!\n";
         return true;
     }
@@ -160,8 +228,32 @@ bool TicTacToeBoard::checkWinQuiet ( int x, int y, int length ) const
     char mark = board.at({x, y});
 
     // Check if the last move is part of a winning sequence
+    if (isSupportedWinLength(length)) {
+        return withWinRule(length, [&](auto rule) { return checkWinFromPosition<decltype(rule)>(x, y, mark); });
+    }
     return checkWinFromPosition(x, y, length, mark);
 }
 
+    // The neighbours are counted from (x, y) whether or not a mark is there
+bool TicTacToeBoard::completesLine ( int x, int y, char mark, int length ) const
+{
+    if (isSupportedWinLength(length)) {
+        return withWinRule(length, [&](auto rule) { return checkWinFromPosition<decltype(rule)>(x, y, mark); });
+    }
+    return checkWinFromPosition(x, y, length, mark);
+}
+
+template <typename Rule>
+bool TicTacToeBoard::checkWinQuiet(int x, int y) const
+{
+    char mark = getMark(x, y);
+    return mark != '\0' && checkWinFromPosition<Rule>(x, y, mark);
+}
+
+template bool TicTacToeBoard::checkWinQuiet<WinRule<4>>(int, int) const;
+template bool TicTacToeBoard::checkWinQuiet<WinRule<5>>(int, int) const;
+template bool TicTacToeBoard::checkWinQuiet<WinRule<6>>(int, int) const;
+template bool TicTacToeBoard::checkWinQuiet<WinRule<7>>(int, int) const;
+
     // Evaluate board position by counting potential winning sequences
     // Returns a score based on the number and quality of sequences, including gapped patterns
@@ -5,30 +5,92 @@
 
 #pragma once
 
+#include "cell.h"
+#include "winrule.h"
 #include <map>
-#include <utility>
+#include <vector>
 
+// Change listeners
+// Derived structures (move frontiers, hashes, threat maps, GUI mirrors) subscribe to a board and
+// are told about every change instead of re-deriving it from getOccupiedPositions(). A listener
+// is any type with these members; there is no base class, subscribe() instantiates one small
+// thunk per listener type that calls them directly:
+//   void onPlace(const TicTacToeBoard& board, Cell cell, char mark);   // after the mark is placed
+//   void onRemove(const TicTacToeBoard& board, Cell cell, char mark);  // after the mark is removed
+//   void onReset(const TicTacToeBoard& board);  // contents replaced wholesale (assignment)
+//   void onDetach();                            // board destroyed; drop any pointer to it
+// Copies of a board start with no listeners, so scratch copies made by the AIs stay silent.
+// Subscribing does not change the board's contents, so it is allowed on a const board.
 class TicTacToeBoard {
 private:
-    std::map<std::pair<int, int>, char> board;
+    struct ListenerSlot {
+        void* listener;
+        void (*place)(void*, const TicTacToeBoard&, Cell, char);
+        void (*remove)(void*, const TicTacToeBoard&, Cell, char);
+        void (*reset)(void*, const TicTacToeBoard&);
+        void (*detach)(void*);
+    };
+
+    std::map<Cell, char> board;
     char currentPlayer;
+    mutable std::vector<ListenerSlot> listeners;
+
+    void notifyPlace(Cell cell, char mark) const {
+        for (const auto& l : listeners) l.place(l.listener, *this, cell, mark);
+    }
+    void notifyRemove(Cell cell, char mark) const {
+        for (const auto& l : listeners) l.remove(l.listener, *this, cell, mark);
+    }
 
     bool checkDirection(int x, int y, int dx, int dy, int length, char mark) const;
     int countConsecutive(int x, int y, int dx, int dy, char mark) const;
     bool checkWinFromPosition(int x, int y, int length, char mark) const;
+    template <typename Rule>
+    bool checkWinFromPosition(int x, int y, char mark) const;
 
 public:
     TicTacToeBoard() : currentPlayer('X') {}
+    TicTacToeBoard(const TicTacToeBoard& other) : board(other.board), currentPlayer(other.currentPlayer) {}
+    TicTacToeBoard& operator=(const TicTacToeBoard& other);
+    ~TicTacToeBoard();
     bool placeMark(int x, int y);
     void printBoard(int range = 3) const;
     bool checkWin(int x, int y, int length) const;
     bool checkWinQuiet(int x, int y, int length) const;
+    // Win check with the length fixed at compile time (instantiated for WinRule<4> to WinRule<7>)
+    template <typename Rule>
+    bool checkWinQuiet(int x, int y) const;
+    // Whether `mark` on the empty cell (x, y) would complete `length` in a row. The board is
+    // only read, so its listeners hear nothing.
+    bool completesLine(int x, int y, char mark, int length) const;
 
     // Helper methods for AI
-    const std::map<std::pair<int, int>, char>& getOccupiedPositions() const { return board; }
+    const std::map<Cell, char>& getOccupiedPositions() const { return board; }
     bool isPositionOccupied(int x, int y) const { return board.count({x, y}) > 0; }
-    void placeMarkDirect(int x, int y, char mark) { board[{x, y}] = mark; }
-    void removeMarkDirect(int x, int y) { board.erase({x, y}); }
+    bool isPositionOccupied(Cell cell) const { return board.count(cell) > 0; }
+    char getMark(int x, int y) const {  // '\0' for an empty cell
+        auto it = board.find({x, y});
+        return it == board.end() ? '\0' : it->second;
+    }
+    void placeMarkDirect(int x, int y, char mark);
+    void removeMarkDirect(int x, int y);
+    // Visit every stone as fn(x, y, mark), in Cell order
+    template <typename Fn>
+    void forEachStone(Fn fn) const {
+        for (const auto& [cell, mark] : board) fn(cell.x(), cell.y(), mark);
+    }
     char getCurrentPlayer() const { return currentPlayer; }
     void setCurrentPlayer(char player) { currentPlayer = player; }
+
+    // Listener registration (see the comment above the class)
+    template <typename Listener>
+    void subscribe(Listener& listener) const {
+        listeners.push_back({
+            &listener,
+            [](void* l, const TicTacToeBoard& b, Cell c, char m) { static_cast<Listener*>(l)->onPlace(b, c, m); },
+            [](void* l, const TicTacToeBoard& b, Cell c, char m) { static_cast<Listener*>(l)->onRemove(b, c, m); },
+            [](void* l, const TicTacToeBoard& b) { static_cast<Listener*>(l)->onReset(b); },
+            [](void* l) { static_cast<Listener*>(l)->onDetach(); }});
+    }
+    void unsubscribe(const void* listener) const;
 };
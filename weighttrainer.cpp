@@ -6,6 +6,7 @@
 #include "weighttrainer.h"
 #include "src/ai/hybrid_evaluator_ai.h"
 #include "src/ai/hybrid_evaluator_ai_v2.h"
+#include "metricsexporter.h"
 #include <iostream>
 #include <algorithm>
 #include <atomic>
@@ -29,7 +30,7 @@ std::unique_ptr<AIPlayer> WeightTrainer::createTrainingAI(const EvaluationWeight
 // Returns: 1 if weights1 wins, -1 if weights2 wins, 0 for draw
 int WeightTrainer::playSilentGame(const EvaluationWeights& weights1,
                                    const EvaluationWeights& weights2,
-                                   int maxMoves, bool player1First) {
+                                   int maxMoves, bool player1First, int* movesPlayed) {
     TicTacToeBoard board;
     auto ai1 = createTrainingAI(weights1);
     auto ai2 = createTrainingAI(weights2);
@@ -37,36 +38,49 @@ int WeightTrainer::playSilentGame(const EvaluationWeights& weights1,
     char player1Mark = player1First ? 'X' : 'O';
     char player2Mark = player1First ? 'O' : 'X';
 
-    std::pair<int, int> lastMove = {INT_MIN, INT_MIN};
+    Cell lastMove = Cell::none();
     int moveCount = 0;
+    int result = 0;  // Draw unless someone wins
 
     while (moveCount < maxMoves) {
         // Player 1's turn
         auto move1 = ai1->findBestMove(board, player1Mark, lastMove);
-        board.placeMarkDirect(move1.first, move1.second, player1Mark);
+        board.placeMarkDirect(move1.x(), move1.y(), player1Mark);
         lastMove = move1;
         moveCount++;
 
         // Check if player 1 won
-        if (board.checkWinQuiet(move1.first, move1.second, 5)) {
-            return 1;  // weights1 wins
+        if (board.checkWinQuiet(move1.x(), move1.y(), 5)) {
+            result = 1;  // weights1 wins
+            break;
         }
 
         if (moveCount >= maxMoves) break;
 
         // Player 2's turn
         auto move2 = ai2->findBestMove(board, player2Mark, lastMove);
-        board.placeMarkDirect(move2.first, move2.second, player2Mark);
+        board.placeMarkDirect(move2.x(), move2.y(), player2Mark);
         lastMove = move2;
         moveCount++;
 
         // Check if player 2 won
-        if (board.checkWinQuiet(move2.first, move2.second, 5)) {
-            return -1;  // weights2 wins
+        if (board.checkWinQuiet(move2.x(), move2.y(), 5)) {
+            result = -1;  // weights2 wins
+            break;
         }
     }
 
-    return 0;  // Draw
+    if (metrics) {
+        for (const AIPlayer* ai : {ai1.get(), ai2.get()}) {
+            if (const auto* engine = dynamic_cast<const HybridEvaluatorAIv2*>(ai)) {
+                const SearchArena& arena = engine->getSearchArena();
+                metrics->addArena(arena.overflowBytes(), arena.overflowAllocations(), arena.capacity());
+            }
+        }
+    }
+
+    if (movesPlayed) *movesPlayed = moveCount;
+    return result;
 }
 
 // Run a round-robin tournament where each candidate plays against every other
@@ -94,23 +108,39 @@ void WeightTrainer::runTournament(std::vector<WeightCandidate>& population) {
 
     std::atomic<size_t> nextIdx{0};
     std::atomic<size_t> completedCount{0};
+    std::atomic<long long> totalMoves{0};
     std::mutex printMutex;
 
-    auto worker = [&]() {
+    // Per-thread busy time — each worker writes only its own slot
+    std::vector<double> busySeconds(numThreads, 0.0);
+
+    auto worker = [&](int threadIdx) {
         size_t idx;
         while ((idx = nextIdx.fetch_add(1, std::memory_order_relaxed)) < totalMatchups) {
+            auto busyStart = std::chrono::steady_clock::now();
             const Matchup& m = matchups[idx];
             MatchupResult& r = results[idx];
+            long long matchupMoves = 0;
             for (int game = 0; game < gamesPerMatchup; ++game) {
+                int moves = 0;
+                if (metrics) metrics->beginBusy(threadIdx);
                 int result = playSilentGame(population[m.i].weights,
                                            population[m.j].weights,
-                                           maxMoves, game % 2 == 0);
+                                           maxMoves, game % 2 == 0, &moves);
+                if (metrics) {
+                    metrics->endBusy(threadIdx);
+                    metrics->addGame(moves);
+                }
                 if (result == 1)       ++r.iWins;
                 else if (result == -1) ++r.jWins;
                 else                   ++r.draws;
+                matchupMoves += moves;
             }
+            totalMoves.fetch_add(matchupMoves, std::memory_order_relaxed);
+            busySeconds[threadIdx] += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - busyStart).count();
             size_t done = completedCount.fetch_add(1, std::memory_order_relaxed) + 1;
-            if (done % dotInterval == 0) {
+            if (showProgress && done % dotInterval == 0) {
                 std::lock_guard<std::mutex> lock(printMutex);
                 std::cout << ".";
                 std::cout.flush();
@@ -118,13 +148,21 @@ void WeightTrainer::runTournament(std::vector<WeightCandidate>& population) {
         }
     };
 
+    auto wallStart = std::chrono::steady_clock::now();
     std::vector<std::thread> threads;
     threads.reserve(numThreads);
     for (int t = 0; t < numThreads; ++t)
-        threads.emplace_back(worker);
+        threads.emplace_back(worker, t);
     for (auto& t : threads)
         t.join();
 
+    lastStats.numThreads = numThreads;
+    lastStats.gamesPlayed = static_cast<int>(totalMatchups) * gamesPerMatchup;
+    lastStats.movesPlayed = totalMoves.load();
+    lastStats.wallSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    lastStats.threadBusySeconds = std::move(busySeconds);
+
     // Merge results into population (single-threaded — no contention)
     for (size_t idx = 0; idx < matchups.size(); ++idx) {
         size_t i = matchups[idx].i, j = matchups[idx].j;
@@ -136,7 +174,7 @@ void WeightTrainer::runTournament(std::vector<WeightCandidate>& population) {
         population[j].losses += r.iWins;
         population[j].draws  += r.draws;
     }
-    std::cout << "\n";
+    if (showProgress) std::cout << "\n";
 }
 
 // Evolve the population using genetic algorithm
@@ -200,6 +238,7 @@ EvaluationWeights WeightTrainer::train(int generations, const EvaluationWeights&
     // Evolution loop
     for (int gen = 0; gen < generations; ++gen) {
         std::cout << "Generation " << (gen + 1) << "/" << generations << ":\n";
+        if (metrics) metrics->setGeneration(gen + 1, generations);
         std::cout << "  Running tournament";
 
         runTournament(population);
@@ -217,6 +256,7 @@ EvaluationWeights WeightTrainer::train(int generations, const EvaluationWeights&
         if (best->getFitness() > bestEverFitness) {
             bestEverFitness = best->getFitness();
             bestEver = best->weights;
+            if (metrics) metrics->setBestFitness(bestEverFitness);
             std::cout << "  *** New best fitness! ***\n";
         }
 
@@ -17,6 +17,8 @@
 #include <memory>
 #include <thread>
 
+class JobMetrics;
+
 struct WeightCandidate {
     EvaluationWeights weights;
     int wins = 0;
@@ -36,6 +38,18 @@ struct WeightCandidate {
     }
 };
 
+// Timing collected for the most recent tournament (used by the thread-scaling benchmark)
+struct TournamentStats {
+    int numThreads = 0;
+    int gamesPlayed = 0;
+    long long movesPlayed = 0;
+    double wallSeconds = 0.0;
+    std::vector<double> threadBusySeconds;  // Time each worker spent playing games
+
+    // Time each worker spent waiting (start-up, queue drain, join) rather than playing
+    double getThreadIdleSeconds(int t) const { return wallSeconds - threadBusySeconds[t]; }
+};
+
 class WeightTrainer {
 private:
     AIType trainingAIType;
@@ -44,10 +58,14 @@ private:
     int maxMoves;
     double mutationRate;
     int numThreads;
+    bool showProgress = true;
+    TournamentStats lastStats;
+    JobMetrics* metrics = nullptr;
 
     // Play a single game between two AIs (returns 1 if player1 wins, -1 if player2 wins, 0 for draw)
+    // movesPlayed (optional) receives the number of moves the game lasted
     int playSilentGame(const EvaluationWeights& weights1, const EvaluationWeights& weights2,
-                       int maxMoves, bool player1First);
+                       int maxMoves, bool player1First, int* movesPlayed = nullptr);
 
     // Create AI instance for training
     std::unique_ptr<AIPlayer> createTrainingAI(const EvaluationWeights& weights);
@@ -60,6 +78,19 @@ public:
         srand(static_cast<unsigned int>(time(nullptr)));
     }
 
+    // Worker thread count (defaults to hardware_concurrency)
+    void setNumThreads(int n) { numThreads = std::max(1, n); }
+    int getNumThreads() const { return numThreads; }
+
+    // Print progress dots while a tournament runs
+    void setShowProgress(bool show) { showProgress = show; }
+
+    // Report finished games, busy time and generations to a live exporter (nullptr turns it off)
+    void setMetrics(JobMetrics* jobMetrics) { metrics = jobMetrics; }
+
+    // Timing of the most recent runTournament call
+    const TournamentStats& getLastTournamentStats() const { return lastStats; }
+
     // Run a tournament: each candidate plays against every other candidate
     void runTournament(std::vector<WeightCandidate>& population);
 
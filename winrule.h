@@ -0,0 +1,43 @@
+// Win Rule - Compile-time description of an N-in-a-row variant
+// SPDX-FileCopyrightText: 2024 Ran Rutenberg <ran.rutenberg@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+// Everything that depends on the winning length, fixed at compile time so that the board
+// kernels and window scanners can unroll their loops and fold their bounds to constants.
+// The game is played with WinRule<5>; the 4-, 6- and 7-in-a-row variants are instantiated
+// as well and reached from a runtime length through withWinRule().
+template <int N>
+struct WinRule {
+    static_assert(N >= 4 && N <= 7, "line strips hold at most 15 cells (2 * 7 + 1)");
+
+    static constexpr int LENGTH = N;
+
+    // A line strip through a cell covers every N-cell window through it plus the cell
+    // just beyond each end; strip position STRIP_CENTER is the cell itself.
+    static constexpr int STRIP_CENTER = N;
+    static constexpr int STRIP_LENGTH = 2 * N + 1;
+    static constexpr std::uint16_t WINDOW_MASK = (1u << N) - 1;
+    static constexpr std::uint16_t CENTER_BIT = 1u << STRIP_CENTER;
+};
+
+using StandardWinRule = WinRule<5>;
+
+constexpr bool isSupportedWinLength(int length) {
+    return length >= 4 && length <= 7;
+}
+
+// Call fn(WinRule<length>{}) for a runtime win length.
+// Lengths outside isSupportedWinLength() are treated as 5; check first where that matters.
+template <typename Fn>
+decltype(auto) withWinRule(int length, Fn&& fn) {
+    switch (length) {
+        case 4: return fn(WinRule<4>{});
+        case 6: return fn(WinRule<6>{});
+        case 7: return fn(WinRule<7>{});
+        default: return fn(WinRule<5>{});
+    }
+}